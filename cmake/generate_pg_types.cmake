@@ -0,0 +1,145 @@
+# postgresql_type.csv から型カタログ (include/sqlparser/pg_type_catalog.inc) を生成する
+#   cmake -DPG_TYPE_CSV=<csv> -DPG_TYPE_CATALOG=<inc> -P generate_pg_types.cmake
+# ルートの CMakeLists.txt からはビルド時に -P で実行され、CSV が更新されると再生成される。
+# include/sqlparser/pg_type_catalog.inc (CMake を使わない場合のコピー) を更新するときも同じコマンドを使う。
+#
+# 型名列の書式 (PostgreSQL のマニュアルの表記):
+#   "[ (n) ]" "[ (p, s) ]" などの修飾子と "[ fields ]" は名前に含めない
+#   "[ without time zone ]" のような省略可能な語は、省略した名前と省略しない名前の両方を登録する
+# エイリアス列はカンマ区切りで、同じ書式に従う。
+
+# CSV の 1 行を先頭 3 列 (型名, エイリアス, 説明) に分割する ("" によるクォートに対応)
+function(pg_type_split_row line out_name out_aliases out_desc)
+    set(col 0)
+    set(field "")
+    set(in_quotes FALSE)
+    set(skip_next FALSE)
+    string(LENGTH "${line}" n)
+    math(EXPR last "${n} - 1")
+    foreach(i RANGE 0 ${last})
+        if(skip_next)
+            set(skip_next FALSE)
+            continue()
+        endif()
+        string(SUBSTRING "${line}" ${i} 1 c)
+        if(in_quotes)
+            if(c STREQUAL "\"")
+                math(EXPR j "${i} + 1")
+                string(SUBSTRING "${line}" ${j} 1 next)
+                if(next STREQUAL "\"")
+                    string(APPEND field "\"")
+                    set(skip_next TRUE)
+                else()
+                    set(in_quotes FALSE)
+                endif()
+            else()
+                string(APPEND field "${c}")
+            endif()
+        elseif(c STREQUAL "\"")
+            set(in_quotes TRUE)
+        elseif(c STREQUAL ",")
+            set(field_${col} "${field}")
+            set(field "")
+            math(EXPR col "${col} + 1")
+        else()
+            string(APPEND field "${c}")
+        endif()
+    endforeach()
+    set(field_${col} "${field}")
+    set(${out_name} "${field_0}" PARENT_SCOPE)
+    set(${out_aliases} "${field_1}" PARENT_SCOPE)
+    set(${out_desc} "${field_2}" PARENT_SCOPE)
+endfunction()
+
+# 修飾子・プレースホルダを取り除き、空白を 1 つにまとめる
+function(pg_type_strip_modifiers text out)
+    string(REGEX REPLACE "\\[ *\\([^)]*\\) *\\]" " " text "${text}")
+    string(REGEX REPLACE "\\[ *fields *\\]" " " text "${text}")
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+function(pg_type_normalize text out)
+    string(TOLOWER "${text}" text)
+    string(REGEX REPLACE "[ \t]+" " " text "${text}")
+    string(STRIP "${text}" text)
+    set(${out} "${text}" PARENT_SCOPE)
+endfunction()
+
+# 省略可能な語を展開した名前の一覧 (先頭が省略した形)
+function(pg_type_expand text out)
+    if(text MATCHES "^(.*)\\[([^]]*)\\](.*)$")
+        pg_type_normalize("${CMAKE_MATCH_1} ${CMAKE_MATCH_3}" short_name)
+        pg_type_normalize("${CMAKE_MATCH_1} ${CMAKE_MATCH_2} ${CMAKE_MATCH_3}" long_name)
+        set(${out} "${short_name}" "${long_name}" PARENT_SCOPE)
+    else()
+        pg_type_normalize("${text}" name)
+        set(${out} "${name}" PARENT_SCOPE)
+    endif()
+endfunction()
+
+if(NOT PG_TYPE_CSV OR NOT PG_TYPE_CATALOG)
+    message(FATAL_ERROR "PG_TYPE_CSV と PG_TYPE_CATALOG を指定してください")
+endif()
+
+file(STRINGS "${PG_TYPE_CSV}" pg_type_rows ENCODING UTF-8)
+list(REMOVE_AT pg_type_rows 0) # ヘッダー行
+
+set(pg_type_types "")
+set(pg_type_names "")
+set(pg_type_seen "")
+foreach(row IN LISTS pg_type_rows)
+    string(REPLACE " " " " row "${row}") # CSV 中の U+00A0 (NO-BREAK SPACE)
+    pg_type_split_row("${row}" type_col alias_col desc_col)
+    pg_type_strip_modifiers("${type_col}" type_col)
+    pg_type_expand("${type_col}" names)
+    list(LENGTH names count)
+    if(count EQUAL 0)
+        continue()
+    endif()
+    list(GET names 0 canonical)
+    if(canonical STREQUAL "")
+        continue()
+    endif()
+
+    string(TOUPPER "${canonical}" id)
+    string(REPLACE " " "_" id "${id}")
+    string(APPEND pg_type_types "SQLPARSER_PG_TYPE(${id}, L\"${canonical}\") // ${desc_col}\n")
+
+    pg_type_strip_modifiers("${alias_col}" alias_col)
+    string(REPLACE "," ";" aliases "${alias_col}")
+    foreach(alias IN LISTS aliases)
+        pg_type_expand("${alias}" alias_names)
+        list(APPEND names ${alias_names})
+    endforeach()
+    foreach(name IN LISTS names)
+        if(name STREQUAL "")
+            continue()
+        endif()
+        list(FIND pg_type_seen "${name}" seen_index)
+        if(NOT seen_index EQUAL -1)
+            message(FATAL_ERROR "${PG_TYPE_CSV}: 型名 '${name}' が重複しています")
+        endif()
+        list(APPEND pg_type_seen "${name}")
+        string(APPEND pg_type_names "SQLPARSER_PG_TYPE_NAME(${id}, L\"${name}\")\n")
+    endforeach()
+endforeach()
+
+set(pg_type_content "// このファイルは cmake/generate_pg_types.cmake が postgresql_type.csv から生成する。直接編集しないこと。
+// SQLPARSER_PG_TYPE(id, 正規名)      : 型ごとに 1 行 (TypeId の定義順)
+// SQLPARSER_PG_TYPE_NAME(id, 名前)   : 正規名・エイリアス・省略可能な語を含む綴り
+
+#ifdef SQLPARSER_PG_TYPE
+${pg_type_types}#endif
+
+#ifdef SQLPARSER_PG_TYPE_NAME
+${pg_type_names}#endif
+")
+
+# 内容が変わらない場合は書き込まない (不要な再ビルドを避ける)
+set(pg_type_old "")
+if(EXISTS "${PG_TYPE_CATALOG}")
+    file(READ "${PG_TYPE_CATALOG}" pg_type_old)
+endif()
+if(NOT pg_type_old STREQUAL pg_type_content)
+    file(WRITE "${PG_TYPE_CATALOG}" "${pg_type_content}")
+endif()
@@ -1,48 +1,36 @@
-﻿#include <iostream>
+﻿#include <chrono>
+#include <iostream>
 #include <string>
 #include <sqlparser/parser.hpp>
 #include <sqlparser/generator.hpp>
-
-// Helper: appends a "field = nIndex" condition to the WHERE clause of a SELECT
-// using the first column name (or its alias). Works on each part of a UNION.
-bool add_where_to_select(sqlparser::ast::SelectStatement& ast, long nIndex) {
-    if (ast.columns.empty()) return false;
-
-    // Use the first column expression directly as the filter condition.
-    // (Aliases cannot be referenced in WHERE since it is evaluated before SELECT.)
-    sqlparser::ast::BinaryOp eq_op;
-    eq_op.op    = sqlparser::ast::OpType::EQ;
-    eq_op.left  = ast.columns[0].expr;
-    eq_op.right = sqlparser::ast::IntLiteral(static_cast<int>(nIndex));
-
-    // AND the new condition into an existing WHERE, or set it directly.
-    if (ast.where) {
-        sqlparser::ast::BinaryOp and_op;
-        and_op.op    = sqlparser::ast::OpType::AND;
-        and_op.left  = *ast.where;
-        and_op.right = eq_op;
-        ast.where = and_op;
-    } else {
-        ast.where = eq_op;
-    }
-    return true;
+#include <sqlparser/persistent.hpp>
+#include <sqlparser/sql_template.hpp>
+
+// Produces the variant of base filtered by "first_field = nIndex" in every SELECT part
+// (including UNION branches). base is parsed once and left untouched; the variant
+// shares every node with it except the statements and predicates that were edited.
+// The first column expression is used directly as the filter field, since aliases
+// cannot be referenced in WHERE. Fails if any part has no usable first column
+// (e.g. "*", a literal or an aggregate).
+bool build_id_filter_variant(const sqlparser::ast::PersistentSelect& base, long nIndex,
+                             sqlparser::ast::PersistentSelect& out) {
+    bool ok = true;
+    out = base.update([&](sqlparser::ast::SelectStatement& ast) {
+        ok = sqlparser::ast::and_where_first_column(ast, sqlparser::ast::OpType::EQ,
+                                                    sqlparser::ast::IntLiteral(nIndex),
+                                                    sqlparser::ast::UnionScope::All);
+    });
+    return ok;
 }
 
-// Rewrites every SELECT part of src (including UNION branches) by appending
-// a "first_field = nIndex" filter, then returns the regenerated SQL.
 bool build_id_filter_sql(const std::wstring& src, long nIndex, std::wstring& out_sql) {
     sqlparser::ast::SelectStatement ast;
     if (!sqlparser::parser::parse(src, ast)) return false;
 
-    // Add condition to the main SELECT.
-    if (!add_where_to_select(ast, nIndex)) return false;
-
-    // Add the same condition to each UNION branch.
-    for (auto& u : ast.unions) {
-        if (!add_where_to_select(u.select.get(), nIndex)) return false;
-    }
+    sqlparser::ast::PersistentSelect variant;
+    if (!build_id_filter_variant(sqlparser::ast::PersistentSelect(std::move(ast)), nIndex, variant)) return false;
 
-    out_sql = sqlparser::generate(ast);
+    out_sql = sqlparser::generate(*variant);
     return true;
 }
 
@@ -105,5 +93,40 @@ int main() {
         111
     );
 
+    // --- Case 7: many tenant ids against one parsed query ---
+    std::wcout << L"=== Variants of one parse ===" << std::endl;
+    sqlparser::ast::SelectStatement parsed;
+    if (sqlparser::parser::parse(L"SELECT shape_id, name FROM shapes_a WHERE area > 50 UNION SELECT shape_id, name FROM shapes_b", parsed)) {
+        const sqlparser::ast::PersistentSelect base(std::move(parsed));
+        for (long id = 1; id <= 3; ++id) {
+            sqlparser::ast::PersistentSelect variant;
+            if (build_id_filter_variant(base, id, variant)) {
+                std::wcout << L"Tenant " << id << L" : " << sqlparser::generate(*variant) << std::endl;
+            }
+        }
+        std::wcout << L"Base     : " << sqlparser::generate(*base) << std::endl;
+    }
+
+    // --- Case 8: compiled template (parse and rewrite once, then only format the id) ---
+    std::wcout << std::endl << L"=== Compiled template ===" << std::endl;
+    const std::wstring tenant_sql = L"SELECT shape_id, name FROM shapes_a WHERE area > 50 UNION SELECT shape_id, name FROM shapes_b";
+    sqlparser::SqlTemplate tmpl;
+    if (sqlparser::compile_id_filter(tenant_sql, tmpl)) {
+        std::wstring out;
+        for (long id = 1; id <= 3; ++id) {
+            tmpl.render({ id }, out);
+            std::wcout << L"Tenant " << id << L" : " << out << std::endl;
+        }
+
+        const int calls = 10000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) build_id_filter_sql(tenant_sql, i, out);
+        auto middle = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i) tmpl.render({ i }, out);
+        auto end = std::chrono::steady_clock::now();
+        std::wcout << L"build_id_filter_sql : " << std::chrono::duration<double, std::micro>(middle - start).count() / calls << L" us/call" << std::endl;
+        std::wcout << L"SqlTemplate::render : " << std::chrono::duration<double, std::micro>(end - middle).count() / calls << L" us/call" << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
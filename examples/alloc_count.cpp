@@ -0,0 +1,75 @@
+// alloc_count.cpp
+// Counts heap allocations made while parsing a small corpus of realistic queries.
+// Usage:
+//   alloc_count.exe   -- prints the size of the main AST nodes, allocations per query for parse(), simplify() and generate(),
+//                        and the bytes held by each parsed AST (the SelectStatement itself plus its heap allocations)
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <sqlparser/parser.hpp>
+#include <sqlparser/generator.hpp>
+#include <sqlparser/simplify.hpp>
+
+static std::atomic<size_t> g_allocations{ 0 };
+static std::atomic<size_t> g_bytes{ 0 };
+
+void* operator new(std::size_t n) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    const std::vector<std::wstring> corpus = {
+        L"SELECT id, name, email FROM users WHERE (status = 'active') ORDER BY name",
+        L"SELECT u.id, u.name, o.total FROM users u INNER JOIN orders o ON (u.id = o.user_id) WHERE (o.total > 100)",
+        L"SELECT customer_id, COUNT(*) AS order_count, SUM(amount) AS total_amount FROM orders GROUP BY customer_id HAVING (COUNT(*) > 5)",
+        L"SELECT p.product_name, c.category_name FROM products p LEFT JOIN categories c ON (p.category_id = c.category_id)",
+        L"SELECT employee_id, ROW_NUMBER() OVER (PARTITION BY department_id ORDER BY salary DESC) FROM employees",
+        L"SELECT * FROM accounts a WHERE EXISTS (SELECT 1 FROM transactions t WHERE (t.account_id = a.account_id))",
+        L"SELECT CAST(created_at AS timestamp), updated_at::date FROM audit_log WHERE (event_type IN ('insert', 'update'))",
+        L"SELECT shape_id, name, area FROM shapes_a UNION ALL SELECT shape_id, name, area FROM shapes_b",
+    };
+
+    using namespace sqlparser::ast;
+    std::wcout << L"sizeof: SmallString " << sizeof(sqlparser::SmallString) << L", Identifier " << sizeof(sqlparser::Identifier)
+               << L", Expression " << sizeof(Expression) << L", IntLiteral " << sizeof(IntLiteral) << L", Table " << sizeof(Table)
+               << L", Join " << sizeof(Join) << L", SelectStatement " << sizeof(SelectStatement) << std::endl;
+
+    size_t parse_total = 0;
+    size_t bytes_total = 0;
+    size_t simplify_total = 0;
+    size_t generate_total = 0;
+    for (auto const& sql : corpus) {
+        sqlparser::ast::SelectStatement ast;
+        size_t before = g_allocations.load();
+        size_t bytes_before = g_bytes.load();
+        if (!sqlparser::parser::parse(sql, ast)) {
+            std::wcout << L"Parse failed: " << sql << std::endl;
+            return 1;
+        }
+        size_t parsed = g_allocations.load();
+        size_t bytes = sizeof(ast) + g_bytes.load() - bytes_before;
+        // nothing in the corpus simplifies, so this should not allocate
+        sqlparser::ast::simplify(ast);
+        size_t simplified = g_allocations.load();
+        std::wstring generated = sqlparser::generate(ast);
+        size_t after = g_allocations.load();
+
+        parse_total += parsed - before;
+        bytes_total += bytes;
+        simplify_total += simplified - parsed;
+        generate_total += after - simplified;
+        std::wcout << L"parse: " << (parsed - before) << L"\tsimplify: " << (simplified - parsed)
+                   << L"\tgenerate: " << (after - simplified) << L"\tbytes: " << bytes << L"\t" << sql << std::endl;
+    }
+    std::wcout << L"Total parse: " << parse_total << L", simplify: " << simplify_total << L", generate: " << generate_total
+               << L", bytes per AST: " << bytes_total / corpus.size() << L" (" << corpus.size() << L" queries)" << std::endl;
+    return 0;
+}
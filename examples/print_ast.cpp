@@ -39,15 +39,15 @@ struct AstPrinter : boost::static_visitor<void> {
                     const std::wstring& ind, bool last) const;
 
     void operator()(const sqlparser::ast::IntLiteral& v) const {
-        os << prefix() << L"IntLiteral: " << v.value << std::endl;
+        os << prefix() << L"IntLiteral: " << v.text << std::endl;
     }
 
-    void operator()(const sqlparser::String& s) const {
+    void operator()(const sqlparser::Identifier& s) const {
         os << prefix() << L"Identifier: " << s << std::endl;
     }
 
     void operator()(const sqlparser::ast::StringLiteral& s) const {
-        os << prefix() << L"StringLiteral: '" << s.value << L"'" << std::endl;
+        os << prefix() << L"StringLiteral: '" << s.text() << L"'" << std::endl;
     }
 
     void operator()(const sqlparser::ast::BinaryOp& op) const {
@@ -64,6 +64,13 @@ struct AstPrinter : boost::static_visitor<void> {
         print_expr(op.right, child_indent(), true);
     }
 
+    void operator()(const sqlparser::ast::LogicalOp& op) const {
+        os << prefix() << L"LogicalOp: " << (op.op == sqlparser::ast::OpType::OR ? L"OR" : L"AND") << std::endl;
+        for (size_t i = 0; i < op.operands.size(); ++i) {
+            print_expr(op.operands[i], child_indent(), i + 1 == op.operands.size());
+        }
+    }
+
     void operator()(const sqlparser::ast::UnaryOp& op) const {
         static const wchar_t* names[] = {
             L"=", L"<>", L">", L"<", L">=", L"<=",
@@ -116,9 +123,9 @@ struct AstPrinter : boost::static_visitor<void> {
     void operator()(const sqlparser::ast::In& in) const {
         os << prefix() << L"In" << (in.not_in ? L" [NOT]" : L"") << std::endl;
         std::wstring ci = child_indent();
-        print_expr(in.expr, ci, in.values.empty());
-        for (size_t i = 0; i < in.values.size(); ++i)
-            print_expr(in.values[i], ci, i + 1 == in.values.size());
+        print_expr(in.expr, ci, in.size() == 0);
+        for (size_t i = 0; i < in.size(); ++i)
+            print_expr(in.value_at(i), ci, i + 1 == in.size());
     }
 
     void operator()(const sqlparser::ast::Exists& e) const {
@@ -246,11 +253,19 @@ void AstPrinter::print_select(const sqlparser::ast::SelectStatement& stmt,
         if (j.type == sqlparser::ast::JoinType::LEFT)  jt = L"LEFT JOIN";
         if (j.type == sqlparser::ast::JoinType::RIGHT) jt = L"RIGHT JOIN";
         if (j.type == sqlparser::ast::JoinType::FULL)  jt = L"FULL JOIN";
-        std::wcout << ind << L"+-- " << jt << std::endl;
+        if (j.type == sqlparser::ast::JoinType::CROSS) jt = L"CROSS JOIN";
+        if (j.type == sqlparser::ast::JoinType::IMPLICIT) jt = L"IMPLICIT JOIN (,)";
+        std::wcout << ind << L"+-- " << (j.natural ? L"NATURAL " : L"") << jt << std::endl;
         print_table_ref(j.table, ind + L"|   ", false);
-        std::wcout << ind << L"|   \\-- On" << std::endl;
-        AstPrinter on_p(std::wcout, ind + L"|       ", true);
-        boost::apply_visitor(on_p, j.on);
+        if (j.on) {
+            std::wcout << ind << L"|   \\-- On" << std::endl;
+            AstPrinter on_p(std::wcout, ind + L"|       ", true);
+            boost::apply_visitor(on_p, *j.on);
+        } else if (!j.using_columns.empty()) {
+            std::wcout << ind << L"|   \\-- Using:";
+            for (const auto& c : j.using_columns) std::wcout << L" " << c;
+            std::wcout << std::endl;
+        }
     }
 
     // Where
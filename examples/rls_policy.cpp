@@ -0,0 +1,80 @@
+// rls_policy.cpp
+// Attaches row-level-security predicates to every table reference of a query
+// and measures RowSecurityPolicy::apply() on a query with many table references.
+// Usage:
+//   rls_policy.exe   -- prints a rewritten example, then apply() time and allocations
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <sqlparser/parser.hpp>
+#include <sqlparser/generator.hpp>
+#include <sqlparser/policy.hpp>
+
+static std::atomic<size_t> g_allocations{ 0 };
+
+void* operator new(std::size_t n) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// 20 joined tables per UNION branch, each branch with an EXISTS subquery and a derived table
+static std::wstring build_large_query(int branches) {
+    std::wstring sql;
+    for (int b = 0; b < branches; ++b) {
+        if (b > 0) sql += L" UNION ALL ";
+        sql += L"SELECT t0.id FROM orders t0";
+        for (int i = 1; i < 20; ++i) {
+            std::wstring alias = L"t" + std::to_wstring(i);
+            sql += (i % 3 == 0 ? L" LEFT JOIN " : L" JOIN ");
+            sql += (i % 2 == 0 ? L"customers " : L"order_items ") + alias;
+            sql += L" ON " + alias + L".ref = t" + std::to_wstring(i - 1) + L".id";
+        }
+        sql += L" JOIN (SELECT id FROM invoices) d ON d.id = t0.id";
+        sql += L" WHERE EXISTS (SELECT 1 FROM payments p WHERE p.order_id = t0.id)";
+    }
+    return sql;
+}
+
+int main() {
+    sqlparser::RowSecurityPolicy policy;
+    for (auto table : { L"orders", L"customers", L"order_items", L"invoices", L"payments" }) {
+        policy.add(table, L"tenant_id = 42");
+    }
+
+    sqlparser::ast::SelectStatement example;
+    sqlparser::parser::parse(L"SELECT o.id, c.name FROM orders o LEFT JOIN customers c ON c.id = o.customer_id "
+                             L"WHERE EXISTS (SELECT 1 FROM payments p WHERE p.order_id = o.id)", example);
+    policy.apply(example);
+    std::wcout << L"Rewritten: " << sqlparser::generate(example) << std::endl;
+
+    const std::wstring sql = build_large_query(3);
+    sqlparser::ast::SelectStatement base;
+    if (!sqlparser::parser::parse(sql, base)) {
+        std::wcout << L"Parse failed" << std::endl;
+        return 1;
+    }
+
+    const int iterations = 1000;
+    size_t injected = 0;
+    size_t allocations = 0;
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < iterations; ++i) {
+        sqlparser::ast::SelectStatement ast;
+        sqlparser::parser::parse(sql, ast);
+        size_t before = g_allocations.load();
+        auto start = std::chrono::steady_clock::now();
+        injected = policy.apply(ast);
+        elapsed += std::chrono::steady_clock::now() - start;
+        allocations += g_allocations.load() - before;
+    }
+    std::wcout << L"Table references: " << injected << L", SQL length: " << sql.size() << std::endl;
+    std::wcout << L"apply(): " << std::chrono::duration<double, std::micro>(elapsed).count() / iterations << L" us, "
+               << allocations / iterations << L" allocations per query" << std::endl;
+    return 0;
+}
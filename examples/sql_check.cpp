@@ -14,26 +14,6 @@
 #include <sqlparser/parser.hpp>
 #include <sqlparser/generator.hpp>
 
-// ---- filter logic (same as add_exsiting_sql) ----
-static bool add_where_to_select(sqlparser::ast::SelectStatement& ast, long nIndex) {
-    if (ast.columns.empty()) return false;
-    // Use the first column expression directly as the filter condition.
-    sqlparser::ast::BinaryOp eq_op;
-    eq_op.op    = sqlparser::ast::OpType::EQ;
-    eq_op.left  = ast.columns[0].expr;
-    eq_op.right = sqlparser::ast::IntLiteral(static_cast<int>(nIndex));
-    if (ast.where) {
-        sqlparser::ast::BinaryOp and_op;
-        and_op.op    = sqlparser::ast::OpType::AND;
-        and_op.left  = *ast.where;
-        and_op.right = eq_op;
-        ast.where = and_op;
-    } else {
-        ast.where = eq_op;
-    }
-    return true;
-}
-
 static void check(const std::wstring& sql, std::optional<long> filter_id = std::nullopt) {
     std::wcout << L"Input : " << sql << std::endl;
     sqlparser::ast::SelectStatement ast;
@@ -46,15 +26,13 @@ static void check(const std::wstring& sql, std::optional<long> filter_id = std::
     std::wcout << L"Output: " << sqlparser::generate(ast) << std::endl;
 
     if (filter_id.has_value()) {
-        // re-parse for filter (parse modifies the AST)
-        sqlparser::ast::SelectStatement ast2;
-        sqlparser::parser::parse(sql, ast2);
-        if (!add_where_to_select(ast2, *filter_id)) {
-            for (auto& u : ast2.unions) add_where_to_select(u.select.get(), *filter_id);
-            std::wcout << L"Filter: FAILED (first column is not a plain identifier)" << std::endl;
+        // same filter as add_exsiting_sql: "first_column = id" in every UNION part
+        if (!sqlparser::ast::and_where_first_column(ast, sqlparser::ast::OpType::EQ,
+                                                    sqlparser::ast::IntLiteral(*filter_id),
+                                                    sqlparser::ast::UnionScope::All)) {
+            std::wcout << L"Filter: FAILED (first column cannot be used as a filter)" << std::endl;
         } else {
-            for (auto& u : ast2.unions) add_where_to_select(u.select.get(), *filter_id);
-            std::wcout << L"Filter: " << sqlparser::generate(ast2) << std::endl;
+            std::wcout << L"Filter: " << sqlparser::generate(ast) << std::endl;
         }
     }
     std::wcout << std::endl;
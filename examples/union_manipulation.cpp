@@ -12,26 +12,6 @@ sqlparser::ast::SelectStatement& get_last_select(sqlparser::ast::SelectStatement
     return get_last_select(ast.unions.back().select.get());
 }
 
-// ヘルパー関数: すべての SELECT 文に WHERE 条件を追加する
-// UNION の各パートでフィルタリングを行いたい場合に有効
-void add_where_to_all(sqlparser::ast::SelectStatement& ast, const sqlparser::ast::Expression& expr) {
-    // 現在の SELECT 文に条件追加
-    if (ast.where) {
-        sqlparser::ast::BinaryOp and_op;
-        and_op.op = sqlparser::ast::OpType::AND;
-        and_op.left = *ast.where;
-        and_op.right = expr;
-        ast.where = and_op;
-    } else {
-        ast.where = expr;
-    }
-
-    // UNION されている後続の SELECT 文にも再帰的に適用
-    for (auto& u : ast.unions) {
-        add_where_to_all(u.select.get(), expr);
-    }
-}
-
 int main() {
     // 元の UNION クエリ
     std::wstring sql = L"SELECT id, name FROM users_2023 UNION ALL SELECT id, name FROM users_2024";
@@ -74,7 +54,7 @@ int main() {
         in_expr.values.push_back(sqlparser::ast::IntLiteral(100));
         in_expr.values.push_back(sqlparser::ast::IntLiteral(200));
 
-        add_where_to_all(ast, in_expr);
+        sqlparser::ast::and_where(ast, std::move(in_expr), sqlparser::ast::UnionScope::All);
         std::wcout << L"[Step 3] Added WHERE id IN (100, 200) to all SELECT parts." << std::endl;
 
         // SQL の再生成
@@ -0,0 +1,309 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <boost/variant/apply_visitor.hpp>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/parser.hpp>
+
+namespace sqlparser {
+
+    // カラムが参照された句
+    enum class ClauseKind {
+        Select, Join, Where, GroupBy, Having, OrderBy, Limit, Offset
+    };
+
+    // 参照カラム 1 件
+    // table / subquery のどちらか一方が解決先を指す。どちらも nullptr なら未解決
+    // (修飾子が見つからない、または非修飾名で FROM に複数のテーブルがある場合)
+    struct ColumnReference {
+        const ast::Table* table = nullptr;       // 解決されたテーブル (AST 内のノード)
+        const ast::Subquery* subquery = nullptr; // 解決された派生テーブル
+        uint32_t column = 0;                     // ReferencedColumns::names のインデックス ("*" を含む)
+        ClauseKind clause = ClauseKind::Select;
+    };
+
+    // collect_columns() の結果
+    // カラム名は names にインターンされ、refs は (解決先, カラム名, 句) で重複排除されている
+    struct ReferencedColumns {
+        std::vector<String> names;
+        std::vector<ColumnReference> refs;
+
+        const String& name(const ColumnReference& ref) const { return names[ref.column]; }
+    };
+
+    namespace detail {
+
+        // 名前解決のスコープ (SELECT 文 1 つ分の FROM / JOIN)
+        struct ColumnScope {
+            struct Source {
+                std::wstring_view key;  // エイリアス、なければテーブル名
+                const ast::Table* table;
+                const ast::Subquery* subquery;
+            };
+            std::vector<Source> sources;
+            const ColumnScope* parent = nullptr;
+
+            void add(const ast::TableReference& ref) {
+                if (auto* t = boost::get<ast::Table>(&ref)) {
+                    std::wstring_view name = t->name;
+                    if (name.empty()) return;
+                    if (t->alias) {
+                        sources.push_back({ *t->alias, t, nullptr });
+                    } else {
+                        sources.push_back({ name, t, nullptr });
+                        // スキーマ修飾 (GIS.T) は T だけでも参照できる
+                        size_t dot = name.rfind(L'.');
+                        if (dot != std::wstring_view::npos) {
+                            sources.push_back({ name.substr(dot + 1), t, nullptr });
+                        }
+                    }
+                } else if (auto* s = boost::get<ast::Subquery>(&ref)) {
+                    sources.push_back({ s->alias ? std::wstring_view(*s->alias) : std::wstring_view(), nullptr, s });
+                }
+            }
+
+            // 修飾子 (エイリアス / テーブル名) を外側のスコープまで遡って探す
+            const Source* find(std::wstring_view qualifier) const {
+                for (const ColumnScope* scope = this; scope; scope = scope->parent) {
+                    for (auto const& src : scope->sources) {
+                        if (!src.key.empty() && parser::is_iequal(src.key, qualifier)) return &src;
+                    }
+                }
+                return nullptr;
+            }
+
+            // FROM に現れる個別のテーブル参照の数 (スキーマ修飾の別名は数えない)
+            size_t distinct_count() const {
+                size_t n = 0;
+                const void* last = nullptr;
+                for (auto const& src : sources) {
+                    const void* node = src.table ? static_cast<const void*>(src.table) : static_cast<const void*>(src.subquery);
+                    if (node != last) ++n;
+                    last = node;
+                }
+                return n;
+            }
+        };
+
+        // std::wstring_view でも引けるハッシュ (インターン表の検索で一時文字列を作らない)
+        struct NameHash {
+            using is_transparent = void;
+            size_t operator()(std::wstring_view s) const { return std::hash<std::wstring_view>()(s); }
+        };
+
+        struct ColumnKeyHash {
+            size_t operator()(ColumnReference const& r) const {
+                size_t h = std::hash<const void*>()(r.table ? static_cast<const void*>(r.table) : static_cast<const void*>(r.subquery));
+                h ^= std::hash<uint32_t>()(r.column) + 0x9e3779b9 + (h << 6) + (h >> 2);
+                h ^= std::hash<int>()(static_cast<int>(r.clause)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+                return h;
+            }
+        };
+
+        struct ColumnKeyEqual {
+            bool operator()(ColumnReference const& a, ColumnReference const& b) const {
+                return a.table == b.table && a.subquery == b.subquery && a.column == b.column && a.clause == b.clause;
+            }
+        };
+
+        // SelectStatement 全体を一度だけ走査してカラム参照を集める
+        struct ColumnCollector : boost::static_visitor<void> {
+            ReferencedColumns& result;
+            std::unordered_map<String, uint32_t, NameHash, std::equal_to<>> interned;
+            std::unordered_set<ColumnReference, ColumnKeyHash, ColumnKeyEqual> seen;
+            const ColumnScope* scope = nullptr;
+            ClauseKind clause = ClauseKind::Select;
+
+            explicit ColumnCollector(ReferencedColumns& result) : result(result) {}
+
+            uint32_t intern(std::wstring_view name) {
+                auto it = interned.find(name);
+                if (it != interned.end()) return it->second;
+                uint32_t id = static_cast<uint32_t>(result.names.size());
+                result.names.emplace_back(name);
+                interned.emplace(result.names.back(), id);
+                return id;
+            }
+
+            void record(const ast::Table* table, const ast::Subquery* subquery, std::wstring_view column) {
+                ColumnReference ref;
+                ref.table = table;
+                ref.subquery = subquery;
+                ref.column = intern(column);
+                ref.clause = clause;
+                if (seen.insert(ref).second) result.refs.push_back(ref);
+            }
+
+            // "t.col" / "col" / "*" を解決して記録する
+            void reference(std::wstring_view ident) {
+                if (parser::is_iequal(ident, L"NULL") || parser::is_iequal(ident, L"TRUE") || parser::is_iequal(ident, L"FALSE")) return;
+
+                size_t dot = ident.rfind(L'.');
+                if (dot != std::wstring_view::npos) {
+                    std::wstring_view column = ident.substr(dot + 1);
+                    if (auto* src = scope ? scope->find(ident.substr(0, dot)) : nullptr) {
+                        record(src->table, src->subquery, column);
+                    } else {
+                        record(nullptr, nullptr, column);
+                    }
+                    return;
+                }
+
+                if (ident == L"*") {
+                    // SELECT * は FROM の全テーブルを参照する
+                    const void* last = nullptr;
+                    for (auto const& src : scope->sources) {
+                        const void* node = src.table ? static_cast<const void*>(src.table) : static_cast<const void*>(src.subquery);
+                        if (node != last) record(src.table, src.subquery, ident);
+                        last = node;
+                    }
+                    return;
+                }
+
+                // 非修飾名は FROM のテーブルが 1 つのときだけ一意に解決できる
+                if (scope && scope->distinct_count() == 1) {
+                    auto const& src = scope->sources.front();
+                    record(src.table, src.subquery, ident);
+                } else {
+                    record(nullptr, nullptr, ident);
+                }
+            }
+
+            void operator()(const ast::IntLiteral&) {}
+            void operator()(const ast::FloatLiteral&) {}
+            void operator()(const ast::StringLiteral&) {}
+            void operator()(const Identifier& s) { reference(s); }
+
+            void operator()(const ast::BinaryOp& op) {
+                boost::apply_visitor(*this, op.left);
+                boost::apply_visitor(*this, op.right);
+            }
+
+            void operator()(const ast::LogicalOp& op) {
+                for (auto const& operand : op.operands) boost::apply_visitor(*this, operand);
+            }
+
+            void operator()(const ast::UnaryOp& op) { boost::apply_visitor(*this, op.expr); }
+            void operator()(const ast::Cast& cast) { boost::apply_visitor(*this, cast.expr); }
+
+            void operator()(const ast::FunctionCall& func) {
+                for (auto const& arg : func.args) {
+                    // COUNT(*) の * はカラム参照ではない
+                    if (auto* s = boost::get<Identifier>(&arg); s && *s == L"*") continue;
+                    boost::apply_visitor(*this, arg);
+                }
+            }
+
+            void operator()(const ast::Case& c) {
+                if (c.arg) boost::apply_visitor(*this, *c.arg);
+                for (auto const& w : c.when_clauses) {
+                    boost::apply_visitor(*this, w.when);
+                    boost::apply_visitor(*this, w.then);
+                }
+                if (c.else_result) boost::apply_visitor(*this, *c.else_result);
+            }
+
+            void operator()(const ast::Between& b) {
+                boost::apply_visitor(*this, b.expr);
+                boost::apply_visitor(*this, b.lower);
+                boost::apply_visitor(*this, b.upper);
+            }
+
+            void operator()(const ast::In& in) {
+                boost::apply_visitor(*this, in.expr);
+                for (auto const& v : in.values) boost::apply_visitor(*this, v);
+            }
+
+            void operator()(const ast::Exists& e) {
+                // 相関サブクエリ: 外側のスコープを親として解決する
+                ClauseKind saved = clause;
+                statement(e.subquery.get(), scope);
+                clause = saved;
+            }
+
+            void operator()(const ast::WindowFunction& wf) {
+                (*this)(wf.func);
+                for (auto const& p : wf.window.partitionBy) boost::apply_visitor(*this, p);
+                for (auto const& o : wf.window.orderBy) reference(o.column);
+            }
+
+            void table_reference(const ast::TableReference& ref) {
+                // 派生テーブルは独立したスコープ (外側の名前は見えない)
+                if (auto* s = boost::get<ast::Subquery>(&ref)) {
+                    ClauseKind saved = clause;
+                    statement(s->select.get(), nullptr);
+                    clause = saved;
+                }
+            }
+
+            void statement(const ast::SelectStatement& stmt, const ColumnScope* parent) {
+                ColumnScope local;
+                local.parent = parent;
+                local.add(stmt.table);
+                for (auto const& join : stmt.joins) local.add(join.table);
+
+                table_reference(stmt.table);
+                for (auto const& join : stmt.joins) table_reference(join.table);
+
+                const ColumnScope* saved_scope = scope;
+                scope = &local;
+
+                clause = ClauseKind::Select;
+                for (auto const& col : stmt.columns) boost::apply_visitor(*this, col.expr);
+
+                clause = ClauseKind::Join;
+                for (auto const& join : stmt.joins) {
+                    if (join.on) boost::apply_visitor(*this, *join.on);
+                    // USING の列は結合する両側にあるが、JOIN したテーブル側に解決する
+                    for (auto const& col : join.using_columns) {
+                        record(boost::get<ast::Table>(&join.table), boost::get<ast::Subquery>(&join.table), col);
+                    }
+                }
+
+                clause = ClauseKind::Where;
+                if (stmt.where) boost::apply_visitor(*this, *stmt.where);
+
+                clause = ClauseKind::GroupBy;
+                for (auto const& g : stmt.groupBy) boost::apply_visitor(*this, g);
+
+                clause = ClauseKind::Having;
+                if (stmt.having) boost::apply_visitor(*this, *stmt.having);
+
+                clause = ClauseKind::OrderBy;
+                for (auto const& o : stmt.orderBy) {
+                    // SELECT リストのエイリアスを指す ORDER BY はカラム参照ではない
+                    bool is_alias = false;
+                    for (auto const& col : stmt.columns) {
+                        if (col.alias && parser::is_iequal(*col.alias, o.column)) { is_alias = true; break; }
+                    }
+                    if (!is_alias) reference(o.column);
+                }
+
+                clause = ClauseKind::Limit;
+                if (stmt.limit) boost::apply_visitor(*this, *stmt.limit);
+
+                clause = ClauseKind::Offset;
+                if (stmt.offset) boost::apply_visitor(*this, *stmt.offset);
+
+                scope = saved_scope;
+
+                // UNION の各ブランチは同じ階層の別スコープ
+                for (auto const& u : stmt.unions) statement(u.select.get(), parent);
+            }
+        };
+    }
+
+    // SELECT 文 (UNION・派生テーブル・EXISTS サブクエリを含む) が参照する全カラムを、
+    // 句ごと・解決先テーブルごとに重複なく列挙する。AST の走査は 1 回だけ。
+    // 結果の table / subquery ポインタは stmt 内のノードを指すため、stmt より長く保持しないこと。
+    inline void collect_columns(const ast::SelectStatement& stmt, ReferencedColumns& out) {
+        out.names.clear();
+        out.refs.clear();
+        detail::ColumnCollector collector(out);
+        collector.statement(stmt, nullptr);
+    }
+}
@@ -1,10 +1,16 @@
 #pragma once
+#include <cstdint>
+#include <cwchar>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <boost/variant.hpp>
 #include <boost/optional.hpp>
 #include <boost/fusion/include/adapt_struct.hpp>
 #include <sqlparser/config.hpp>
+#include <sqlparser/shared_node.hpp>
+#include <sqlparser/types.hpp>
 
 namespace sqlparser::ast {
     
@@ -28,6 +34,7 @@ namespace sqlparser::ast {
 
     // 前方宣言
     struct BinaryOp;
+    struct LogicalOp;
     struct UnaryOp;
     struct Cast;
     struct FunctionCall;
@@ -39,12 +46,28 @@ namespace sqlparser::ast {
     struct In; // Added
     struct Exists;
     struct WindowFunction;
+    struct SelectStatement;
+
+    // 再帰ノードは参照カウントで共有し、書き込み時にだけ複製する (shared_node.hpp)
+    template <> inline constexpr bool is_shared_node<StringLiteral> = true;
+    template <> inline constexpr bool is_shared_node<BinaryOp> = true;
+    template <> inline constexpr bool is_shared_node<LogicalOp> = true;
+    template <> inline constexpr bool is_shared_node<UnaryOp> = true;
+    template <> inline constexpr bool is_shared_node<Cast> = true;
+    template <> inline constexpr bool is_shared_node<FunctionCall> = true;
+    template <> inline constexpr bool is_shared_node<Case> = true;
+    template <> inline constexpr bool is_shared_node<Between> = true;
+    template <> inline constexpr bool is_shared_node<In> = true;
+    template <> inline constexpr bool is_shared_node<WindowFunction> = true;
+    template <> inline constexpr bool is_shared_node<Exists> = true;
+    template <> inline constexpr bool is_shared_node<SelectStatement> = true;
 
     // 式を表すバリアント
     // IntLiteral: 数値
-    // String: 識別子 (カラム名)
+    // Identifier: 識別子 (カラム名)
     // StringLiteral: 文字列リテラル
     // BinaryOp: 二項演算 (再帰的)
+    // LogicalOp: AND / OR の n 項演算 (再帰的)
     // UnaryOp: 単項演算 (再帰的)
     // Cast: 型変換
     // FunctionCall: 関数呼び出し
@@ -54,9 +77,10 @@ namespace sqlparser::ast {
     using Expression = boost::variant<
         IntLiteral,
         FloatLiteral,
-        String, 
+        Identifier,
         boost::recursive_wrapper<StringLiteral>,
         boost::recursive_wrapper<BinaryOp>,
+        boost::recursive_wrapper<LogicalOp>,
         boost::recursive_wrapper<UnaryOp>,
         boost::recursive_wrapper<Cast>,
         boost::recursive_wrapper<FunctionCall>,
@@ -68,20 +92,89 @@ namespace sqlparser::ast {
     >;
 
     // 数値リテラル構造体
+    // SQL 上の綴り (text) をそのまま保持し、数値への変換は value() を呼んだ時点で行う。
+    // generate() は text をそのまま出力するため、int64_t に収まらない値も桁落ちなく往復する。
+    // text は SmallString で、inline_capacity 桁までの綴りはヒープ確保なしで保持する。
     struct IntLiteral {
-        int value;
-        IntLiteral(int v = 0) : value(v) {}
+        SmallString text;
+
+        IntLiteral() : text(L"0", 1) {}
+        IntLiteral(int64_t v) : text(std::to_wstring(v)) {}
+        explicit IntLiteral(std::wstring_view source_text) : text(source_text) {}
+
+        // int64_t に変換する (範囲外なら false)
+        bool to_int64(int64_t& out) const {
+            std::wstring_view s = text.view();
+            size_t i = 0;
+            bool negative = false;
+            if (i < s.size() && (s[i] == L'-' || s[i] == L'+')) negative = s[i++] == L'-';
+            if (i == s.size()) return false;
+            uint64_t limit = negative ? uint64_t(std::numeric_limits<int64_t>::max()) + 1 : uint64_t(std::numeric_limits<int64_t>::max());
+            uint64_t v = 0;
+            for (; i < s.size(); ++i) {
+                if (s[i] < L'0' || s[i] > L'9') return false;
+                uint64_t d = static_cast<uint64_t>(s[i] - L'0');
+                if (v > (limit - d) / 10) return false;
+                v = v * 10 + d;
+            }
+            out = negative ? static_cast<int64_t>(0 - v) : static_cast<int64_t>(v);
+            return true;
+        }
+
+        // int64_t に変換した値 (範囲外の場合は 0)
+        int64_t value() const {
+            int64_t v = 0;
+            return to_int64(v) ? v : 0;
+        }
     };
 
     // 浮動小数点リテラル構造体 (例: 0.6, 1.0)
+    // IntLiteral と同様に綴りを保持し、double への変換は value() で行う
     struct FloatLiteral {
-        double value;
-        FloatLiteral(double v = 0) : value(v) {}
+        SmallString text;
+
+        FloatLiteral() : text(L"0", 1) {}
+        // 数値から構築する場合は有効数字 15 桁で表記する
+        FloatLiteral(double v) {
+            wchar_t buf[32];
+            int n = std::swprintf(buf, 32, L"%.15g", v);
+            text = std::wstring_view(buf, n > 0 ? static_cast<size_t>(n) : 0);
+        }
+        explicit FloatLiteral(std::wstring_view source_text) : text(source_text) {}
+
+        double value() const { return std::wcstod(text.c_str(), nullptr); }
     };
 
+    // 数値リテラルの綴りで Expression を大きくしない (綴りの SmallString 以下)
+    static_assert(sizeof(IntLiteral) <= sizeof(SmallString) && sizeof(FloatLiteral) <= sizeof(SmallString));
+
     // 文字列リテラル構造体
+    // 通常は value に中身 ('' のエスケープは解除済み) を保持する。
+    // ビューモード (parser::ParseOptions::string_literal_views) では value は空のままで、
+    // source が入力バッファ上の中身 (引用符の内側、'' はエスケープされたまま) を指す。
     struct StringLiteral {
-        String value;
+        SmallString value;
+        std::wstring_view source;
+
+        // 入力バッファを参照しているか
+        bool is_view() const { return source.data() != nullptr; }
+
+        // 中身を返す (ビューモードではここで '' のエスケープを解除する)
+        std::wstring text() const {
+            if (!is_view()) return value.str();
+            return unescape(source);
+        }
+
+        // SQL 上の綴り ('' をエスケープ済み、引用符を除く) 中の '' を ' に戻す
+        static std::wstring unescape(std::wstring_view quoted) {
+            std::wstring out;
+            out.reserve(quoted.size());
+            for (size_t i = 0; i < quoted.size(); ++i) {
+                out.push_back(quoted[i]);
+                if (quoted[i] == L'\'' && i + 1 < quoted.size() && quoted[i + 1] == L'\'') ++i;
+            }
+            return out;
+        }
     };
 
     // 二項演算構造体
@@ -91,6 +184,13 @@ namespace sqlparser::ast {
         Expression right;
     };
 
+    // AND / OR の n 項演算構造体 (op は AND か OR)
+    // "a AND b AND c" は深さ 1 のノードに平坦化され、条件の追加は operands への push_back で済む
+    struct LogicalOp {
+        OpType op;
+        std::vector<Expression> operands;
+    };
+
     // 単項演算構造体
     struct UnaryOp {
         OpType op;
@@ -100,12 +200,13 @@ namespace sqlparser::ast {
     // CAST式構造体
     struct Cast {
         Expression expr;
-        String type_name;
+        SmallString type_name; // SQL 上の綴り (generate() はこれを出力する)
+        TypeInfo type;         // 型カタログで解決した型と修飾子
     };
 
     // 関数呼び出し構造体
     struct FunctionCall {
-        String name;
+        Identifier name;
         std::vector<Expression> args;
     };
 
@@ -130,22 +231,62 @@ namespace sqlparser::ast {
         bool not_between; // true if NOT BETWEEN
     };
 
+    // 同種のリテラルだけからなる IN リストの詰めた表現
+    // 1 要素ごとに Expression を持たず、整数は int64_t の配列、文字列は連結バッファ + 終端位置で保持する
+    // NUMERIC は小数や int64_t に収まらない数値を含むリストで、各数値の綴りを文字列と同様に保持する
+    struct LiteralList {
+        enum class Kind : uint8_t { INT, STRING, NUMERIC };
+
+        Kind kind = Kind::INT;
+        std::vector<int64_t> ints;      // kind == INT
+        std::wstring chars;             // kind == STRING / NUMERIC: 各値の SQL 上の綴り (文字列は引用符の内側、'' はエスケープのまま) を連結したもの
+        std::vector<uint32_t> ends;     // kind == STRING / NUMERIC: chars 内での各値の終端位置
+
+        size_t size() const { return kind == Kind::INT ? ints.size() : ends.size(); }
+        bool empty() const { return size() == 0; }
+
+        int64_t int_at(size_t i) const { return ints[i]; }
+        std::wstring_view string_at(size_t i) const {
+            size_t begin = i == 0 ? 0 : ends[i - 1];
+            return std::wstring_view(chars.data() + begin, ends[i] - begin);
+        }
+
+        void push_back(int64_t v) { ints.push_back(v); }
+        void push_back(std::wstring_view s) {
+            chars.append(s);
+            ends.push_back(static_cast<uint32_t>(chars.size()));
+        }
+
+        // INT から NUMERIC へ切り替える (格納済みの整数は 10 進表記に変換する)
+        void to_numeric() {
+            for (int64_t v : ints) push_back(std::to_wstring(v));
+            ints.clear();
+            kind = Kind::NUMERIC;
+        }
+    };
+
     // IN式構造体
+    // パーサーは同種のリテラルだけのリストを literals に、それ以外を values に格納する (どちらか一方のみ使用)
     struct In {
         Expression expr;
         std::vector<Expression> values;
         bool not_in; // true if NOT IN
+        LiteralList literals;
+
+        size_t size() const { return values.empty() ? literals.size() : values.size(); }
+        // i 番目の値を Expression として取り出す (literals の場合は都度構築する)
+        Expression value_at(size_t i) const;
     };
 
     // 選択リストの要素 (式 + オプションのエイリアス)
     struct ResultColumn {
         Expression expr;
-        boost::optional<String> alias;
+        boost::optional<Identifier> alias;
     };
 
     // ORDER BY 要素
     struct OrderByElement {
-        String column;
+        Identifier column;
         OrderDirection direction;
     };
 
@@ -170,14 +311,14 @@ namespace sqlparser::ast {
 
     // テーブル (名前 + エイリアス)
     struct Table {
-        String name;
-        boost::optional<String> alias;
+        Identifier name;
+        boost::optional<Identifier> alias;
     };
 
     // サブクエリ (SELECT文 + エイリアス)
     struct Subquery {
         boost::recursive_wrapper<SelectStatement> select;
-        boost::optional<String> alias;
+        boost::optional<Identifier> alias;
     };
 
     // テーブル参照 (テーブル または サブクエリ)
@@ -187,15 +328,20 @@ namespace sqlparser::ast {
     >;
 
     // JOINの種類
+    // IMPLICIT はカンマ区切りの結合 (FROM a, b)。CROSS JOIN と同じく結合条件を持たない
     enum class JoinType {
-        INNER, LEFT, RIGHT, FULL
+        INNER, LEFT, RIGHT, FULL, CROSS, IMPLICIT
     };
 
     // JOIN句
+    // 結合条件は on (ON 句) か using_columns (USING 句) のどちらか。
+    // CROSS / IMPLICIT / NATURAL JOIN はどちらも持たない。
     struct Join {
         JoinType type;
+        bool natural = false;                 // NATURAL JOIN
         TableReference table;
-        Expression on;
+        boost::optional<Expression> on;       // ON 句
+        std::vector<Identifier> using_columns; // USING (...) 句 (空なら指定なし)
     };
 
     // SELECT修飾子
@@ -235,6 +381,129 @@ namespace sqlparser::ast {
         boost::optional<Expression> offset; // OFFSET句 (省略可能)
         std::vector<UnionClause> unions; // UNION句のリスト
     };
+
+    inline Expression In::value_at(size_t i) const {
+        if (!values.empty()) return values[i];
+        if (literals.kind == LiteralList::Kind::INT) return IntLiteral(literals.int_at(i));
+        if (literals.kind == LiteralList::Kind::NUMERIC) {
+            std::wstring_view text = literals.string_at(i);
+            if (text.find(L'.') != std::wstring_view::npos) return FloatLiteral(text);
+            return IntLiteral(text);
+        }
+        StringLiteral s;
+        s.value = StringLiteral::unescape(literals.string_at(i));
+        return s;
+    }
+
+    // 2 つの式を op (AND / OR) で結合する
+    // target が同じ op の LogicalOp ならその末尾に追加するだけなので、繰り返し呼んでも木は深くならない
+    inline void combine(Expression& target, Expression cond, OpType op = OpType::AND) {
+        if (auto* logical = boost::get<LogicalOp>(&target); logical && logical->op == op) {
+            logical->operands.push_back(std::move(cond));
+            return;
+        }
+        LogicalOp node;
+        node.op = op;
+        node.operands.reserve(2);
+        node.operands.push_back(std::move(target));
+        node.operands.push_back(std::move(cond));
+        // Expression として代入する (LogicalOp を直接代入すると、operands に移した元のノードを
+        // 書き込み用に取り出してしまい、共有中のため丸ごと複製される)
+        target = Expression(std::move(node));
+    }
+
+    // WHERE / HAVING など省略可能な句に AND で条件を追加する
+    inline void add_conjunct(boost::optional<Expression>& target, Expression cond) {
+        if (target) {
+            combine(*target, std::move(cond), OpType::AND);
+        } else {
+            target = std::move(cond);
+        }
+    }
+
+    // 条件を追加する SELECT 文の範囲
+    enum class UnionScope {
+        First, // stmt 自身 (UNION の先頭) のみ
+        All    // UNION の全ブランチ
+    };
+
+    namespace detail {
+        template <typename Clause>
+        inline void add_conjunct_to(SelectStatement& stmt, Clause clause, Expression cond, UnionScope scope) {
+            if (scope == UnionScope::All) {
+                // 各ブランチには条件のコピー (子ノードは共有) を追加する
+                for (auto& u : stmt.unions) {
+                    add_conjunct_to(u.select.get(), clause, cond, scope);
+                }
+            }
+            add_conjunct(stmt.*clause, std::move(cond));
+        }
+
+        constexpr wchar_t fold_ascii(wchar_t c) {
+            return (c >= L'a' && c <= L'z') ? static_cast<wchar_t>(c - L'a' + L'A') : c;
+        }
+
+        // b は大文字で渡すこと
+        inline bool iequals_ascii(std::wstring_view a, std::wstring_view b) {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (fold_ascii(a[i]) != b[i]) return false;
+            }
+            return true;
+        }
+
+        // 名前の表 (ASCII の大文字小文字を区別せず、std::wstring_view でも引ける)
+        struct IgnoreCaseHash {
+            using is_transparent = void;
+            size_t operator()(std::wstring_view s) const {
+                uint64_t h = 14695981039346656037ull;
+                for (wchar_t c : s) h = (h ^ static_cast<uint64_t>(fold_ascii(c))) * 1099511628211ull;
+                return static_cast<size_t>(h);
+            }
+        };
+
+        struct IgnoreCaseEqual {
+            using is_transparent = void;
+            bool operator()(std::wstring_view a, std::wstring_view b) const {
+                if (a.size() != b.size()) return false;
+                for (size_t i = 0; i < a.size(); ++i) {
+                    if (fold_ascii(a[i]) != fold_ascii(b[i])) return false;
+                }
+                return true;
+            }
+        };
+
+        // WHERE から参照できない集約関数
+        inline bool is_aggregate_function(std::wstring_view name) {
+            for (std::wstring_view agg : { L"COUNT", L"SUM", L"AVG", L"MIN", L"MAX", L"STRING_AGG", L"ARRAY_AGG",
+                                           L"BOOL_AND", L"BOOL_OR", L"EVERY", L"GROUP_CONCAT", L"LISTAGG" }) {
+                if (iequals_ascii(name, agg)) return true;
+            }
+            return false;
+        }
+    }
+
+    // WHERE / HAVING に AND で条件を追加する
+    // 既存の条件はムーブで新しい LogicalOp に移す (既存が AND なら末尾に追加する) ため、既存の条件の大きさによらず O(1)
+    inline void and_where(SelectStatement& stmt, Expression cond, UnionScope scope = UnionScope::First) {
+        detail::add_conjunct_to(stmt, &SelectStatement::where, std::move(cond), scope);
+    }
+
+    inline void and_having(SelectStatement& stmt, Expression cond, UnionScope scope = UnionScope::First) {
+        detail::add_conjunct_to(stmt, &SelectStatement::having, std::move(cond), scope);
+    }
+
+    // joins[join_index] の ON に AND で条件を追加する
+    // CROSS JOIN は INNER JOIN ... ON に変える。
+    // USING / NATURAL JOIN と、カンマ区切りの結合 (JOIN より結合の優先順位が低く ON を付けられない) は変更せず false
+    inline bool and_join_on(SelectStatement& stmt, size_t join_index, Expression cond) {
+        if (join_index >= stmt.joins.size()) return false;
+        Join& join = stmt.joins[join_index];
+        if (join.natural || !join.using_columns.empty() || join.type == JoinType::IMPLICIT) return false;
+        if (join.type == JoinType::CROSS) join.type = JoinType::INNER;
+        add_conjunct(join.on, std::move(cond));
+        return true;
+    }
 }
 
 // Boost.Fusion で構造体をアダプト
@@ -242,6 +511,7 @@ BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Table, name, alias)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Subquery, select, alias)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::StringLiteral, value)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::BinaryOp, op, left, right)
+BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::LogicalOp, op, operands)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::UnaryOp, op, expr)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Cast, expr, type_name)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::FunctionCall, name, args)
@@ -252,7 +522,7 @@ BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::In, expr, values, not_in)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Exists, subquery)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::ResultColumn, expr, alias)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::OrderByElement, column, direction)
-BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Join, type, table, on)
+BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::Join, type, natural, table, on, using_columns)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::UnionClause, type, select)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::SelectStatement, quantifier, columns, table, joins, where, groupBy, having, orderBy, limit, offset, unions)
 BOOST_FUSION_ADAPT_STRUCT(sqlparser::ast::WindowSpec, partitionBy, orderBy)
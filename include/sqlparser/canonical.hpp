@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/compare.hpp>
+#include <sqlparser/traverse.hpp>
+
+namespace sqlparser::ast {
+
+    namespace detail {
+
+        // 交換可能な二項演算子 (a op b と b op a が同じ。^ は PostgreSQL ではべき乗なので含めない)
+        inline bool is_commutative(OpType op) {
+            switch (op) {
+            case OpType::EQ: case OpType::NE: case OpType::ADD: case OpType::MUL:
+            case OpType::BIT_AND: case OpType::BIT_OR:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        // 結合的な二項演算子 ((a op b) op c と a op (b op c) が同じ)
+        inline bool is_associative(OpType op) {
+            return op == OpType::CONCAT || (op != OpType::EQ && op != OpType::NE && is_commutative(op));
+        }
+
+        // 正規化の走査
+        // 識別子は行きがけ順 (enter) で小文字にし、演算子の並べ替えは子が正規化された後 (leave_expression) に行う。
+        // どれも既に正規形であれば書き込み用に取り出さない。
+        struct Canonicalizer {
+            sqlparser::detail::StructuralHash hasher{ CompareOptions{} };
+
+            // ASCII の大文字を小文字にする (引用符付きの識別子は大文字小文字を区別するため変えない)
+            static void fold(Identifier& id) {
+                std::wstring_view name = id;
+                auto upper = [](wchar_t c) { return c >= L'A' && c <= L'Z'; };
+                auto first = std::find_if(name.begin(), name.end(), upper);
+                if (first == name.end() || name.find(L'"') != std::wstring_view::npos) return;
+                auto lower = [](wchar_t c) { return c >= L'A' && c <= L'Z' ? static_cast<wchar_t>(c - L'A' + L'a') : c; };
+                wchar_t buf[64];
+                if (name.size() <= std::size(buf)) {
+                    std::transform(name.begin(), name.end(), buf, lower);
+                    id = Identifier(std::wstring_view(buf, name.size()));
+                } else {
+                    String folded(name);
+                    std::transform(folded.begin(), folded.end(), folded.begin(), lower);
+                    id = Identifier(folded);
+                }
+            }
+
+            static void fold(boost::optional<Identifier>& id) {
+                if (id) fold(*id);
+            }
+
+            void enter(Identifier& id) { fold(id); }
+            void enter(FunctionCall& call) { fold(call.name); }
+            void enter(OrderByElement& o) { fold(o.column); }
+            void enter(ResultColumn& col) { fold(col.alias); }
+            void enter(Table& table) {
+                fold(table.name);
+                fold(table.alias);
+            }
+            void enter(Subquery& sub) { fold(sub.alias); }
+            void enter(Join& join) {
+                for (auto& c : join.using_columns) fold(c);
+            }
+
+            // 型名はカタログの正規名にする ("int4" → "integer")。修飾子付きの型と、綴りでしか区別できない型はそのまま
+            void enter(Cast& cast) {
+                if (sqlparser::detail::StructuralHash::compares_type_name(cast) || cast.type.precision >= 0 || cast.type.array_dims != 0) return;
+                std::wstring_view canonical = canonical_type_name(cast.type.id);
+                if (cast.type_name.view() != canonical) {
+                    cast.type_name = canonical;
+                }
+            }
+
+            void leave_expression(Expression& e) {
+                const Expression& view = e;
+                if (auto const* b = boost::get<BinaryOp>(&view)) {
+                    canonicalize_binary(e, *b);
+                } else if (auto const* l = boost::get<LogicalOp>(&view)) {
+                    canonicalize_logical(e, *l);
+                } else if (auto const* in = boost::get<In>(&view)) {
+                    canonicalize_in(e, *in);
+                }
+            }
+
+            // a > b は b < a、a >= b は b <= a にする。交換可能なら小さいハッシュを左に、結合的なら左に深い鎖にする
+            void canonicalize_binary(Expression& e, const BinaryOp& n) {
+                if (n.op == OpType::GT || n.op == OpType::GE) {
+                    BinaryOp& w = boost::get<BinaryOp>(e);
+                    w.op = w.op == OpType::GT ? OpType::LT : OpType::LE;
+                    std::swap(w.left, w.right);
+                    return;
+                }
+                if (is_associative(n.op)) {
+                    canonicalize_chain(e, n);
+                } else if (is_commutative(n.op) && hasher(n.right) < hasher(n.left)) {
+                    BinaryOp& w = boost::get<BinaryOp>(e);
+                    std::swap(w.left, w.right);
+                }
+            }
+
+            // 子の鎖は正規化済み (左に深く、交換可能なら葉がハッシュ順) なので、右の子と左の鎖の最後の葉だけを見ればよい
+            void canonicalize_chain(Expression& e, const BinaryOp& n) {
+                auto const* right_chain = boost::get<BinaryOp>(&n.right);
+                bool right_is_chain = right_chain && right_chain->op == n.op;
+                if (!right_is_chain) {
+                    if (!is_commutative(n.op)) return;
+                    auto const* left_chain = boost::get<BinaryOp>(&n.left);
+                    const Expression& last = left_chain && left_chain->op == n.op ? left_chain->right : n.left;
+                    if (!(hasher(n.right) < hasher(last))) return;
+                }
+
+                std::vector<std::pair<size_t, Expression>> leaves;
+                collect_leaves(n.op, e, leaves);
+                if (is_commutative(n.op)) {
+                    std::stable_sort(leaves.begin(), leaves.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+                }
+                Expression chain = std::move(leaves.front().second);
+                for (size_t i = 1; i < leaves.size(); ++i) {
+                    chain = Expression(BinaryOp{ n.op, std::move(chain), std::move(leaves[i].second) });
+                }
+                e = std::move(chain);
+            }
+
+            void collect_leaves(OpType op, const Expression& e, std::vector<std::pair<size_t, Expression>>& out) {
+                if (auto const* b = boost::get<BinaryOp>(&e); b && b->op == op) {
+                    collect_leaves(op, b->left, out);
+                    collect_leaves(op, b->right, out);
+                } else {
+                    out.emplace_back(hasher(e), e);
+                }
+            }
+
+            // AND / OR は入れ子の同じ演算子を平坦化し、オペランドをハッシュ順に並べて重複を除く
+            void canonicalize_logical(Expression& e, const LogicalOp& n) {
+                bool canonical = true;
+                size_t previous = 0;
+                for (size_t i = 0; i < n.operands.size() && canonical; ++i) {
+                    auto const* child = boost::get<LogicalOp>(&n.operands[i]);
+                    size_t h = hasher(n.operands[i]);
+                    canonical = !(child && child->op == n.op) && (i == 0 || previous < h);
+                    previous = h;
+                }
+                if (canonical) return;
+
+                std::vector<std::pair<size_t, Expression>> operands;
+                operands.reserve(n.operands.size());
+                for (auto const& operand : n.operands) {
+                    auto const* child = boost::get<LogicalOp>(&operand);
+                    if (child && child->op == n.op) {
+                        for (auto const& c : child->operands) operands.emplace_back(hasher(c), c);
+                    } else {
+                        operands.emplace_back(hasher(operand), operand);
+                    }
+                }
+                std::stable_sort(operands.begin(), operands.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+                // 同じ条件の重複 (x AND x は x)
+                auto last = std::unique(operands.begin(), operands.end(), [](auto const& a, auto const& b) {
+                    return a.first == b.first && structural_equal(a.second, b.second);
+                });
+                operands.erase(last, operands.end());
+                if (operands.size() == 1) {
+                    e = std::move(operands.front().second);
+                    return;
+                }
+                std::vector<Expression> sorted;
+                sorted.reserve(operands.size());
+                for (auto& o : operands) sorted.push_back(std::move(o.second));
+                boost::get<LogicalOp>(e).operands = std::move(sorted);
+            }
+
+            // IN のリストは順序によらない
+            // values と literals (整数・数値・文字列) のどの形でも、値の構造的なハッシュの順に並べる (同じリストは形によらず同じ順になる)
+            void canonicalize_in(Expression& e, const In& n) {
+                size_t count = n.size();
+                bool sorted = true;
+                for (size_t i = 1, prev = count > 0 ? hasher.element(n, 0) : 0; i < count && sorted; ++i) {
+                    size_t h = hasher.element(n, i);
+                    sorted = !(h < prev);
+                    prev = h;
+                }
+                if (sorted) return;
+                std::vector<std::pair<size_t, uint32_t>> order;
+                order.reserve(count);
+                for (size_t i = 0; i < count; ++i) order.emplace_back(hasher.element(n, i), static_cast<uint32_t>(i));
+                std::stable_sort(order.begin(), order.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+                if (!n.values.empty()) {
+                    In& w = boost::get<In>(e);
+                    std::vector<Expression> values;
+                    values.reserve(count);
+                    for (auto const& o : order) values.push_back(std::move(w.values[o.second]));
+                    w.values = std::move(values);
+                    return;
+                }
+                LiteralList list;
+                list.kind = n.literals.kind;
+                if (list.kind == LiteralList::Kind::INT) {
+                    list.ints.reserve(count);
+                    for (auto const& o : order) list.push_back(n.literals.int_at(o.second));
+                } else {
+                    list.chars.reserve(n.literals.chars.size());
+                    list.ends.reserve(count);
+                    for (auto const& o : order) list.push_back(n.literals.string_at(o.second));
+                }
+                boost::get<In>(e).literals = std::move(list);
+            }
+        };
+    }
+
+    // 等価なクエリの検出のための正規化
+    // 意味が同じで書き方だけが異なる式を同じ AST にする (structural_hash / structural_equal も一致する)。
+    //   - 識別子・関数名・エイリアスの ASCII の大文字を小文字にする (引用符付きは除く)、CAST の型名をカタログの正規名にする
+    //   - a > b → b < a、a >= b → b <= a
+    //   - 交換可能な演算子 (=, <>, +, *, &, |) のオペランドを構造的なハッシュの順に並べる
+    //   - 結合的な演算子 (+, *, &, |, ||) の鎖を左に深い形にし、交換可能なら全ての葉をハッシュの順に並べる
+    //   - AND / OR の入れ子を平坦化し、オペランドをハッシュの順に並べて重複を除く
+    //   - IN のリストを値の構造的なハッシュの順に並べる (リテラルの詰めた表現でも同じ順)
+    // 括弧は AST に現れない (generate() が付け直す) ため、括弧の違いはもともと AST に影響しない。
+    // 並べ替えは結果の SQL の評価順を変えるため、比較・キャッシュのキー用として使うこと
+    // (浮動小数点の丸めや整数のオーバーフローの起こり方は元の SQL と異なる場合がある)。
+    // AST を 1 回走査し、既に正規形の部分木は書き換えない (ヒープ確保なし)。
+    inline void canonicalize(Expression& e) {
+        walk(e, detail::Canonicalizer{});
+    }
+
+    inline void canonicalize(SelectStatement& stmt) {
+        walk(stmt, detail::Canonicalizer{});
+    }
+
+    // 正規化した SELECT 文の構造的なハッシュ (結果のキャッシュのキーなど)。stmt は変更しない
+    inline size_t canonical_hash(const SelectStatement& stmt, CompareOptions options = {}) {
+        SelectStatement copy = stmt;
+        canonicalize(copy);
+        return structural_hash(copy, options);
+    }
+}
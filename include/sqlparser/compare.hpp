@@ -0,0 +1,544 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <boost/variant/apply_visitor.hpp>
+#include <sqlparser/ast.hpp>
+
+namespace sqlparser {
+
+    // 構造的なハッシュ・等価比較のオプション
+    struct CompareOptions {
+        // true: リテラル (数値・文字列) の値を無視し、種類だけを比較する。
+        // "WHERE id = 1" と "WHERE id = 2" が同じになる (クエリの正規化・集計用)
+        bool ignore_literals = false;
+        // true: CAST の型名の綴りも比較する (カタログで同じ型に解決される "int4" と "integer" を区別する)
+        bool exact_type_names = false;
+    };
+
+    namespace detail {
+
+        // ハッシュに混ぜるノードの種類 (Expression の which() に依存しない)
+        enum class NodeTag : uint8_t {
+            Int, Float, Identifier, String, BinaryOp, LogicalOp, UnaryOp, Cast, FunctionCall, Case,
+            Between, In, WindowFunction, Exists, None, Table, Subquery, Select
+        };
+
+        inline void hash_combine(size_t& seed, size_t value) {
+            seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+        }
+
+        // FNV-1a (文字を 1 つずつ流し込めるため、エスケープ解除した文字列もコピーせずにハッシュできる)
+        struct StringHasher {
+            uint64_t h = 14695981039346656037ull;
+            void add(wchar_t c) { h = (h ^ static_cast<uint64_t>(c)) * 1099511628211ull; }
+            void add(std::wstring_view s) { for (wchar_t c : s) add(c); }
+        };
+
+        // SQL 上の綴り ('' がエスケープされたまま) の文字をエスケープ解除しながら列挙する
+        template <typename F>
+        inline void for_each_unescaped(std::wstring_view quoted, F&& f) {
+            for (size_t i = 0; i < quoted.size(); ++i) {
+                f(quoted[i]);
+                if (quoted[i] == L'\'' && i + 1 < quoted.size() && quoted[i + 1] == L'\'') ++i;
+            }
+        }
+
+        // 文字列リテラルの中身 (value / source / LiteralList の綴り) の比較
+        struct StringContent {
+            std::wstring_view text;
+            bool escaped; // text が '' をエスケープしたままか
+
+            static StringContent of(const ast::StringLiteral& s) {
+                return s.is_view() ? StringContent{ s.source, true } : StringContent{ s.value.view(), false };
+            }
+
+            size_t hash() const {
+                StringHasher hasher;
+                if (escaped) for_each_unescaped(text, [&](wchar_t c) { hasher.add(c); });
+                else hasher.add(text);
+                return static_cast<size_t>(hasher.h);
+            }
+
+            friend bool operator==(const StringContent& a, const StringContent& b) {
+                if (a.escaped == b.escaped) return a.text == b.text;
+                const StringContent& e = a.escaped ? a : b;
+                std::wstring_view plain = a.escaped ? b.text : a.text;
+                size_t j = 0;
+                bool same = true;
+                for_each_unescaped(e.text, [&](wchar_t c) {
+                    if (same) same = j < plain.size() && plain[j++] == c;
+                });
+                return same && j == plain.size();
+            }
+        };
+
+        // LiteralList の 1 要素を Expression の要素と同じ形で扱うための参照
+        struct LiteralRef {
+            NodeTag tag;
+            std::wstring_view text; // Int / Float: 綴り、String: 中身
+            bool escaped = false;
+        };
+
+        // INT の要素は 10 進表記にして IntLiteral と比較する (固定長バッファなので確保なし)
+        struct IntText {
+            wchar_t buf[24];
+            std::wstring_view view;
+            explicit IntText(int64_t v) {
+                int n = std::swprintf(buf, 24, L"%lld", static_cast<long long>(v));
+                view = std::wstring_view(buf, n > 0 ? static_cast<size_t>(n) : 0);
+            }
+        };
+
+        inline NodeTag numeric_tag(std::wstring_view text) {
+            return text.find(L'.') != std::wstring_view::npos ? NodeTag::Float : NodeTag::Int;
+        }
+
+        // 子を持つノード (参照カウントで共有できるノード) の場所。それ以外は nullptr
+        inline const void* node_address(const ast::Expression& e) {
+            return boost::apply_visitor([](auto const& node) -> const void* {
+                if constexpr (ast::is_shared_node<std::decay_t<decltype(node)>>) {
+                    return &node;
+                } else {
+                    return nullptr;
+                }
+            }, e);
+        }
+
+        // ノードの場所 (node_address) から計算済みのハッシュ値を引く表
+        using NodeHashes = std::unordered_map<const void*, size_t>;
+
+        class StructuralHash {
+        public:
+            using result_type = size_t;
+
+            explicit StructuralHash(CompareOptions options) : options_(options) {}
+            // known に載っているノードは子をたどらずにその値を使う (部分木ごとに 1 回だけハッシュを計算する場合)
+            StructuralHash(CompareOptions options, const NodeHashes* known) : options_(options), known_(known) {}
+
+            size_t operator()(const ast::Expression& e) const {
+                if (known_) {
+                    if (const void* node = node_address(e)) {
+                        if (auto it = known_->find(node); it != known_->end()) return it->second;
+                    }
+                }
+                return boost::apply_visitor(*this, e);
+            }
+
+            size_t operator()(const ast::IntLiteral& v) const { return literal(NodeTag::Int, v.text.view()); }
+            size_t operator()(const ast::FloatLiteral& v) const { return literal(NodeTag::Float, v.text.view()); }
+            size_t operator()(const Identifier& id) const {
+                size_t h = tag(NodeTag::Identifier);
+                hash_combine(h, std::hash<Identifier>()(id));
+                return h;
+            }
+            size_t operator()(const ast::StringLiteral& s) const { return string(StringContent::of(s)); }
+
+            size_t operator()(const ast::BinaryOp& op) const {
+                size_t h = tag(NodeTag::BinaryOp);
+                hash_combine(h, static_cast<size_t>(op.op));
+                hash_combine(h, (*this)(op.left));
+                hash_combine(h, (*this)(op.right));
+                return h;
+            }
+
+            size_t operator()(const ast::LogicalOp& op) const {
+                size_t h = tag(NodeTag::LogicalOp);
+                hash_combine(h, static_cast<size_t>(op.op));
+                for (auto const& operand : op.operands) hash_combine(h, (*this)(operand));
+                return h;
+            }
+
+            size_t operator()(const ast::UnaryOp& op) const {
+                size_t h = tag(NodeTag::UnaryOp);
+                hash_combine(h, static_cast<size_t>(op.op));
+                hash_combine(h, (*this)(op.expr));
+                return h;
+            }
+
+            size_t operator()(const ast::Cast& cast) const {
+                size_t h = tag(NodeTag::Cast);
+                hash_combine(h, (*this)(cast.expr));
+                hash_combine(h, static_cast<size_t>(cast.type.id));
+                hash_combine(h, static_cast<size_t>(static_cast<uint32_t>(cast.type.precision)));
+                hash_combine(h, static_cast<size_t>(static_cast<uint32_t>(cast.type.scale)));
+                hash_combine(h, cast.type.array_dims);
+                if (options_.exact_type_names || compares_type_name(cast)) {
+                    hash_combine(h, std::hash<std::wstring_view>()(cast.type_name.view()));
+                }
+                return h;
+            }
+
+            size_t operator()(const ast::FunctionCall& func) const {
+                size_t h = tag(NodeTag::FunctionCall);
+                hash_combine(h, std::hash<Identifier>()(func.name));
+                for (auto const& arg : func.args) hash_combine(h, (*this)(arg));
+                return h;
+            }
+
+            size_t operator()(const ast::Case& c) const {
+                size_t h = tag(NodeTag::Case);
+                hash_combine(h, optional(c.arg));
+                for (auto const& w : c.when_clauses) {
+                    hash_combine(h, (*this)(w.when));
+                    hash_combine(h, (*this)(w.then));
+                }
+                hash_combine(h, optional(c.else_result));
+                return h;
+            }
+
+            size_t operator()(const ast::Between& b) const {
+                size_t h = tag(NodeTag::Between);
+                hash_combine(h, (*this)(b.expr));
+                hash_combine(h, (*this)(b.lower));
+                hash_combine(h, (*this)(b.upper));
+                hash_combine(h, b.not_between);
+                return h;
+            }
+
+            // values と literals のどちらに格納されていても同じ値になる
+            size_t operator()(const ast::In& in) const {
+                size_t h = tag(NodeTag::In);
+                hash_combine(h, (*this)(in.expr));
+                hash_combine(h, in.not_in);
+                hash_combine(h, in.size());
+                for (size_t i = 0; i < in.size(); ++i) hash_combine(h, element(in, i));
+                return h;
+            }
+
+            // IN のリストの i 番目の値のハッシュ (values と literals のどちらに格納されていても、その値の式のハッシュと同じ)
+            size_t element(const ast::In& in, size_t i) const {
+                if (!in.values.empty()) return (*this)(in.values[i]);
+                auto const& list = in.literals;
+                switch (list.kind) {
+                case ast::LiteralList::Kind::INT:
+                    return literal(NodeTag::Int, IntText(list.int_at(i)).view);
+                case ast::LiteralList::Kind::NUMERIC:
+                    return literal(numeric_tag(list.string_at(i)), list.string_at(i));
+                default:
+                    return string(StringContent{ list.string_at(i), true });
+                }
+            }
+
+            size_t operator()(const ast::WindowFunction& wf) const {
+                size_t h = tag(NodeTag::WindowFunction);
+                hash_combine(h, (*this)(wf.func));
+                for (auto const& e : wf.window.partitionBy) hash_combine(h, (*this)(e));
+                for (auto const& o : wf.window.orderBy) hash_combine(h, (*this)(o));
+                return h;
+            }
+
+            size_t operator()(const ast::Exists& e) const {
+                size_t h = tag(NodeTag::Exists);
+                hash_combine(h, (*this)(e.subquery.get()));
+                return h;
+            }
+
+            size_t operator()(const ast::OrderByElement& o) const {
+                size_t h = std::hash<Identifier>()(o.column);
+                hash_combine(h, static_cast<size_t>(o.direction));
+                return h;
+            }
+
+            size_t operator()(const ast::Table& t) const {
+                size_t h = tag(NodeTag::Table);
+                hash_combine(h, std::hash<Identifier>()(t.name));
+                hash_combine(h, optional(t.alias));
+                return h;
+            }
+
+            size_t operator()(const ast::Subquery& s) const {
+                size_t h = tag(NodeTag::Subquery);
+                hash_combine(h, (*this)(s.select.get()));
+                hash_combine(h, optional(s.alias));
+                return h;
+            }
+
+            size_t operator()(const ast::SelectStatement& s) const {
+                size_t h = tag(NodeTag::Select);
+                hash_combine(h, static_cast<size_t>(s.quantifier));
+                for (auto const& col : s.columns) {
+                    hash_combine(h, (*this)(col.expr));
+                    hash_combine(h, optional(col.alias));
+                }
+                hash_combine(h, boost::apply_visitor(*this, s.table));
+                for (auto const& j : s.joins) {
+                    hash_combine(h, static_cast<size_t>(j.type));
+                    hash_combine(h, j.natural);
+                    hash_combine(h, boost::apply_visitor(*this, j.table));
+                    hash_combine(h, optional(j.on));
+                    for (auto const& c : j.using_columns) hash_combine(h, std::hash<Identifier>()(c));
+                }
+                hash_combine(h, optional(s.where));
+                for (auto const& g : s.groupBy) hash_combine(h, (*this)(g));
+                hash_combine(h, optional(s.having));
+                for (auto const& o : s.orderBy) hash_combine(h, (*this)(o));
+                hash_combine(h, optional(s.limit));
+                hash_combine(h, optional(s.offset));
+                for (auto const& u : s.unions) {
+                    hash_combine(h, static_cast<size_t>(u.type));
+                    hash_combine(h, (*this)(u.select.get()));
+                }
+                return h;
+            }
+
+            // INTERVAL の fields やカタログにない型は綴りでしか区別できない
+            static bool compares_type_name(const ast::Cast& cast) {
+                return cast.type.id == TypeId::UNKNOWN || cast.type.id == TypeId::INTERVAL;
+            }
+
+        private:
+            static size_t tag(NodeTag t) { return static_cast<size_t>(t) * 0x100000001b3ull; }
+
+            size_t literal(NodeTag t, std::wstring_view text) const {
+                size_t h = tag(t);
+                if (!options_.ignore_literals) hash_combine(h, std::hash<std::wstring_view>()(text));
+                return h;
+            }
+
+            size_t string(const StringContent& s) const {
+                size_t h = tag(NodeTag::String);
+                if (!options_.ignore_literals) hash_combine(h, s.hash());
+                return h;
+            }
+
+            size_t optional(const boost::optional<ast::Expression>& e) const { return e ? (*this)(*e) : tag(NodeTag::None); }
+            size_t optional(const boost::optional<Identifier>& id) const { return id ? std::hash<Identifier>()(*id) : tag(NodeTag::None); }
+
+            CompareOptions options_;
+            const NodeHashes* known_ = nullptr;
+        };
+
+        class StructuralEqual {
+        public:
+            explicit StructuralEqual(CompareOptions options) : options_(options) {}
+
+            bool operator()(const ast::Expression& a, const ast::Expression& b) const {
+                if (a.which() != b.which()) return false;
+                return boost::apply_visitor(Dispatch{ this, &b }, a);
+            }
+
+            bool operator()(const ast::IntLiteral& a, const ast::IntLiteral& b) const { return literal(a.text.view(), b.text.view()); }
+            bool operator()(const ast::FloatLiteral& a, const ast::FloatLiteral& b) const { return literal(a.text.view(), b.text.view()); }
+            bool operator()(const Identifier& a, const Identifier& b) const { return a == b; }
+            bool operator()(const ast::StringLiteral& a, const ast::StringLiteral& b) const {
+                return options_.ignore_literals || StringContent::of(a) == StringContent::of(b);
+            }
+
+            bool operator()(const ast::BinaryOp& a, const ast::BinaryOp& b) const {
+                return a.op == b.op && (*this)(a.left, b.left) && (*this)(a.right, b.right);
+            }
+
+            bool operator()(const ast::LogicalOp& a, const ast::LogicalOp& b) const {
+                return a.op == b.op && range(a.operands, b.operands);
+            }
+
+            bool operator()(const ast::UnaryOp& a, const ast::UnaryOp& b) const {
+                return a.op == b.op && (*this)(a.expr, b.expr);
+            }
+
+            bool operator()(const ast::Cast& a, const ast::Cast& b) const {
+                return a.type == b.type
+                    && (!(options_.exact_type_names || StructuralHash::compares_type_name(a)) || a.type_name == b.type_name)
+                    && (*this)(a.expr, b.expr);
+            }
+
+            bool operator()(const ast::FunctionCall& a, const ast::FunctionCall& b) const {
+                return a.name == b.name && range(a.args, b.args);
+            }
+
+            bool operator()(const ast::Case& a, const ast::Case& b) const {
+                if (a.when_clauses.size() != b.when_clauses.size()) return false;
+                if (!optional(a.arg, b.arg) || !optional(a.else_result, b.else_result)) return false;
+                for (size_t i = 0; i < a.when_clauses.size(); ++i) {
+                    if (!(*this)(a.when_clauses[i].when, b.when_clauses[i].when)) return false;
+                    if (!(*this)(a.when_clauses[i].then, b.when_clauses[i].then)) return false;
+                }
+                return true;
+            }
+
+            bool operator()(const ast::Between& a, const ast::Between& b) const {
+                return a.not_between == b.not_between && (*this)(a.expr, b.expr)
+                    && (*this)(a.lower, b.lower) && (*this)(a.upper, b.upper);
+            }
+
+            bool operator()(const ast::In& a, const ast::In& b) const {
+                if (a.not_in != b.not_in || a.size() != b.size() || !(*this)(a.expr, b.expr)) return false;
+                bool a_list = a.values.empty();
+                bool b_list = b.values.empty();
+                if (!a_list && !b_list) return range(a.values, b.values);
+                if (a_list && b_list && a.literals.kind == b.literals.kind) {
+                    if (a.literals.kind == ast::LiteralList::Kind::INT) {
+                        return options_.ignore_literals || a.literals.ints == b.literals.ints;
+                    }
+                    if (!options_.ignore_literals) return a.literals.ends == b.literals.ends && a.literals.chars == b.literals.chars;
+                    if (a.literals.kind == ast::LiteralList::Kind::STRING) return true;
+                }
+                // 表現が異なる場合は要素ごとに比較する
+                for (size_t i = 0; i < a.size(); ++i) {
+                    if (a_list && b_list) {
+                        if (!literal_ref(a.literals, i, [&](const LiteralRef& x) {
+                            return literal_ref(b.literals, i, [&](const LiteralRef& y) { return same(x, y); });
+                        })) return false;
+                    } else {
+                        const ast::In& list = a_list ? a : b;
+                        const ast::Expression& value = a_list ? b.values[i] : a.values[i];
+                        if (!literal_ref(list.literals, i, [&](const LiteralRef& x) { return same(x, value); })) return false;
+                    }
+                }
+                return true;
+            }
+
+            bool operator()(const ast::WindowFunction& a, const ast::WindowFunction& b) const {
+                if (!(*this)(a.func, b.func) || !range(a.window.partitionBy, b.window.partitionBy)) return false;
+                if (a.window.orderBy.size() != b.window.orderBy.size()) return false;
+                for (size_t i = 0; i < a.window.orderBy.size(); ++i) {
+                    if (!(*this)(a.window.orderBy[i], b.window.orderBy[i])) return false;
+                }
+                return true;
+            }
+
+            bool operator()(const ast::Exists& a, const ast::Exists& b) const { return (*this)(a.subquery.get(), b.subquery.get()); }
+
+            bool operator()(const ast::OrderByElement& a, const ast::OrderByElement& b) const {
+                return a.column == b.column && a.direction == b.direction;
+            }
+
+            bool operator()(const ast::TableReference& a, const ast::TableReference& b) const {
+                if (a.which() != b.which()) return false;
+                if (auto* t = boost::get<ast::Table>(&a)) {
+                    auto const& u = boost::get<ast::Table>(b);
+                    return t->name == u.name && t->alias == u.alias;
+                }
+                auto const& s = boost::get<ast::Subquery>(a);
+                auto const& r = boost::get<ast::Subquery>(b);
+                return s.alias == r.alias && (*this)(s.select.get(), r.select.get());
+            }
+
+            bool operator()(const ast::SelectStatement& a, const ast::SelectStatement& b) const {
+                if (a.quantifier != b.quantifier || a.columns.size() != b.columns.size() || a.joins.size() != b.joins.size()
+                    || a.orderBy.size() != b.orderBy.size() || a.unions.size() != b.unions.size()) return false;
+                for (size_t i = 0; i < a.columns.size(); ++i) {
+                    if (a.columns[i].alias != b.columns[i].alias || !(*this)(a.columns[i].expr, b.columns[i].expr)) return false;
+                }
+                if (!(*this)(a.table, b.table)) return false;
+                for (size_t i = 0; i < a.joins.size(); ++i) {
+                    auto const& x = a.joins[i];
+                    auto const& y = b.joins[i];
+                    if (x.type != y.type || x.natural != y.natural || x.using_columns != y.using_columns) return false;
+                    if (!(*this)(x.table, y.table) || !optional(x.on, y.on)) return false;
+                }
+                if (!optional(a.where, b.where) || !range(a.groupBy, b.groupBy) || !optional(a.having, b.having)) return false;
+                for (size_t i = 0; i < a.orderBy.size(); ++i) {
+                    if (!(*this)(a.orderBy[i], b.orderBy[i])) return false;
+                }
+                if (!optional(a.limit, b.limit) || !optional(a.offset, b.offset)) return false;
+                for (size_t i = 0; i < a.unions.size(); ++i) {
+                    if (a.unions[i].type != b.unions[i].type || !(*this)(a.unions[i].select.get(), b.unions[i].select.get())) return false;
+                }
+                return true;
+            }
+
+        private:
+            // a と同じ型であることを確認済みの b と比較する
+            // 共有されている同じノード (shared_node.hpp) は子をたどらずに等しいとする
+            struct Dispatch {
+                using result_type = bool;
+                const StructuralEqual* self;
+                const ast::Expression* other;
+                template <typename T>
+                bool operator()(const T& a) const {
+                    const T& b = boost::get<T>(*other);
+                    return &a == &b || (*self)(a, b);
+                }
+            };
+
+            bool literal(std::wstring_view a, std::wstring_view b) const { return options_.ignore_literals || a == b; }
+
+            bool range(const std::vector<ast::Expression>& a, const std::vector<ast::Expression>& b) const {
+                if (a.size() != b.size()) return false;
+                for (size_t i = 0; i < a.size(); ++i) {
+                    if (!(*this)(a[i], b[i])) return false;
+                }
+                return true;
+            }
+
+            bool optional(const boost::optional<ast::Expression>& a, const boost::optional<ast::Expression>& b) const {
+                if (!a || !b) return !a && !b;
+                return (*this)(*a, *b);
+            }
+
+            // LiteralList の i 番目を LiteralRef にして f に渡す
+            template <typename F>
+            static bool literal_ref(const ast::LiteralList& list, size_t i, F&& f) {
+                switch (list.kind) {
+                case ast::LiteralList::Kind::INT: {
+                    IntText text(list.int_at(i));
+                    return f(LiteralRef{ NodeTag::Int, text.view });
+                }
+                case ast::LiteralList::Kind::NUMERIC:
+                    return f(LiteralRef{ numeric_tag(list.string_at(i)), list.string_at(i) });
+                case ast::LiteralList::Kind::STRING:
+                    return f(LiteralRef{ NodeTag::String, list.string_at(i), true });
+                }
+                return false;
+            }
+
+            bool same(const LiteralRef& a, const LiteralRef& b) const {
+                if (a.tag != b.tag) return false;
+                if (options_.ignore_literals) return true;
+                if (a.tag == NodeTag::String) return StringContent{ a.text, a.escaped } == StringContent{ b.text, b.escaped };
+                return a.text == b.text;
+            }
+
+            bool same(const LiteralRef& a, const ast::Expression& e) const {
+                if (auto* v = boost::get<ast::IntLiteral>(&e)) return same(a, LiteralRef{ NodeTag::Int, v->text.view() });
+                if (auto* v = boost::get<ast::FloatLiteral>(&e)) return same(a, LiteralRef{ NodeTag::Float, v->text.view() });
+                if (auto* v = boost::get<ast::StringLiteral>(&e)) {
+                    StringContent c = StringContent::of(*v);
+                    return same(a, LiteralRef{ NodeTag::String, c.text, c.escaped });
+                }
+                return false;
+            }
+
+            CompareOptions options_;
+        };
+    }
+
+    // 式・SELECT 文の構造的なハッシュ
+    // AST を 1 回走査するだけでヒープ確保は行わない。structural_equal() で等しいものは同じ値になる。
+    inline size_t structural_hash(const ast::Expression& e, CompareOptions options = {}) {
+        return detail::StructuralHash(options)(e);
+    }
+    inline size_t structural_hash(const ast::SelectStatement& s, CompareOptions options = {}) {
+        return detail::StructuralHash(options)(s);
+    }
+
+    // 式・SELECT 文の構造的な等価比較 (ヒープ確保なし)
+    // 全てのノードの種類・演算子・子を比較する。識別子は綴りが完全に一致するものだけを等しいとみなす。
+    // 文字列リテラルのビューモードの違い、IN リストの格納形式 (values / literals) の違い、
+    // カタログで解決された型名の綴りの違い ("int4" と "integer") は無視する。
+    inline bool structural_equal(const ast::Expression& a, const ast::Expression& b, CompareOptions options = {}) {
+        return detail::StructuralEqual(options)(a, b);
+    }
+    inline bool structural_equal(const ast::SelectStatement& a, const ast::SelectStatement& b, CompareOptions options = {}) {
+        return detail::StructuralEqual(options)(a, b);
+    }
+
+    // std::unordered_map などのキー用の関数オブジェクト
+    // 例: std::unordered_map<ast::SelectStatement, int, StructuralHasher, StructuralEqualTo>
+    struct StructuralHasher {
+        CompareOptions options;
+        size_t operator()(const ast::Expression& e) const { return structural_hash(e, options); }
+        size_t operator()(const ast::SelectStatement& s) const { return structural_hash(s, options); }
+    };
+
+    struct StructuralEqualTo {
+        CompareOptions options;
+        bool operator()(const ast::Expression& a, const ast::Expression& b) const { return structural_equal(a, b, options); }
+        bool operator()(const ast::SelectStatement& a, const ast::SelectStatement& b) const { return structural_equal(a, b, options); }
+    };
+}
@@ -1,8 +1,22 @@
 #pragma once
 #include <string>
+#include <sqlparser/small_string.hpp>
+
+// SQLPARSER_INTERN_IDENTIFIERS を定義すると、識別子 (テーブル名・カラム名・エイリアス・関数名) が
+// グローバルなシンボル表にインターンされた 32bit の Symbol になる (symbol.hpp)
+#ifdef SQLPARSER_INTERN_IDENTIFIERS
+#include <sqlparser/symbol.hpp>
+#endif
 
 namespace sqlparser {
     // UNICODE対応のため wchar_t を使用
     using String = std::wstring;
     using Char = wchar_t;
+
+    // AST 中の識別子の型 (既定では短い名前をインラインで保持する SmallString)
+#ifdef SQLPARSER_INTERN_IDENTIFIERS
+    using Identifier = Symbol;
+#else
+    using Identifier = SmallString;
+#endif
 }
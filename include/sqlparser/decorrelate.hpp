@@ -0,0 +1,421 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/pushdown.hpp>
+#include <sqlparser/traverse.hpp>
+
+namespace sqlparser::ast {
+
+    // 相関サブクエリの展開の設定 (対象の DB ごとに選ぶ)
+    struct DecorrelateOptions {
+        // WHERE の EXISTS を、重複を除いた派生テーブルとの INNER JOIN (準結合) にする。
+        // 相関サブクエリを外側の行ごとに実行する DB 向け (準結合を自前で計画する DB では不要)
+        bool exists_to_join = true;
+        // WHERE の NOT EXISTS を、派生テーブルとの LEFT JOIN と "キー IS NULL" (反結合) にする
+        bool not_exists_to_join = true;
+        // 単純な派生テーブル (SELECT cols FROM t WHERE p) を外側の SELECT 文に展開する。
+        // 派生テーブルを実体化してから結合する DB 向け
+        bool flatten_derived_tables = true;
+    };
+
+    namespace detail {
+
+        // EXISTS のサブクエリ中の参照の分類 (修飾子のないカラムはサブクエリ側とみなし、unqualified で印を付ける)
+        struct CorrelationScan {
+            const PushdownSources& inner;
+            bool inner_ref = false;
+            bool outer_ref = false;
+            bool unqualified = false; // 修飾子のないカラムがある (スキーマなしではサブクエリ側か外側か決まらない)
+            bool supported = true;
+
+            Visit enter(const SelectStatement&) {
+                supported = false;
+                return Visit::Stop;
+            }
+            Visit enter(const WindowFunction&) {
+                supported = false;
+                return Visit::Stop;
+            }
+            Visit enter(const FunctionCall& call) {
+                supported = !is_volatile_function(call.name);
+                return supported ? Visit::Continue : Visit::Stop;
+            }
+            void enter(const Identifier& id) {
+                std::wstring_view name = id;
+                if (is_keyword_constant(name)) return;
+                std::wstring_view qualifier = qualifier_of(name);
+                if (qualifier.empty()) unqualified = true;
+                if (qualifier.empty() || inner.find(qualifier) >= 0) {
+                    inner_ref = true;
+                } else {
+                    outer_ref = true;
+                }
+            }
+
+            static CorrelationScan of(const PushdownSources& inner, const Expression& e) {
+                CorrelationScan scan{ inner };
+                walk(e, scan);
+                return scan;
+            }
+        };
+
+        // EXISTS のサブクエリを、相関する等値条件 (inner_keys[i] = outer_keys[i]) と、サブクエリだけで閉じた条件に分ける
+        struct SemiJoinParts {
+            std::vector<Expression> inner_keys;
+            std::vector<Expression> outer_keys;
+            std::vector<Expression> local;
+        };
+
+        inline bool split_semi_join(const SelectStatement& sub, SemiJoinParts& parts) {
+            if (!sub.unions.empty() || !sub.groupBy.empty() || sub.having || sub.limit || sub.offset || !sub.where) return false;
+            // 集約するサブクエリは常に 1 行を返すため EXISTS の意味が変わる
+            SelectListShape shape;
+            for (auto const& col : sub.columns) walk(col.expr, shape);
+            if (shape.aggregate || shape.window) return false;
+
+            // 条件は派生テーブルに移り外側のカラムが見えなくなるため、修飾子のないカラムがあれば変えない
+            // (EXISTS (... WHERE o.region = region) の region は外側の c.region かもしれない)
+            PushdownSources inner(sub);
+            for (auto const& join : sub.joins) {
+                if (!join.on) continue;
+                CorrelationScan scan = CorrelationScan::of(inner, *join.on);
+                if (!scan.supported || scan.outer_ref || scan.unqualified) return false;
+            }
+            std::vector<Expression> conjuncts;
+            split_conjuncts(*sub.where, conjuncts);
+            for (auto& c : conjuncts) {
+                CorrelationScan scan = CorrelationScan::of(inner, c);
+                if (!scan.supported || scan.unqualified) return false;
+                if (!scan.outer_ref) {
+                    parts.local.push_back(std::move(c));
+                    continue;
+                }
+                auto const* eq = boost::get<BinaryOp>(&c);
+                if (!eq || eq->op != OpType::EQ) return false;
+                CorrelationScan left = CorrelationScan::of(inner, eq->left);
+                CorrelationScan right = CorrelationScan::of(inner, eq->right);
+                if (left.inner_ref && !left.outer_ref && right.outer_ref && !right.inner_ref) {
+                    parts.inner_keys.push_back(eq->left);
+                    parts.outer_keys.push_back(eq->right);
+                } else if (right.inner_ref && !right.outer_ref && left.outer_ref && !left.inner_ref) {
+                    parts.inner_keys.push_back(eq->right);
+                    parts.outer_keys.push_back(eq->left);
+                } else {
+                    return false;
+                }
+            }
+            return !parts.inner_keys.empty();
+        }
+
+        inline Identifier qualified_name(std::wstring_view qualifier, std::wstring_view column) {
+            String name;
+            name.reserve(qualifier.size() + 1 + column.size());
+            name.append(qualifier).append(1, L'.').append(column);
+            return Identifier(name);
+        }
+
+        // 派生テーブルの出力カラム (名前と、外側のエイリアスで修飾し直した式)
+        struct DerivedColumn {
+            std::wstring_view name;
+            Expression expr;
+            bool plain = false; // 修飾し直した式がそのまま "alias.name" であるか
+        };
+
+        // 派生テーブル内の式のカラム参照を外側のエイリアスで修飾し直す
+        struct Requalifier {
+            const Table& table;
+            std::wstring_view alias;
+            bool ok = true;
+
+            bool is_inner(std::wstring_view qualifier) const {
+                IgnoreCaseEqual iequal;
+                if (table.alias) return iequal(*table.alias, qualifier);
+                std::wstring_view name = table.name;
+                return iequal(name, qualifier) || iequal(column_of(name), qualifier);
+            }
+
+            Visit enter(SelectStatement&) {
+                ok = false;
+                return Visit::Stop;
+            }
+            Visit enter(Identifier& id) {
+                std::wstring_view name = id;
+                if (is_keyword_constant(name)) return Visit::Continue;
+                std::wstring_view qualifier = qualifier_of(name);
+                if (!qualifier.empty() && !is_inner(qualifier)) {
+                    ok = false;
+                    return Visit::Stop;
+                }
+                id = qualified_name(alias, column_of(name));
+                return Visit::Continue;
+            }
+        };
+
+        // 外側の SELECT 文で "alias.name" を派生テーブルの出力カラムの式に置き換える
+        // apply が false なら置き換えられない参照 (出力カラム以外・名前の変わる出力カラムへの修飾子のない参照、
+        // ORDER BY からの式の出力カラムへの参照、内側の SELECT 文での同じエイリアスの再定義) を探すだけ
+        struct DerivedReferenceRewriter {
+            const SelectStatement& derived; // 展開する派生テーブル (走査しない)
+            std::wstring_view alias;
+            const std::vector<DerivedColumn>& columns;
+            bool apply = false;
+            bool ok = true;
+            size_t depth = 0;
+
+            const DerivedColumn* find(std::wstring_view name) const {
+                IgnoreCaseEqual iequal;
+                for (auto const& c : columns) {
+                    if (iequal(c.name, name)) return &c;
+                }
+                return nullptr;
+            }
+
+            // 置き換えが必要な参照なら出力カラムを返す
+            const DerivedColumn* target(std::wstring_view name) {
+                IgnoreCaseEqual iequal;
+                std::wstring_view qualifier = qualifier_of(name);
+                if (qualifier.empty()) {
+                    // 出力カラム以外の名前は、展開で見えるようになる t のカラムに解決が変わりうる
+                    // (他のテーブルのカラムが曖昧になる、外側の SELECT 文への相関参照が t のカラムになる)。
+                    // 名前が変わる出力カラムを修飾子なしで参照している場合も展開しない
+                    const DerivedColumn* c = find(name);
+                    if (!c || !(c->plain && iequal(column_of(boost::get<Identifier>(c->expr)), name))) ok = false;
+                    return nullptr;
+                }
+                if (!iequal(qualifier, alias)) return nullptr;
+                const DerivedColumn* c = find(column_of(name));
+                return c && !(c->plain && iequal(column_of(boost::get<Identifier>(c->expr)), column_of(name))) ? c : nullptr;
+            }
+
+            Visit enter(SelectStatement& stmt) {
+                if (&stmt == &derived) return Visit::Skip;
+                ++depth;
+                return Visit::Continue;
+            }
+            void leave(SelectStatement& stmt) {
+                if (&stmt != &derived) --depth;
+            }
+            void enter(Table& t) {
+                if (depth > 1 && t.alias && IgnoreCaseEqual()(*t.alias, alias)) ok = false;
+            }
+            void enter(Subquery& s) {
+                if (depth > 1 && s.alias && IgnoreCaseEqual()(*s.alias, alias)) ok = false;
+            }
+            // 置き換える選択リストの要素は元の名前をエイリアスにする (結果のカラム名を変えない)
+            void enter(ResultColumn& col) {
+                auto const* id = boost::get<Identifier>(&static_cast<const Expression&>(col.expr));
+                if (!apply || col.alias || !id || is_keyword_constant(*id)) return;
+                std::wstring_view name = *id;
+                if (target(name)) col.alias = Identifier(column_of(name));
+            }
+            void enter(OrderByElement& o) {
+                const DerivedColumn* c = target(o.column);
+                if (!c) return;
+                if (!c->plain) {
+                    ok = false;
+                } else if (apply) {
+                    o.column = boost::get<Identifier>(c->expr);
+                }
+            }
+            Visit enter_expression(Expression& e) {
+                auto const* id = boost::get<Identifier>(&static_cast<const Expression&>(e));
+                if (!id) return Visit::Continue;
+                std::wstring_view name = *id;
+                if (is_keyword_constant(name)) return Visit::Skip;
+                const DerivedColumn* c = target(name);
+                if (c && apply) e = c->expr;
+                return Visit::Skip;
+            }
+        };
+
+        struct Decorrelator {
+            const DecorrelateOptions& options;
+            size_t rewrites = 0;
+
+            // 後置順: 内側の SELECT 文 (EXISTS のサブクエリ・派生テーブル) を先に展開する
+            void leave(SelectStatement& stmt) {
+                if (options.exists_to_join || options.not_exists_to_join) rewrite_exists(stmt);
+                if (options.flatten_derived_tables) {
+                    for (size_t k = 0; k <= stmt.joins.size(); ++k) {
+                        if (flatten(stmt, k)) ++rewrites;
+                    }
+                }
+            }
+
+            // 他のテーブル参照と重ならない派生テーブルのエイリアス
+            static Identifier fresh_alias(const SelectStatement& stmt) {
+                PushdownSources sources(stmt);
+                for (size_t n = 1;; ++n) {
+                    std::wstring name = L"__exists" + std::to_wstring(n);
+                    if (sources.find(name) < 0) return Identifier(name);
+                }
+            }
+
+            void rewrite_exists(SelectStatement& stmt) {
+                const SelectStatement& view = stmt;
+                if (!view.where) return;
+                // カンマ区切りの結合の後に JOIN を追加すると、ON から前のテーブルを参照できない
+                for (auto const& join : view.joins) {
+                    if (join.type == JoinType::IMPLICIT) return;
+                }
+                std::vector<Expression> conjuncts, kept;
+                split_conjuncts(*view.where, conjuncts);
+                size_t rewritten = 0;
+                for (auto& c : conjuncts) {
+                    const Exists* exists = boost::get<Exists>(&c);
+                    bool negated = false;
+                    if (auto const* u = boost::get<UnaryOp>(&c); u && u->op == OpType::NOT) {
+                        exists = boost::get<Exists>(&u->expr);
+                        negated = true;
+                    }
+                    SemiJoinParts parts;
+                    if (!exists || !(negated ? options.not_exists_to_join : options.exists_to_join) ||
+                        !split_semi_join(exists->subquery.get(), parts)) {
+                        kept.push_back(std::move(c));
+                        continue;
+                    }
+                    Identifier alias = fresh_alias(stmt);
+                    const SelectStatement& sub = exists->subquery.get();
+
+                    // 準結合は結合先の重複で外側の行が増えないように DISTINCT にする (反結合は一致した行を捨てるため不要)
+                    SelectStatement derived;
+                    derived.quantifier = negated ? SelectQuantifier::Default : SelectQuantifier::Distinct;
+                    Join join;
+                    join.type = negated ? JoinType::LEFT : JoinType::INNER;
+                    std::vector<Expression> on;
+                    for (size_t i = 0; i < parts.inner_keys.size(); ++i) {
+                        std::wstring key = L"__k" + std::to_wstring(i + 1);
+                        derived.columns.push_back(ResultColumn{ std::move(parts.inner_keys[i]), Identifier(key) });
+                        on.push_back(Expression(BinaryOp{ OpType::EQ, qualified_name(alias, key), std::move(parts.outer_keys[i]) }));
+                    }
+                    derived.table = sub.table;
+                    derived.joins = sub.joins;
+                    derived.where = join_conjuncts(parts.local);
+                    Subquery table;
+                    table.select = std::move(derived);
+                    table.alias = alias;
+                    join.table = std::move(table);
+                    join.on = join_conjuncts(on);
+                    stmt.joins.push_back(std::move(join));
+
+                    // 反結合は一致しなかった行 (結合先のキーが NULL) だけを残す
+                    if (negated) kept.push_back(Expression(UnaryOp{ OpType::IS_NULL, qualified_name(alias, L"__k1") }));
+                    ++rewritten;
+                }
+                if (rewritten == 0) return;
+                rewrites += rewritten;
+                stmt.where = join_conjuncts(kept);
+            }
+
+            // k 番目のテーブル参照 (0 は FROM、i + 1 は joins[i]) の派生テーブルを外側に展開する
+            // 展開できるのは "SELECT cols FROM t [WHERE p]" の形 (結合・集約・DISTINCT・UNION・LIMIT などなし) で、
+            // t を派生テーブルのエイリアスで参照し直し、p をその参照の WHERE / ON に移す。
+            bool flatten(SelectStatement& stmt, size_t k) {
+                const SelectStatement& view = stmt;
+                const TableReference& ref = k == 0 ? view.table : view.joins[k - 1].table;
+                auto const* sub = boost::get<Subquery>(&ref);
+                if (!sub || !sub->alias) return false;
+                const SelectStatement& derived = sub->select.get();
+                auto const* table = boost::get<Table>(&derived.table);
+                if (!table || !derived.joins.empty() || !derived.unions.empty() || !derived.groupBy.empty() || derived.having ||
+                    !derived.orderBy.empty() || derived.limit || derived.offset ||
+                    (derived.quantifier != SelectQuantifier::Default && derived.quantifier != SelectQuantifier::All)) {
+                    return false;
+                }
+                SelectListShape shape;
+                for (auto const& col : derived.columns) walk(col.expr, shape);
+                if (shape.aggregate || shape.window || shape.volatile_function) return false;
+
+                // p の置き場所: FROM / カンマ区切りは WHERE、INNER / CROSS / LEFT JOIN の結合先はその ON
+                PushdownSources sources(view);
+                bool nullable = sources.null_extended(k);
+                const Join* join = k == 0 ? nullptr : &view.joins[k - 1];
+                if (join && (join->natural || !join->using_columns.empty())) return false;
+                bool to_on = join && (join->type == JoinType::INNER || join->type == JoinType::CROSS || join->type == JoinType::LEFT);
+                if (derived.where && !to_on && nullable) return false;
+
+                std::wstring_view alias = *sub->alias;
+                boost::optional<Expression> predicate;
+                if (derived.where) {
+                    Expression p = *derived.where;
+                    Requalifier requalify{ *table, alias };
+                    walk(p, requalify);
+                    if (!requalify.ok) return false;
+                    predicate = std::move(p);
+                }
+                std::vector<DerivedColumn> columns;
+                for (auto const& col : derived.columns) {
+                    auto const* id = boost::get<Identifier>(&col.expr);
+                    if (id && column_of(*id) == L"*") continue;
+                    DerivedColumn c;
+                    c.name = col.alias ? std::wstring_view(*col.alias) : id ? column_of(*id) : std::wstring_view();
+                    if (c.name.empty()) return false;
+                    c.expr = col.expr;
+                    Requalifier requalify{ *table, alias };
+                    walk(c.expr, requalify);
+                    if (!requalify.ok) return false;
+                    c.plain = id != nullptr;
+                    // NULL で補われる側では、式の出力カラムは NULL にならなくなる (COALESCE など)
+                    if (nullable && !c.plain) return false;
+                    columns.push_back(std::move(c));
+                }
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    for (size_t j = i + 1; j < columns.size(); ++j) {
+                        if (IgnoreCaseEqual()(columns[i].name, columns[j].name)) return false;
+                    }
+                }
+
+                // 外側の * は展開後に t の全カラムになる
+                for (auto const& col : view.columns) {
+                    auto const* id = boost::get<Identifier>(&col.expr);
+                    if (id && column_of(*id) == L"*") return false;
+                }
+                DerivedReferenceRewriter check{ derived, alias, columns };
+                walk(stmt, check);
+                if (!check.ok) return false;
+
+                Table flattened{ table->name, Identifier(alias) };
+                DerivedReferenceRewriter rewrite{ derived, alias, columns };
+                rewrite.apply = true;
+                walk(stmt, rewrite);
+                if (k == 0) {
+                    stmt.table = std::move(flattened);
+                } else {
+                    stmt.joins[k - 1].table = std::move(flattened);
+                }
+                if (predicate) {
+                    if (to_on) {
+                        and_join_on(stmt, k - 1, std::move(*predicate));
+                    } else {
+                        and_where(stmt, std::move(*predicate));
+                    }
+                }
+                return true;
+            }
+        };
+    }
+
+    // 相関サブクエリと派生テーブルの展開
+    //   - WHERE の AND の項である EXISTS / NOT EXISTS で、サブクエリの WHERE が
+    //     "サブクエリ側の式 = 外側の式" の等値条件とサブクエリだけで閉じた条件からなるものを結合にする
+    //       EXISTS     → INNER JOIN (SELECT DISTINCT キー AS __k1, ... FROM ... WHERE 閉じた条件) __exists1 ON __exists1.__k1 = 外側の式
+    //       NOT EXISTS → LEFT JOIN (同じ派生テーブル、DISTINCT なし) ... WHERE __exists1.__k1 IS NULL
+    //     サブクエリの WHERE・ON に修飾子のないカラムがある場合は、外側の参照かどうか決まらないため変えない。
+    //     集約・GROUP BY・LIMIT・UNION を含むサブクエリや、カンマ区切りの結合がある SELECT 文は変えない。
+    //   - "FROM (SELECT cols FROM t WHERE p) s" の派生テーブルを "FROM t s" にし、p を WHERE (JOIN の結合先なら ON) に移す。
+    //     外側の s.col は派生テーブルの出力カラムの式に置き換える。外側に * がある場合、
+    //     修飾子のないカラムが出力カラム以外の名前か名前の変わる出力カラムを参照している場合、
+    //     外部結合で NULL に補われる側で式の出力カラムがある場合は展開しない。
+    // 内側の SELECT 文から順に処理するため、反結合の派生テーブルは (外側の参照が修飾されていれば) 展開されて
+    // LEFT JOIN t ... ON ... WHERE t.key IS NULL になる。
+    // 書き換えた数を返す。
+    inline size_t decorrelate(SelectStatement& stmt, const DecorrelateOptions& options = {}) {
+        detail::Decorrelator decorrelator{ options };
+        walk(stmt, decorrelator);
+        return decorrelator.rewrites;
+    }
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include <boost/optional.hpp>
+#include <sqlparser/config.hpp>
+#include <sqlparser/parser.hpp>
+
+namespace sqlparser {
+
+    // extract_tables() が返す参照テーブル
+    // name / alias は extract_tables() に渡した SQL を指すビュー (SQL より長く保持しないこと)
+    struct ReferencedTable {
+        std::wstring_view name;                   // ast::Table::name に相当
+        boost::optional<std::wstring_view> alias; // ast::Table::alias に相当
+        size_t offset = 0;              // 元の SQL 内でのテーブル名の位置
+        size_t alias_offset = String::npos; // 元の SQL 内でのエイリアスの位置 (なければ npos)
+    };
+
+    namespace detail {
+        inline bool extract_select_tables(std::wstring_view sql, size_t begin, size_t end, std::vector<ReferencedTable>& out);
+        inline bool extract_from_tables(std::wstring_view sql, size_t begin, size_t end, std::vector<ReferencedTable>& out);
+
+        // [begin, end) 内の EXISTS (サブクエリ) を探して再帰する
+        inline bool extract_exists_tables(std::wstring_view sql, size_t begin, size_t end, std::vector<ReferencedTable>& out) {
+            std::wstring_view range = sql.substr(0, end);
+            size_t i = begin;
+            while (i < end) {
+                wchar_t c = range[i];
+                if (size_t skipped = parser::skip_quoted_or_comment(range, i); skipped != i) {
+                    i = skipped;
+                } else if (parser::is_identifier_char(c)) {
+                    size_t w_end = parser::scan_word(range, i);
+                    if (parser::is_iequal(range.substr(i, w_end - i), L"EXISTS")) {
+                        size_t p = parser::skip_spaces(range, w_end);
+                        if (p < end && range[p] == L'(') {
+                            size_t close = parser::find_closing_paren(range, p);
+                            if (close == std::wstring::npos) return false;
+                            if (!extract_select_tables(sql, p + 1, close, out)) return false;
+                            i = close + 1;
+                            continue;
+                        }
+                    }
+                    i = w_end;
+                } else {
+                    ++i;
+                }
+            }
+            return true;
+        }
+
+        // テーブル参照 1 つ (テーブル名 [AS] エイリアス / (サブクエリ) エイリアス)
+        inline bool extract_table_ref(std::wstring_view sql, std::wstring_view from, size_t& pos, std::vector<ReferencedTable>& out) {
+            pos = parser::skip_spaces(from, pos);
+            if (pos >= from.length()) return false;
+
+            if (from[pos] == L'(') {
+                size_t close = parser::find_closing_paren(from, pos);
+                if (close == std::wstring::npos) return false;
+                std::wstring_view inner = parser::trim_sql(from.substr(pos + 1, close - pos - 1));
+                size_t first_word_end = parser::scan_word(inner, 0);
+                if (parser::is_iequal(inner.substr(0, first_word_end), L"SELECT")) {
+                    // 派生テーブル
+                    if (!extract_select_tables(sql, pos + 1, close, out)) return false;
+                } else {
+                    // 括弧で囲まれた JOIN
+                    if (!extract_from_tables(sql, pos + 1, close, out)) return false;
+                }
+                pos = close + 1;
+                // 派生テーブルのエイリアスは読み飛ばす
+                size_t p = parser::skip_spaces(from, pos);
+                size_t w = parser::scan_word(from, p);
+                if (parser::is_iequal(from.substr(p, w - p), L"AS")) {
+                    p = parser::skip_spaces(from, w);
+                    w = parser::scan_word(from, p);
+                }
+                if (w > p && !parser::is_alias_stop_word(from.substr(p, w - p))) pos = w;
+                return true;
+            }
+
+            size_t name_end = parser::scan_word(from, pos);
+            if (name_end == pos) return false;
+
+            ReferencedTable table;
+            table.name = from.substr(pos, name_end - pos);
+            table.offset = pos;
+            pos = name_end;
+
+            // エイリアス
+            size_t p = parser::skip_spaces(from, pos);
+            size_t w = parser::scan_word(from, p);
+            if (parser::is_iequal(from.substr(p, w - p), L"AS")) {
+                p = parser::skip_spaces(from, w);
+                w = parser::scan_word(from, p);
+                if (w == p) return false;
+            } else if (parser::is_alias_stop_word(from.substr(p, w - p))) {
+                w = p;
+            }
+            if (w > p) {
+                table.alias = from.substr(p, w - p);
+                table.alias_offset = p;
+                pos = w;
+            }
+
+            out.push_back(std::move(table));
+            return true;
+        }
+
+        // FROM 句本体 [begin, end): テーブル参照を ',' と JOIN で連結したもの
+        inline bool extract_from_tables(std::wstring_view sql, size_t begin, size_t end, std::vector<ReferencedTable>& out) {
+            std::wstring_view from = sql.substr(0, end);
+            size_t pos = begin;
+            if (!extract_table_ref(sql, from, pos, out)) return false;
+
+            while (true) {
+                pos = parser::skip_spaces(from, pos);
+                if (pos >= end) return true;
+
+                if (from[pos] == L',') {
+                    ++pos;
+                    if (!extract_table_ref(sql, from, pos, out)) return false;
+                    continue;
+                }
+
+                parser::JoinKeyword jk;
+                if (!parser::match_join_keyword(from, pos, jk)) return false;
+                pos = jk.end;
+                if (!extract_table_ref(sql, from, pos, out)) return false;
+
+                // ON 条件 / USING (...)
+                size_t p = parser::skip_spaces(from, pos);
+                size_t w = parser::scan_word(from, p);
+                std::wstring_view word = from.substr(p, w - p);
+                if (parser::is_iequal(word, L"ON")) {
+                    size_t cond_end = parser::find_join_condition_end(from, w);
+                    if (!extract_exists_tables(sql, w, cond_end, out)) return false;
+                    pos = cond_end;
+                } else if (parser::is_iequal(word, L"USING")) {
+                    p = parser::skip_spaces(from, w);
+                    if (p >= end || from[p] != L'(') return false;
+                    size_t close = parser::find_closing_paren(from, p);
+                    if (close == std::wstring::npos) return false;
+                    pos = close + 1;
+                }
+            }
+        }
+
+        // SELECT 文 [begin, end) (UNION を含む)
+        inline bool extract_select_tables(std::wstring_view sql, size_t begin, size_t end, std::vector<ReferencedTable>& out) {
+            std::wstring_view whole = sql.substr(begin, end - begin);
+            std::wstring_view stmt = parser::trim_sql(whole);
+            if (stmt.empty()) return false;
+            size_t base = begin + static_cast<size_t>(stmt.data() - whole.data());
+
+            parser::ClauseRanges ranges;
+            if (!parser::scan_clauses(stmt, ranges)) return false;
+
+            if (ranges.from.present()) {
+                if (!extract_from_tables(sql, base + ranges.from.begin, base + ranges.from.end, out)) return false;
+            }
+            for (auto const& r : { ranges.header, ranges.where, ranges.groupBy, ranges.having,
+                                   ranges.orderBy, ranges.limit, ranges.offset }) {
+                if (r.present() && !extract_exists_tables(sql, base + r.begin, base + r.end, out)) return false;
+            }
+            if (ranges.union_rest.present()) {
+                return extract_select_tables(sql, base + ranges.union_rest.begin, base + ranges.union_rest.end, out);
+            }
+            return true;
+        }
+    }
+
+    // SQL が参照するテーブル (FROM, JOIN, 派生テーブル, EXISTS サブクエリ) を列挙する
+    // 句スキャナと JOIN スキャナだけを使い、Expression ノードは一切構築しない。
+    // 結果は SQL 内の出現順 (offset 昇順)。名前は sql を指すビューで、ヒープ確保は tables の伸長だけ。
+    inline bool extract_tables(std::wstring_view sql, std::vector<ReferencedTable>& tables) {
+        tables.clear();
+        if (!detail::extract_select_tables(sql, 0, sql.length(), tables)) return false;
+        std::sort(tables.begin(), tables.end(),
+                  [](ReferencedTable const& a, ReferencedTable const& b) { return a.offset < b.offset; });
+        return true;
+    }
+}
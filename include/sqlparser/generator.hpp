@@ -1,7 +1,6 @@
 #pragma once
 #include <sqlparser/ast.hpp>
 #include <sstream>
-#include <iomanip>
 #include <boost/variant/apply_visitor.hpp>
 
 namespace sqlparser {
@@ -14,22 +13,33 @@ namespace sqlparser {
         std::wostream& os;
         ExpressionPrinter(std::wostream& os) : os(os) {}
 
+        // 数値リテラルは元の綴りをそのまま出力する (数値への変換・再整形はしない)
         void operator()(const ast::IntLiteral& i) const {
-            // os << i.value;
-            os << i.value; // Reverted debug print idea to keep output clean, but I know it is IntLiteral
+            os << i.text;
         }
 
         void operator()(const ast::FloatLiteral& f) const {
-            // 桁落ちを避けつつ、末尾の余分な0は付けない (defaultfloat の丸め表示)
-            os << std::setprecision(15) << f.value;
+            os << f.text;
         }
 
-        void operator()(const String& s) const {
+        void operator()(const Identifier& s) const {
             os << s;
         }
 
         void operator()(const ast::StringLiteral& s) const {
-            os << L"'" << s.value << L"'";
+            os << L"'";
+            if (s.is_view()) {
+                // 入力の綴りをそのまま出力する ('' はエスケープ済み)
+                os << s.source;
+            } else if (s.value.view().find(L'\'') == std::wstring_view::npos) {
+                os << s.value;
+            } else {
+                for (wchar_t c : s.value) {
+                    if (c == L'\'') os << L'\'';
+                    os << c;
+                }
+            }
+            os << L"'";
         }
 
         void operator()(const ast::UnaryOp& op) const {
@@ -87,6 +97,17 @@ namespace sqlparser {
             os << L")";
         }
 
+        void operator()(const ast::LogicalOp& op) const {
+            // n 項をまとめて 1 組の括弧で出力する: (a AND b AND c)
+            const wchar_t* sep = op.op == ast::OpType::OR ? L" OR " : L" AND ";
+            os << L"(";
+            for (size_t i = 0; i < op.operands.size(); ++i) {
+                if (i > 0) os << sep;
+                boost::apply_visitor(*this, op.operands[i]);
+            }
+            os << L")";
+        }
+
         void operator()(const ast::Cast& cast) const {
             os << L"CAST(";
             boost::apply_visitor(*this, cast.expr);
@@ -145,6 +166,9 @@ namespace sqlparser {
             } else {
                 os << L" IN (";
             }
+            if (in.values.empty()) {
+                print_literals(in.literals);
+            }
             for (size_t i = 0; i < in.values.size(); ++i) {
                 boost::apply_visitor(*this, in.values[i]);
                 if (i < in.values.size() - 1) {
@@ -154,6 +178,32 @@ namespace sqlparser {
             os << L"))";
         }
 
+        // LiteralList は Visitor を経由せず、ロケール処理も通さずに直接書き出す
+        void print_literals(const ast::LiteralList& list) const {
+            if (list.kind == ast::LiteralList::Kind::INT) {
+                wchar_t buf[24];
+                for (size_t i = 0; i < list.size(); ++i) {
+                    wchar_t* end = buf + 24;
+                    wchar_t* p = end;
+                    int64_t v = list.int_at(i);
+                    uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+                    do { *--p = static_cast<wchar_t>(L'0' + u % 10); u /= 10; } while (u != 0);
+                    if (v < 0) *--p = L'-';
+                    if (i > 0) { *--p = L' '; *--p = L','; }
+                    os.write(p, end - p);
+                }
+            } else {
+                bool quoted = list.kind == ast::LiteralList::Kind::STRING;
+                for (size_t i = 0; i < list.size(); ++i) {
+                    if (i > 0) os.write(L", ", 2);
+                    std::wstring_view s = list.string_at(i);
+                    if (quoted) os.put(L'\'');
+                    os.write(s.data(), static_cast<std::streamsize>(s.size()));
+                    if (quoted) os.put(L'\'');
+                }
+            }
+        }
+
         void operator()(const ast::Exists& e) const {
             os << L"EXISTS (";
             os << generate(e.subquery.get());
@@ -251,15 +301,30 @@ namespace sqlparser {
         // JOIN句の生成
         TableReferencePrinter tablePrinter(ss); // JOIN句でも使うのでここで定義
         for (const auto& join : ast.joins) {
+            if (join.natural) ss << L" NATURAL";
             switch (join.type) {
                 case ast::JoinType::INNER: ss << L" INNER JOIN "; break;
                 case ast::JoinType::LEFT:  ss << L" LEFT JOIN "; break;
                 case ast::JoinType::RIGHT: ss << L" RIGHT JOIN "; break;
                 case ast::JoinType::FULL:  ss << L" FULL JOIN "; break;
+                case ast::JoinType::CROSS: ss << L" CROSS JOIN "; break;
+                case ast::JoinType::IMPLICIT:
+                    // カンマ結合は条件を書けないため、条件が付けられていれば INNER JOIN として出力する
+                    ss << (join.on || !join.using_columns.empty() ? L" INNER JOIN " : L", ");
+                    break;
             }
             boost::apply_visitor(tablePrinter, join.table);
-            ss << L" ON ";
-            boost::apply_visitor(exprPrinter, join.on);
+            if (join.on) {
+                ss << L" ON ";
+                boost::apply_visitor(exprPrinter, *join.on);
+            } else if (!join.using_columns.empty()) {
+                ss << L" USING (";
+                for (size_t i = 0; i < join.using_columns.size(); ++i) {
+                    ss << join.using_columns[i];
+                    if (i < join.using_columns.size() - 1) ss << L", ";
+                }
+                ss << L")";
+            }
         }
 
         if (ast.where) {
@@ -0,0 +1,192 @@
+#pragma once
+#include <mutex>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/parser.hpp>
+
+namespace sqlparser {
+
+    // 遅延パースされる SELECT 文
+    // 構築時には句スキャナ (parser::scan_clauses) で各句の範囲だけを記録し、
+    // 各句の AST は最初にアクセスされた時点で一度だけ生成される。
+    // FROM だけ、あるいは SELECT リストだけを参照する呼び出し側は、その句の解析コストだけを払う。
+    //
+    // アクセサはスレッドセーフ (std::call_once でメモ化) で、
+    // 句の解析に失敗した場合は nullptr を返す。
+    // 句が存在しない場合は空の optional / vector へのポインタを返す。
+    class LazySelectStatement {
+    public:
+        explicit LazySelectStatement(String sql) : sql_(std::move(sql)) {
+            stmt_ = parser::trim_sql(sql_);
+            valid_ = !stmt_.empty() && parser::scan_clauses(stmt_, ranges_);
+        }
+
+        LazySelectStatement(const LazySelectStatement&) = delete;
+        LazySelectStatement& operator=(const LazySelectStatement&) = delete;
+
+        // 句スキャンが成功したか (SELECT で始まる文か)
+        bool valid() const { return valid_; }
+
+        // 句の範囲 (trim 済み SQL 内のオフセット)
+        const parser::ClauseRanges& ranges() const { return ranges_; }
+        std::wstring_view text() const { return stmt_; }
+
+        const ast::SelectQuantifier* quantifier() const {
+            const Header* h = header();
+            return h ? &h->quantifier : nullptr;
+        }
+
+        const std::vector<ast::ResultColumn>* columns() const {
+            const Header* h = header();
+            return h ? &h->columns : nullptr;
+        }
+
+        const ast::TableReference* table() const {
+            const From* f = from();
+            return f ? &f->table : nullptr;
+        }
+
+        const std::vector<ast::Join>* joins() const {
+            const From* f = from();
+            return f ? &f->joins : nullptr;
+        }
+
+        const boost::optional<ast::Expression>* where() const {
+            return load(where_, [&](auto& out) {
+                return !ranges_.where.present() || parser::parse_expression_clause(stmt_, ranges_.where, out);
+            });
+        }
+
+        const std::vector<ast::Expression>* groupBy() const {
+            return load(groupBy_, [&](auto& out) {
+                return !ranges_.groupBy.present() || parser::parse_group_by_clause(stmt_, ranges_.groupBy, out);
+            });
+        }
+
+        const boost::optional<ast::Expression>* having() const {
+            return load(having_, [&](auto& out) {
+                return !ranges_.having.present() || parser::parse_expression_clause(stmt_, ranges_.having, out);
+            });
+        }
+
+        const std::vector<ast::OrderByElement>* orderBy() const {
+            return load(orderBy_, [&](auto& out) {
+                return !ranges_.orderBy.present() || parser::parse_order_by_clause(stmt_, ranges_.orderBy, out);
+            });
+        }
+
+        const boost::optional<ast::Expression>* limit() const {
+            return load(limit_, [&](auto& out) {
+                return !ranges_.limit.present() || parser::parse_expression_clause(stmt_, ranges_.limit, out);
+            });
+        }
+
+        const boost::optional<ast::Expression>* offset() const {
+            return load(offset_, [&](auto& out) {
+                return !ranges_.offset.present() || parser::parse_expression_clause(stmt_, ranges_.offset, out);
+            });
+        }
+
+        // UNION 句 (右側の SELECT は通常の parse() で一括解析する)
+        const std::vector<ast::UnionClause>* unions() const {
+            return load(unions_, [&](auto& out) {
+                if (!ranges_.union_rest.present()) return true;
+                const auto* cols = columns();
+                if (!cols) return false;
+
+                ast::SelectStatement right_ast;
+                if (!parser::parse(stmt_.substr(ranges_.union_rest.begin, ranges_.union_rest.end - ranges_.union_rest.begin), right_ast)) return false;
+                if (cols->size() != right_ast.columns.size()) return false;
+
+                ast::UnionClause union_clause;
+                union_clause.type = ranges_.union_type;
+                union_clause.select = std::move(right_ast);
+                out.push_back(std::move(union_clause));
+                return true;
+            });
+        }
+
+        // 全ての句を解析して SelectStatement を組み立てる
+        bool materialize(ast::SelectStatement& ast) const {
+            if (!valid_) return false;
+            auto const* q = quantifier();
+            auto const* cols = columns();
+            auto const* t = table();
+            auto const* j = joins();
+            auto const* w = where();
+            auto const* gb = groupBy();
+            auto const* h = having();
+            auto const* ob = orderBy();
+            auto const* l = limit();
+            auto const* o = offset();
+            auto const* u = unions();
+            if (!q || !cols || !t || !j || !w || !gb || !h || !ob || !l || !o || !u) return false;
+
+            ast.quantifier = *q;
+            ast.columns = *cols;
+            ast.table = *t;
+            ast.joins = *j;
+            ast.where = *w;
+            ast.groupBy = *gb;
+            ast.having = *h;
+            ast.orderBy = *ob;
+            ast.limit = *l;
+            ast.offset = *o;
+            ast.unions = *u;
+            return true;
+        }
+
+    private:
+        // 一度だけ解析される句の格納場所
+        template <typename T>
+        struct Slot {
+            mutable std::once_flag once;
+            mutable T value;
+            mutable bool ok = false;
+        };
+
+        struct Header {
+            ast::SelectQuantifier quantifier = ast::SelectQuantifier::Default;
+            std::vector<ast::ResultColumn> columns;
+        };
+
+        struct From {
+            ast::TableReference table;
+            std::vector<ast::Join> joins;
+        };
+
+        template <typename T, typename F>
+        const T* load(const Slot<T>& slot, F&& parse_fn) const {
+            if (!valid_) return nullptr;
+            std::call_once(slot.once, [&] { slot.ok = parse_fn(slot.value); });
+            return slot.ok ? &slot.value : nullptr;
+        }
+
+        const Header* header() const {
+            return load(header_, [&](Header& out) {
+                return parser::parse_header_clause(stmt_, ranges_.header, out.quantifier, out.columns);
+            });
+        }
+
+        const From* from() const {
+            return load(from_, [&](From& out) {
+                return !ranges_.from.present() || parser::parse_from_clause(stmt_, ranges_.from, out.table, out.joins);
+            });
+        }
+
+        String sql_;
+        std::wstring_view stmt_;
+        parser::ClauseRanges ranges_;
+        bool valid_ = false;
+
+        Slot<Header> header_;
+        Slot<From> from_;
+        Slot<boost::optional<ast::Expression>> where_;
+        Slot<std::vector<ast::Expression>> groupBy_;
+        Slot<boost::optional<ast::Expression>> having_;
+        Slot<std::vector<ast::OrderByElement>> orderBy_;
+        Slot<boost::optional<ast::Expression>> limit_;
+        Slot<boost::optional<ast::Expression>> offset_;
+        Slot<std::vector<ast::UnionClause>> unions_;
+    };
+}
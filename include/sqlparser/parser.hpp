@@ -1,11 +1,18 @@
 #pragma once
 #include <cwctype> // Added for std::towupper
+#include <string_view>
+#include <type_traits>
+#include <limits>
+#include <memory> // std::to_address
+#include <unordered_map>
 #include <boost/spirit/home/x3.hpp>
 #include <boost/spirit/home/x3/char/unicode.hpp>
 #include <boost/spirit/home/support/char_encoding/standard_wide.hpp>
 #include <boost/fusion/adapted/std_tuple.hpp> // std::tuple を Fusion sequence として扱うために必要
 #include <sqlparser/ast.hpp>
 #include <sqlparser/config.hpp>
+#include <sqlparser/compare.hpp>
+#include <sqlparser/traverse.hpp>
 #include <boost/fusion/include/adapt_struct.hpp> // Added for BOOST_FUSION_ADAPT_STRUCT
 
 namespace sqlparser::parser {
@@ -20,6 +27,89 @@ namespace sqlparser::parser {
     template <typename T>
     using wide_symbols = x3::symbols_parser<boost::spirit::char_encoding::standard_wide, T>;
 
+    struct SubexpressionCache;
+
+    // parse() の動作オプション
+    struct ParseOptions {
+        // true: 文字列リテラルの中身をコピーせず、入力バッファへのビュー (StringLiteral::source) として保持する。
+        // '' のエスケープ解除は StringLiteral::text() を呼んだ時点で行う。
+        // AST を使い終えるまで入力バッファを生存させるのは呼び出し側の責任。
+        bool string_literal_views = false;
+        // true: 構造的に等しい部分木 (structural_equal。CAST の型名は綴りまで比較する) を
+        // 文全体 (UNION の各 SELECT・サブクエリを含む) で 1 つの凍結したノードにまとめる (hash-consing)。
+        // SELECT リストと GROUP BY で同じ綴りの項目が 2 回目以降に現れた場合は解析も省く。
+        // 共有されたノードは書き込み時に複製されるため (shared_node.hpp)、AST は通常どおり変更できる。
+        bool share_subexpressions = false;
+        // share_subexpressions の共有表 (parse() が設定する。呼び出し側は指定しない)
+        SubexpressionCache* subexpressions = nullptr;
+    };
+
+    // x3::with で文法に ParseOptions を渡すためのタグ
+    struct parse_options_tag;
+
+    // セマンティックアクションから現在の ParseOptions を取り出す (未指定なら既定値)
+    template <typename Context>
+    inline const ParseOptions& get_parse_options(Context const& ctx) {
+        static const ParseOptions defaults;
+        auto const& options = x3::get<parse_options_tag>(ctx);
+        if constexpr (std::is_same_v<std::decay_t<decltype(options)>, x3::unused_type>) {
+            return defaults;
+        } else {
+            return options;
+        }
+    }
+
+    // --- 空白とコメント ---
+
+    // 空白文字か
+    // ASCII は表引きなしで判定し、非 ASCII のみ Unicode 分類にフォールバックする
+    inline bool is_space_char(wchar_t c) {
+        if (c < 0x80) return c == L' ' || (c >= L'\t' && c <= L'\r');
+        return boost::spirit::char_encoding::unicode::isspace(static_cast<boost::uint32_t>(c));
+    }
+
+    // it から始まるコメント ("-- ..." 行末まで / "/* ... */") の直後を返す (コメントでなければ it)
+    // 閉じていない "/*" はコメントとみなさない
+    template <typename Iterator>
+    inline Iterator skip_comment(Iterator it, Iterator last) {
+        if (it == last || std::next(it) == last) return it;
+        Iterator next = std::next(it);
+        if (*it == L'-' && *next == L'-') {
+            while (next != last && *next != L'\n') ++next;
+            return next;
+        }
+        if (*it == L'/' && *next == L'*') {
+            for (++next; next != last; ++next) {
+                if (*next == L'*' && std::next(next) != last && *std::next(next) == L'/') return std::next(next, 2);
+            }
+        }
+        return it;
+    }
+
+    // phrase_parse 用のスキッパー: 空白と SQL コメントを読み飛ばす
+    // x3::unicode::space は 1 文字ごとに Unicode 分類を引くため、ASCII の高速経路を持つ専用パーサーにしている
+    struct sql_space_type : x3::parser<sql_space_type> {
+        using attribute_type = x3::unused_type;
+        static bool const has_attribute = false;
+
+        template <typename Iterator, typename Context, typename RContext, typename Attribute>
+        bool parse(Iterator& first, Iterator const& last, Context const&, RContext&, Attribute&) const {
+            Iterator it = first;
+            while (it != last) {
+                if (is_space_char(*it)) {
+                    ++it;
+                    continue;
+                }
+                Iterator next = skip_comment(it, last);
+                if (next == it) break;
+                it = next;
+            }
+            if (it == first) return false;
+            first = it;
+            return true;
+        }
+    } const sql_space;
+
     // --- 基本ルール ---
 
     // 予約語
@@ -63,14 +153,14 @@ namespace sqlparser::parser {
     } const keywords;
 
     // 識別子: 英数字とアンダースコア、ドット (テーブル修飾用)
-    x3::rule<class identifier_class, std::wstring> const identifier = "identifier";
+    x3::rule<class identifier_class, Identifier> const identifier = "identifier";
     auto const identifier_def = x3::raw[x3::lexeme[ 
         !(x3::no_case[keywords] >> !(alnum | char_(L'_') | char_(L'.')))
         >> +(alnum | char_(L'_') | char_(L'.')) 
     ]] [ ([](auto& ctx){ 
+        // raw の範囲から直接構築する (一時的な std::wstring を作らない)
         auto& range = x3::_attr(ctx);
-        std::wstring str(range.begin(), range.end());
-        x3::_val(ctx) = str;
+        x3::_val(ctx) = Identifier(std::wstring_view(std::to_address(range.begin()), range.size()));
     }) ];
     BOOST_SPIRIT_DEFINE(identifier);
 
@@ -180,30 +270,11 @@ namespace sqlparser::parser {
     auto const cast_kw = x3::no_case[x3::lit(L"CAST")];
     auto const as_kw = x3::no_case[x3::lit(L"AS")];
     
-    // 型名: PostgreSQLの複雑な型名にも対応
-    // 例: INT, VARCHAR(255), TIMESTAMP WITH TIME ZONE, CHAR[10]
-    
-    // 複合キーワードの定義
-    auto const double_precision = x3::no_case[x3::lit(L"DOUBLE")] >> x3::no_case[x3::lit(L"PRECISION")];
-    
-    // CHARACTER [VARYING]
-    auto const character_type = x3::no_case[x3::lit(L"CHARACTER")] >> -x3::no_case[x3::lit(L"VARYING")];
-    
-    // BIT [VARYING]
-    auto const bit_type = x3::no_case[x3::lit(L"BIT")] >> -x3::no_case[x3::lit(L"VARYING")];
-    
-    auto const with_time_zone = x3::no_case[x3::lit(L"WITH")] >> x3::no_case[x3::lit(L"TIME")] >> x3::no_case[x3::lit(L"ZONE")];
-    auto const without_time_zone = x3::no_case[x3::lit(L"WITHOUT")] >> x3::no_case[x3::lit(L"TIME")] >> x3::no_case[x3::lit(L"ZONE")];
-    
-    auto const timestamp_type = x3::no_case[x3::lit(L"TIMESTAMP")] >> -(with_time_zone | without_time_zone);
-    auto const time_type = x3::no_case[x3::lit(L"TIME")] >> -(with_time_zone | without_time_zone);
-
-    // Special time types (must be checked before TIME/TIMESTAMP)
-    auto const special_time_types = 
-        x3::no_case[x3::lit(L"TIMESTAMPTZ")] |
-        x3::no_case[x3::lit(L"TIMETZ")];
+    // 型名: postgresql_type.csv から生成した型カタログ (types.hpp) をハッシュで引く
+    // 例: INT, VARCHAR(255), TIMESTAMP(3) WITH TIME ZONE, INTERVAL DAY TO SECOND, INT[][]
+    // カタログにない型名 (ユーザー定義型、スキーマ修飾付き) は識別子として受け付け、TypeId::UNKNOWN とする。
 
-    // Interval type
+    // INTERVAL の fields
     auto const interval_fields = 
         x3::no_case[x3::lit(L"YEAR")] >> x3::no_case[x3::lit(L"TO")] >> x3::no_case[x3::lit(L"MONTH")] |
         x3::no_case[x3::lit(L"DAY")] >> x3::no_case[x3::lit(L"TO")] >> x3::no_case[x3::lit(L"SECOND")] |
@@ -219,88 +290,130 @@ namespace sqlparser::parser {
         x3::no_case[x3::lit(L"MINUTE")] |
         x3::no_case[x3::lit(L"SECOND")];
 
-    auto const interval_type = x3::no_case[x3::lit(L"INTERVAL")] >> -interval_fields;
-
-    // その他のキーワード型
-    auto const simple_type_keyword = 
-        x3::no_case[x3::lit(L"BIGINT")] |
-        x3::no_case[x3::lit(L"INT8")] |
-        x3::no_case[x3::lit(L"BIGSERIAL")] |
-        x3::no_case[x3::lit(L"SERIAL8")] |
-        x3::no_case[x3::lit(L"VARBIT")] |
-        x3::no_case[x3::lit(L"BOOLEAN")] |
-        x3::no_case[x3::lit(L"BOOL")] |
-        x3::no_case[x3::lit(L"BYTEA")] |
-        x3::no_case[x3::lit(L"CIDR")] |
-        x3::no_case[x3::lit(L"DATE")] |
-        x3::no_case[x3::lit(L"FLOAT8")] |
-        x3::no_case[x3::lit(L"INET")] |
-        x3::no_case[x3::lit(L"INTEGER")] |
-        x3::no_case[x3::lit(L"INT4")] |
-        x3::no_case[x3::lit(L"INT2")] |
-        x3::no_case[x3::lit(L"INT")] |
-        x3::no_case[x3::lit(L"JSONB")] |
-        x3::no_case[x3::lit(L"JSON")] |
-        x3::no_case[x3::lit(L"MACADDR")] |
-        x3::no_case[x3::lit(L"MONEY")] |
-        x3::no_case[x3::lit(L"NUMERIC")] |
-        x3::no_case[x3::lit(L"DECIMAL")] |
-        x3::no_case[x3::lit(L"PG_LSN")] |
-        x3::no_case[x3::lit(L"REAL")] |
-        x3::no_case[x3::lit(L"FLOAT4")] |
-        x3::no_case[x3::lit(L"FLOAT")] |
-        x3::no_case[x3::lit(L"SMALLINT")] |
-        x3::no_case[x3::lit(L"SMALLSERIAL")] |
-        x3::no_case[x3::lit(L"SERIAL4")] |
-        x3::no_case[x3::lit(L"SERIAL2")] |
-        x3::no_case[x3::lit(L"SERIAL")] |
-        x3::no_case[x3::lit(L"TEXT")] |
-        x3::no_case[x3::lit(L"TSQUERY")] |
-        x3::no_case[x3::lit(L"TSVECTOR")] |
-        x3::no_case[x3::lit(L"TXID_SNAPSHOT")] |
-        x3::no_case[x3::lit(L"UUID")] |
-        x3::no_case[x3::lit(L"XML")] |
-        x3::no_case[x3::lit(L"VARCHAR")] |
-        x3::no_case[x3::lit(L"VARCHAR2")] |
-        x3::no_case[x3::lit(L"CHAR")] |
-        x3::no_case[x3::lit(L"NVARCHAR")];
-
     // 任意の識別子 (キーワード含む)
     auto const any_identifier = x3::lexeme[ 
         +(alnum | char_(L'_') | char_(L'.')) 
     ];
 
-    auto const type_base = 
-        double_precision |
-        character_type |
-        bit_type |
-        special_time_types |
-        timestamp_type |
-        time_type |
-        interval_type |
-        simple_type_keyword |
-        any_identifier;
+    // 型名の解析結果 (Cast::type_name と Cast::type に入る)
+    struct ParsedType {
+        SmallString text;
+        TypeInfo info;
+    };
+
+    // 型名を語単位で読み、カタログに登録された最も長い語の並びを採用する。
+    // 語の途中で一致することはないため、VARCHAR2 や INTERVAL が VARCHAR や INT に食われることはない。
+    struct type_name_type : x3::parser<type_name_type> {
+        using attribute_type = ParsedType;
+        static bool const has_attribute = true;
 
-    auto const type_args = 
-        L'(' >> x3::int_ >> -(L',' >> x3::int_) >> L')';
+        static bool is_word_char(wchar_t c) {
+            return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || (c >= L'0' && c <= L'9') || c == L'_';
+        }
 
-    auto const array_suffix = 
-        x3::lit(L"[") >> -x3::int_ >> x3::lit(L"]");
+        // (n) / (p, s)
+        template <typename Iterator, typename Context>
+        static bool scan_args(Iterator& it, Iterator const& last, Context const& context, TypeInfo& info) {
+            Iterator i = it;
+            x3::skip_over(i, last, context);
+            if (i == last || *i != L'(') return false;
+            ++i;
+            int precision = -1;
+            int scale = -1;
+            if (!x3::int_.parse(i, last, context, x3::unused, precision)) return false;
+            x3::skip_over(i, last, context);
+            if (i != last && *i == L',') {
+                ++i;
+                if (!x3::int_.parse(i, last, context, x3::unused, scale)) return false;
+                x3::skip_over(i, last, context);
+            }
+            if (i == last || *i != L')') return false;
+            info.precision = precision;
+            info.scale = scale;
+            it = ++i;
+            return true;
+        }
 
-    x3::rule<class type_name_class, std::wstring> const type_name = "type_name";
-    
-    auto const type_name_def = x3::raw[
-        type_base >> -type_args >> *array_suffix
-    ] [ ([](auto& ctx){ 
-        auto& range = x3::_attr(ctx);
-        std::wstring str(range.begin(), range.end());
-        x3::_val(ctx) = str;
-    }) ];
+        template <typename Iterator, typename Context, typename RuleContext, typename Attribute>
+        bool parse(Iterator& first, Iterator const& last, Context const& context, RuleContext const&, Attribute& attr) const {
+            x3::skip_over(first, last, context);
+            Iterator it = first;
+            Iterator end = first;
+            ParsedType result;
+            bool has_args = false;
+
+            wchar_t key[type_name_max_length + 1];
+            size_t key_len = 0;
+            for (size_t words = 0; words < type_name_max_words; ++words) {
+                Iterator w = it;
+                if (words > 0) x3::skip_over(w, last, context);
+                Iterator word_begin = w;
+                while (w != last && is_word_char(*w)) ++w;
+                size_t n = static_cast<size_t>(w - word_begin);
+                if (n == 0 || (*word_begin >= L'0' && *word_begin <= L'9')) break;
+                if (key_len + (words > 0 ? 1 : 0) + n > type_name_max_length) break;
+                if (words > 0) key[key_len++] = L' ';
+                for (Iterator p = word_begin; p != w; ++p) key[key_len++] = detail::type_name_lower(*p);
+                it = w;
+
+                if (TypeId id = find_type(std::wstring_view(key, key_len)); id != TypeId::UNKNOWN) {
+                    result.info.id = id;
+                    end = it;
+                }
+                // TIME(3) WITH TIME ZONE のように精度が最初の語の直後に来る形
+                if (words == 0 && result.info.id != TypeId::UNKNOWN && scan_args(it, last, context, result.info)) {
+                    has_args = true;
+                    end = it;
+                }
+            }
+
+            if (result.info.id == TypeId::UNKNOWN) {
+                end = first;
+                if (!any_identifier.parse(end, last, context, x3::unused, x3::unused)) return false;
+            } else if (result.info.id == TypeId::INTERVAL) {
+                Iterator f = end;
+                if (interval_fields.parse(f, last, context, x3::unused, x3::unused)) end = f;
+            }
+
+            if (!has_args) scan_args(end, last, context, result.info);
+
+            // 配列: [] / [n] の繰り返し
+            for (;;) {
+                Iterator a = end;
+                x3::skip_over(a, last, context);
+                if (a == last || *a != L'[') break;
+                ++a;
+                int size;
+                x3::int_.parse(a, last, context, x3::unused, size);
+                x3::skip_over(a, last, context);
+                if (a == last || *a != L']') break;
+                end = ++a;
+                ++result.info.array_dims;
+            }
+
+            result.text = SmallString(first, end);
+            attr = std::move(result);
+            first = end;
+            return true;
+        }
+    } const type_name_parser;
+
+    x3::rule<class type_name_class, ParsedType> const type_name = "type_name";
+    auto const type_name_def = type_name_parser;
     
     BOOST_SPIRIT_DEFINE(type_name);
 
+    auto make_cast_expr = [](auto& ctx) {
+        using boost::fusion::at_c;
+        auto& attr = x3::_attr(ctx); // tuple<Expression, ParsedType>
+        ast::Cast cast_node;
+        cast_node.expr = std::move(at_c<0>(attr));
+        cast_node.type_name = std::move(at_c<1>(attr).text);
+        cast_node.type = at_c<1>(attr).info;
+        x3::_val(ctx) = std::move(cast_node);
+    };
     auto const cast_expr_def = 
-        cast_kw >> L'(' >> expression >> as_kw >> type_name >> L')';
+        (cast_kw >> L'(' >> expression >> as_kw >> type_name >> L')') [make_cast_expr];
     
     // 関数呼び出し
     // identifier ( args... )
@@ -347,34 +460,185 @@ namespace sqlparser::parser {
         (function_call >> window_spec) [make_window_function];
     BOOST_SPIRIT_DEFINE(window_function_expr);
 
-    // 文字列リテラル: '...'
+    // 文字列リテラル: '...' (中の '' は ' のエスケープ)
+    // ビューモードでは入力バッファ上の範囲だけを記録し、コピーもエスケープ解除もしない
     x3::rule<class string_literal_class, ast::StringLiteral> const string_literal = "string_literal";
-    auto const string_literal_def = x3::lexeme[L"'" >> *(x3::standard_wide::char_ - L"'") >> L"'"];
+    auto const string_literal_def = x3::lexeme[L"'" >> x3::raw[*((x3::standard_wide::char_ - L'\'') | x3::lit(L"''"))] >> L"'"] [ ([](auto& ctx){
+        auto& range = x3::_attr(ctx);
+        std::wstring_view quoted(std::to_address(range.begin()), range.size());
+        if (get_parse_options(ctx).string_literal_views) {
+            x3::_val(ctx).source = quoted;
+        } else if (quoted.find(L'\'') == std::wstring_view::npos) {
+            x3::_val(ctx).value = SmallString(quoted);
+        } else {
+            x3::_val(ctx).value = ast::StringLiteral::unescape(quoted);
+        }
+    }) ];
     BOOST_SPIRIT_DEFINE(string_literal);
 
+    // 数値リテラルの字句スキャナ: 数値に変換せず、入力の綴りの範囲をそのまま切り出す
+    // (変換は IntLiteral::value() などで必要になった時に行う)
+    // 整数: [+-] 数字列
+    // 小数: [+-] (数字列 . [数字列] | . 数字列) [(e|E) [+-] 数字列]
+    // Float = true なら小数のみ、false なら整数のみを受け付ける
+    template <bool Float>
+    struct numeric_text_type : x3::parser<numeric_text_type<Float>> {
+        using attribute_type = SmallString;
+        static bool const has_attribute = true;
+
+        template <typename Iterator>
+        static Iterator skip_digits(Iterator it, Iterator const& last) {
+            while (it != last && *it >= L'0' && *it <= L'9') ++it;
+            return it;
+        }
+
+        // 数値の終端を返す (数値でなければ first)。is_float には小数かどうかを返す
+        template <typename Iterator>
+        static Iterator scan(Iterator first, Iterator const& last, bool& is_float) {
+            Iterator it = first;
+            if (it != last && (*it == L'+' || *it == L'-')) ++it;
+            Iterator int_end = skip_digits(it, last);
+            bool has_int = int_end != it;
+            it = int_end;
+            is_float = it != last && *it == L'.';
+            if (!is_float) return has_int ? it : first;
+            ++it;
+            Iterator frac_end = skip_digits(it, last);
+            if (!has_int && frac_end == it) return first;
+            it = frac_end;
+            if (it != last && (*it == L'e' || *it == L'E')) {
+                Iterator exp = std::next(it);
+                if (exp != last && (*exp == L'+' || *exp == L'-')) ++exp;
+                Iterator exp_end = skip_digits(exp, last);
+                if (exp_end != exp) it = exp_end;
+            }
+            return it;
+        }
+
+        template <typename Iterator, typename Context, typename RuleContext, typename Attribute>
+        bool parse(Iterator& first, Iterator const& last, Context const& context, RuleContext const&, Attribute& attr) const {
+            x3::skip_over(first, last, context);
+            bool is_float = false;
+            Iterator it = scan(first, last, is_float);
+            if (it == first || is_float != Float) return false;
+            attr = SmallString(first, it);
+            first = it;
+            return true;
+        }
+    };
+
     // 数値リテラル (整数)
     x3::rule<class int_literal_class, ast::IntLiteral> const int_literal = "int_literal";
-    auto const int_literal_def = x3::int_ [ ([](auto& ctx){ 
-        x3::_val(ctx) = ast::IntLiteral(x3::_attr(ctx)); 
+    auto const int_literal_def = numeric_text_type<false>{} [ ([](auto& ctx){ 
+        x3::_val(ctx).text = std::move(x3::_attr(ctx));
     }) ];
     BOOST_SPIRIT_DEFINE(int_literal);
 
-    // 数値リテラル (小数点を含むもの: 0.6, 1.0 など)
-    // strict_real_policies により、小数点を含まない数値 (整数) にはマッチしない
-    // (整数は int_literal 側でマッチさせるため)
+    // 数値リテラル (小数点を含むもの: 0.6, 1.0, .5, 1.5e-3 など)
+    // 小数点を含まない数値 (整数) にはマッチしない (整数は int_literal 側でマッチさせるため)
     x3::rule<class float_literal_class, ast::FloatLiteral> const float_literal = "float_literal";
-    auto const float_literal_def = x3::real_parser<double, x3::strict_real_policies<double>>()
-        [ ([](auto& ctx){
-            x3::_val(ctx) = ast::FloatLiteral(x3::_attr(ctx));
-        }) ];
+    auto const float_literal_def = numeric_text_type<true>{} [ ([](auto& ctx){
+        x3::_val(ctx).text = std::move(x3::_attr(ctx));
+    }) ];
     BOOST_SPIRIT_DEFINE(float_literal);
 
+    // IN リストの高速パーサー: "(1, 2, 3)" / "('a', 'b')" のように同種のリテラルだけが並ぶリストを
+    // 要素ごとの Expression を作らずに LiteralList へ直接読み込む。
+    // 数値は int64_t で表せて綴りが変わらないものだけなら INT、小数などを含む場合は綴りのまま NUMERIC として保持する。
+    // 式・数値と文字列の混在などを見つけた場合は何も消費せずに失敗し、汎用の式リストにフォールバックする。
+    struct literal_list_type : x3::parser<literal_list_type> {
+        using attribute_type = ast::LiteralList;
+        static bool const has_attribute = true;
+
+        // 符号 '-' と数字のみ (先頭の余分な 0 は不可: 出力が入力と一致するものだけを受け付ける)
+        template <typename Iterator>
+        static bool scan_int(Iterator& it, Iterator const& last, int64_t& value) {
+            bool negative = false;
+            if (it != last && *it == L'-') { negative = true; ++it; }
+            if (it == last || *it < L'0' || *it > L'9') return false;
+            if (*it == L'0' && std::next(it) != last && *std::next(it) >= L'0' && *std::next(it) <= L'9') return false;
+            uint64_t limit = negative ? uint64_t(std::numeric_limits<int64_t>::max()) + 1 : uint64_t(std::numeric_limits<int64_t>::max());
+            uint64_t v = 0;
+            for (; it != last && *it >= L'0' && *it <= L'9'; ++it) {
+                uint64_t d = static_cast<uint64_t>(*it - L'0');
+                if (v > (limit - d) / 10) return false;
+                v = v * 10 + d;
+            }
+            value = negative ? static_cast<int64_t>(0 - v) : static_cast<int64_t>(v);
+            return true;
+        }
+
+        // '...' の中身を SQL 上の綴りのまま ('' はエスケープのまま) 返す
+        template <typename Iterator>
+        static bool scan_string(Iterator& it, Iterator const& last, std::wstring_view& value) {
+            if (it == last || *it != L'\'') return false;
+            Iterator begin = ++it;
+            while (it != last && (*it != L'\'' || (std::next(it) != last && *std::next(it) == L'\''))) {
+                if (*it == L'\'') ++it;
+                ++it;
+            }
+            if (it == last) return false;
+            value = std::wstring_view(std::to_address(begin), static_cast<size_t>(it - begin));
+            ++it;
+            return true;
+        }
+
+        template <typename Iterator, typename Context, typename RuleContext, typename Attribute>
+        bool parse(Iterator& first, Iterator const& last, Context const& context, RuleContext const&, Attribute& attr) const {
+            x3::skip_over(first, last, context);
+            Iterator it = first;
+            if (it == last || *it != L'(') return false;
+            ++it;
+            x3::skip_over(it, last, context);
+            if (it == last) return false;
+
+            ast::LiteralList list;
+            list.kind = *it == L'\'' ? ast::LiteralList::Kind::STRING : ast::LiteralList::Kind::INT;
+            for (;;) {
+                x3::skip_over(it, last, context);
+                if (list.kind == ast::LiteralList::Kind::STRING) {
+                    std::wstring_view v;
+                    if (!scan_string(it, last, v)) return false;
+                    list.push_back(v);
+                } else {
+                    bool is_float = false;
+                    Iterator end = numeric_text_type<false>::scan(it, last, is_float);
+                    if (end == it) return false;
+                    int64_t v;
+                    Iterator int_end = it;
+                    if (list.kind == ast::LiteralList::Kind::INT && !is_float && scan_int(int_end, end, v) && int_end == end) {
+                        list.push_back(v);
+                    } else {
+                        if (list.kind == ast::LiteralList::Kind::INT) list.to_numeric();
+                        list.push_back(std::wstring_view(std::to_address(it), static_cast<size_t>(end - it)));
+                    }
+                    it = end;
+                }
+                x3::skip_over(it, last, context);
+                if (it == last) return false;
+                if (*it == L',') { ++it; continue; }
+                if (*it == L')') { ++it; break; }
+                return false;
+            }
+            attr = std::move(list);
+            first = it;
+            return true;
+        }
+    } const literal_list;
+
+    // 入力バッファ上の範囲 (コピーせずに参照する)
+    struct SourceSpan {
+        std::wstring_view text;
+    };
+
     // バランス括弧パーサー (EXISTS サブクエリ用)
+    // 属性は括弧を含む入力上の範囲で、サブクエリは元のバッファ上で解析する
     struct balanced_parens_type : x3::parser<balanced_parens_type> {
-        using attribute_type = std::wstring;
+        using attribute_type = SourceSpan;
         template <typename Iterator, typename Context, typename RuleContext, typename Attribute>
         bool parse(Iterator& first, Iterator const& last, Context const& ctx,
                    RuleContext const&, Attribute& attr) const {
+            x3::skip_over(first, last, ctx);
             if (first == last || *first != L'(') return false;
             Iterator start = first;
             int depth = 0;
@@ -384,6 +648,9 @@ namespace sqlparser::parser {
                 wchar_t c = *it;
                 if (in_string) {
                     if (c == L'\'') in_string = false;
+                } else if (Iterator next = skip_comment(it, last); next != it) {
+                    it = next;
+                    continue;
                 } else {
                     if (c == L'\'') in_string = true;
                     else if (c == L'(') depth++;
@@ -391,7 +658,7 @@ namespace sqlparser::parser {
                         depth--;
                         if (depth == 0) {
                             ++it;
-                            attr = std::wstring(start, it);
+                            attr.text = std::wstring_view(std::to_address(start), static_cast<size_t>(it - start));
                             first = it;
                             return true;
                         }
@@ -404,63 +671,63 @@ namespace sqlparser::parser {
     } const balanced_parens;
 
     // parse() の前方宣言 (EXISTS 式のサブクエリ解析用)
-    inline bool parse(std::wstring const& sql, ast::SelectStatement& ast);
+    inline bool parse(std::wstring_view sql, ast::SelectStatement& ast, const ParseOptions& options = {});
 
     // EXISTS式のルール
     x3::rule<class exists_class, ast::Exists> const exists_expr = "exists_expr";
     auto const exists_kw = x3::no_case[x3::lit(L"EXISTS")];
     auto make_exists_expr = [](auto& ctx) {
-        auto& raw_parens = x3::_attr(ctx); // "(SELECT ...)" を含む文字列
-        std::wstring inner(raw_parens.begin() + 1, raw_parens.end() - 1);
+        std::wstring_view raw_parens = x3::_attr(ctx).text; // "(SELECT ...)" を含む範囲
         ast::SelectStatement sub;
-        if (!parse(inner, sub)) {
+        if (!parse(raw_parens.substr(1, raw_parens.size() - 2), sub, get_parse_options(ctx))) {
             x3::_pass(ctx) = false;
             return;
         }
         ast::Exists exists_node;
-        exists_node.subquery = sub;
-        x3::_val(ctx) = exists_node;
+        exists_node.subquery = std::move(sub);
+        x3::_val(ctx) = std::move(exists_node);
     };
     auto const exists_expr_def =
-        (x3::omit[exists_kw] >> x3::omit[*space] >> balanced_parens) [make_exists_expr];
+        (x3::omit[exists_kw] >> balanced_parens) [make_exists_expr];
     BOOST_SPIRIT_DEFINE(exists_expr);
 
     // primary: 数値 | CAST式 | 関数呼び出し | 識別子 | * | (式)
     // 注意: function_call は identifier で始まるため、identifier より先に記述する必要がある
     // "*" を追加して SELECT * に対応
     auto const primary_def = 
-        float_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | int_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | cast_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | window_function_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | exists_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | function_call [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | case_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | identifier [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | string_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | (x3::lit(L"*") >> x3::attr(std::wstring(L"*"))) [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(x3::_attr(ctx)); }) ]
-        | (L'(' >> expression >> L')') [ ([](auto& ctx){ x3::_val(ctx) = x3::_attr(ctx); }) ]
+        float_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | int_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | cast_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | window_function_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | exists_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | function_call [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | case_expr [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | identifier [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | string_literal [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | (x3::lit(L"*") >> x3::attr(Identifier(L"*"))) [ ([](auto& ctx){ x3::_val(ctx) = ast::Expression(std::move(x3::_attr(ctx))); }) ]
+        | (L'(' >> expression >> L')') [ ([](auto& ctx){ x3::_val(ctx) = std::move(x3::_attr(ctx)); }) ]
         ;
 
     // Postfix Cast (::)
     auto make_cast_op = [](auto& ctx) {
         using boost::fusion::at_c;
-        auto& attr = x3::_attr(ctx); // tuple<Expression, vector<String>>
+        auto& attr = x3::_attr(ctx); // tuple<Expression, vector<ParsedType>>
         
         auto& first = at_c<0>(attr);
         auto& rest = at_c<1>(attr);
 
         if (rest.empty()) {
-            x3::_val(ctx) = first;
+            x3::_val(ctx) = std::move(first);
         } else {
-            ast::Expression current = first;
-            for (auto& t_name : rest) {
+            ast::Expression current = std::move(first);
+            for (auto& t : rest) {
                 ast::Cast cast_node;
-                cast_node.expr = current;
-                cast_node.type_name = t_name;
-                current = cast_node;
+                cast_node.expr = std::move(current);
+                cast_node.type_name = std::move(t.text);
+                cast_node.type = t.info;
+                current = std::move(cast_node);
             }
-            x3::_val(ctx) = current;
+            x3::_val(ctx) = std::move(current);
         }
     };
 
@@ -478,12 +745,12 @@ namespace sqlparser::parser {
         op_node.op = at_c<0>(attr);
         op_node.expr = at_c<1>(attr);
         
-        x3::_val(ctx) = op_node;
+        x3::_val(ctx) = std::move(op_node);
     };
 
     auto const unary_def = 
         (unary_op >> unary) [make_unary_op]
-        | postfix_cast [ ([](auto& ctx){ x3::_val(ctx) = x3::_attr(ctx); }) ];
+        | postfix_cast [ ([](auto& ctx){ x3::_val(ctx) = std::move(x3::_attr(ctx)); }) ];
 
     // null_predicate: IS NULL / IS NOT NULL / BETWEEN (後置)
     // sum の後に適用される
@@ -495,10 +762,10 @@ namespace sqlparser::parser {
         ast::Expression upper;
     };
 
-    // In の引数構造体
+    // In の引数構造体 (リテラルだけのリストは LiteralList、それ以外は式のリスト)
     struct InArgs {
         bool not_in;
-        std::vector<ast::Expression> values;
+        boost::variant<ast::LiteralList, std::vector<ast::Expression>> values;
     };
 
     // SuffixOp: IS NULL (OpType) または BETWEEN (BetweenArgs) または IN (InArgs)
@@ -512,34 +779,38 @@ namespace sqlparser::parser {
         auto& rest = at_c<1>(attr);
 
         if (rest.empty()) {
-            x3::_val(ctx) = first;
+            x3::_val(ctx) = std::move(first);
         } else {
-            ast::Expression current = first;
+            ast::Expression current = std::move(first);
             for (auto& op_variant : rest) {
                 if (auto* op_type = boost::get<ast::OpType>(&op_variant)) {
                     // IS NULL / IS NOT NULL
                     ast::UnaryOp op_node;
                     op_node.op = *op_type;
-                    op_node.expr = current;
-                    current = op_node;
+                    op_node.expr = std::move(current);
+                    current = std::move(op_node);
                 } else if (auto* between_args = boost::get<BetweenArgs>(&op_variant)) {
                     // BETWEEN
                     ast::Between between_node;
-                    between_node.expr = current;
-                    between_node.lower = between_args->lower;
-                    between_node.upper = between_args->upper;
+                    between_node.expr = std::move(current);
+                    between_node.lower = std::move(between_args->lower);
+                    between_node.upper = std::move(between_args->upper);
                     between_node.not_between = between_args->not_between;
-                    current = between_node;
+                    current = std::move(between_node);
                 } else if (auto* in_args = boost::get<InArgs>(&op_variant)) {
                     // IN
                     ast::In in_node;
-                    in_node.expr = current;
-                    in_node.values = in_args->values;
+                    in_node.expr = std::move(current);
                     in_node.not_in = in_args->not_in;
-                    current = in_node;
+                    if (auto* literals = boost::get<ast::LiteralList>(&in_args->values)) {
+                        in_node.literals = std::move(*literals);
+                    } else {
+                        in_node.values = std::move(boost::get<std::vector<ast::Expression>>(in_args->values));
+                    }
+                    current = std::move(in_node);
                 }
             }
-            x3::_val(ctx) = current;
+            x3::_val(ctx) = std::move(current);
         }
     };
 
@@ -553,11 +824,20 @@ namespace sqlparser::parser {
         (x3::no_case[x3::lit(L"NOT") >> x3::lit(L"BETWEEN")] >> x3::attr(true) >> bitwise >> x3::no_case[x3::lit(L"AND")] >> bitwise)
         | (x3::no_case[x3::lit(L"BETWEEN")] >> x3::attr(false) >> bitwise >> x3::no_case[x3::lit(L"AND")] >> bitwise);
 
+    x3::rule<class in_literals_class, ast::LiteralList> const in_literals = "in_literals";
+    auto const in_literals_def = literal_list;
+
+    x3::rule<class in_expressions_class, std::vector<ast::Expression>> const in_expressions = "in_expressions";
+    auto const in_expressions_def = x3::lit(L"(") >> (expression % L',') >> x3::lit(L")");
+
+    // 値のリストは InArgs へ直接ムーブする (variant への一時コピーを避ける)
+    auto set_in_values = [](auto& ctx) { x3::_val(ctx).values = std::move(x3::_attr(ctx)); };
+
     x3::rule<class in_op_class, InArgs> const in_op = "in_op";
     auto const in_op_def = 
-        (x3::no_case[x3::lit(L"NOT") >> x3::lit(L"IN")] >> x3::attr(true) 
-         | x3::no_case[x3::lit(L"IN")] >> x3::attr(false))
-        >> x3::lit(L"(") >> (expression % L',') >> x3::lit(L")");
+        (x3::no_case[x3::lit(L"NOT") >> x3::lit(L"IN")] [ ([](auto& ctx){ x3::_val(ctx).not_in = true; }) ]
+         | x3::no_case[x3::lit(L"IN")] [ ([](auto& ctx){ x3::_val(ctx).not_in = false; }) ])
+        >> (in_literals [set_in_values] | in_expressions [set_in_values]);
 
     x3::rule<class suffix_op_class, SuffixOp> const suffix_op = "suffix_op";
     auto const suffix_op_def = is_null_op | between_op | in_op;
@@ -565,7 +845,7 @@ namespace sqlparser::parser {
     auto const null_predicate_def = 
         (bitwise >> *suffix_op) [make_suffix_op];
 
-    BOOST_SPIRIT_DEFINE(is_null_op, between_op, in_op, suffix_op);
+    BOOST_SPIRIT_DEFINE(is_null_op, between_op, in_literals, in_expressions, in_op, suffix_op);
 
     // BOOST_SPIRIT_DEFINE(null_predicate); // Moved to the main BOOST_SPIRIT_DEFINE
 
@@ -578,17 +858,17 @@ namespace sqlparser::parser {
         auto& rest = at_c<1>(attr);
 
         if (rest.empty()) {
-            x3::_val(ctx) = first;
+            x3::_val(ctx) = std::move(first);
         } else {
-            ast::Expression current = first;
+            ast::Expression current = std::move(first);
             for (auto& item : rest) {
                 ast::BinaryOp op_node;
-                op_node.left = current;
+                op_node.left = std::move(current);
                 op_node.op = at_c<0>(item);
-                op_node.right = at_c<1>(item);
-                current = op_node;
+                op_node.right = std::move(at_c<1>(item));
+                current = std::move(op_node);
             }
-            x3::_val(ctx) = current;
+            x3::_val(ctx) = std::move(current);
         }
     };
 
@@ -606,28 +886,40 @@ namespace sqlparser::parser {
     auto const factor_def = 
         (null_predicate >> *(op_symbol >> null_predicate)) [make_binary_op];
 
-    // term: AND 演算
-    auto make_and_op = [](auto& ctx) {
-        using boost::fusion::at_c;
-        auto& attr = x3::_attr(ctx);
-        auto& first = at_c<0>(attr);
-        auto& rest = at_c<1>(attr);
-
-        if (rest.empty()) {
-            x3::_val(ctx) = first;
-        } else {
-            ast::Expression current = first;
-            for (auto& item : rest) {
-                ast::BinaryOp op_node;
-                op_node.op = ast::OpType::AND;
-                op_node.left = current;
-                op_node.right = item;
-                current = op_node;
+    // AND / OR の連鎖を 1 つの LogicalOp にまとめる (左深の BinaryOp 木を作らない)
+    // 括弧内の同じ演算子の LogicalOp も展開する: "(a AND b) AND c" -> AND(a, b, c)
+    template <ast::OpType Op>
+    struct make_logical_op {
+        template <typename Context>
+        void operator()(Context& ctx) const {
+            using boost::fusion::at_c;
+            auto& attr = x3::_attr(ctx);
+            auto& first = at_c<0>(attr);
+            auto& rest = at_c<1>(attr);
+
+            if (rest.empty()) {
+                x3::_val(ctx) = std::move(first);
+                return;
             }
-            x3::_val(ctx) = current;
+            ast::LogicalOp node;
+            node.op = Op;
+            node.operands.reserve(rest.size() + 1);
+            auto append = [&](ast::Expression& e) {
+                if (auto* inner = boost::get<ast::LogicalOp>(&e); inner && inner->op == Op) {
+                    for (auto& operand : inner->operands) node.operands.push_back(std::move(operand));
+                } else {
+                    node.operands.push_back(std::move(e));
+                }
+            };
+            append(first);
+            for (auto& item : rest) append(item);
+            x3::_val(ctx) = std::move(node);
         }
     };
 
+    // term: AND 演算
+    auto const make_and_op = make_logical_op<ast::OpType::AND>{};
+
     // word-boundary-aware AND/OR: "AND"/"OR" の後ろが英数字・アンダースコアなら不一致
     // 例: "ORDER" の "OR" や "ANDROID" の "AND" を誤マッチしないようにする
     auto const and_kw_word = x3::lexeme[x3::no_case[x3::lit(L"AND")] >> !(alnum | char_(L'_'))];
@@ -637,38 +929,96 @@ namespace sqlparser::parser {
         (factor >> *(and_kw_word >> factor)) [make_and_op];
 
     // expression: OR 演算
-    auto make_or_op = [](auto& ctx) {
-        using boost::fusion::at_c;
-        auto& attr = x3::_attr(ctx);
-        auto& first = at_c<0>(attr);
-        auto& rest = at_c<1>(attr);
+    auto const make_or_op = make_logical_op<ast::OpType::OR>{};
 
-        if (rest.empty()) {
-            x3::_val(ctx) = first;
-        } else {
-            ast::Expression current = first;
-            for (auto& item : rest) {
-                ast::BinaryOp op_node;
-                op_node.op = ast::OpType::OR;
-                op_node.left = current;
-                op_node.right = item;
-                current = op_node;
+    auto const expression_def = 
+        (term >> *(or_kw_word >> term)) [make_or_op];
+
+    BOOST_SPIRIT_DEFINE(expression, term, factor, null_predicate, bitwise, sum, product, unary, primary);
+
+    // --- 式の共有 (ParseOptions::share_subexpressions) ---
+
+    // 共有表 (文全体で 1 つ。parse() が作る)
+    //   by_text: SELECT リスト・GROUP BY の項目の綴り (入力バッファを指す) → 解析済みの式。同じ綴りの項目は解析を省く
+    //   nodes:   子を持つ式のハッシュ値 → 凍結した (frozen_copy) 式。CAST の型名の綴りまで等しいものだけをまとめる
+    //   hashes:  nodes の式のノードの場所 → ハッシュ値。親のハッシュは子の値から計算するため、部分木ごとに 1 回だけ計算する
+    // ast::walk の visitor として、帰りがけ順に子を持つ式を表のノードに置き換える (子は先に置き換わっている)。
+    // 表にある部分木には入らない (共有中のノードを書き込み用に取り出すと複製されるため)。
+    struct SubexpressionCache {
+        static constexpr CompareOptions exact{ .exact_type_names = true };
+
+        std::unordered_map<std::wstring_view, ast::Expression> by_text;
+        std::unordered_multimap<size_t, ast::Expression> nodes;
+        sqlparser::detail::NodeHashes hashes;
+
+        // 置き換えの対象外 (葉か、表のノード)
+        bool settled(const ast::Expression& e) const {
+            if (boost::get<Identifier>(&e) || boost::get<ast::IntLiteral>(&e) || boost::get<ast::FloatLiteral>(&e) ||
+                boost::get<ast::StringLiteral>(&e)) {
+                return true;
             }
-            x3::_val(ctx) = current;
+            return hashes.count(sqlparser::detail::node_address(e)) != 0;
+        }
+
+        ast::Visit enter_expression(ast::Expression& e) {
+            return settled(e) ? ast::Visit::Skip : ast::Visit::Continue;
+        }
+
+        void leave_expression(ast::Expression& e) {
+            const ast::Expression& view = e;
+            if (settled(view)) return;
+            size_t h = sqlparser::detail::StructuralHash(exact, &hashes)(view);
+            auto [candidate, last] = nodes.equal_range(h);
+            for (; candidate != last; ++candidate) {
+                if (structural_equal(candidate->second, view, exact)) {
+                    e = candidate->second;
+                    return;
+                }
+            }
+            auto it = nodes.emplace(h, ast::frozen_copy(view));
+            hashes.emplace(sqlparser::detail::node_address(it->second), h);
+            e = it->second;
         }
     };
 
-    auto const expression_def = 
-        (term >> *(or_kw_word >> term)) [make_or_op];
+    inline size_t item_length(std::wstring_view sql);
 
-    BOOST_SPIRIT_DEFINE(expression, term, factor, null_predicate, bitwise, sum, product, unary, primary);
+    // SELECT リスト・GROUP BY の項目の式
+    // 共有表に同じ綴りの項目があればその式を共有して読み飛ばし、なければ解析して部分木を共有表のノードに置き換え、登録する。
+    struct item_expression_type : x3::parser<item_expression_type> {
+        using attribute_type = ast::Expression;
+        static bool const has_attribute = true;
+
+        template <typename Iterator, typename Context, typename RuleContext, typename Attribute>
+        bool parse(Iterator& first, Iterator const& last, Context const& context, RuleContext const& rcontext, Attribute& attr) const {
+            SubexpressionCache* cache = get_parse_options(context).subexpressions;
+            if (!cache) return expression.parse(first, last, context, rcontext, attr);
+
+            x3::skip_over(first, last, context);
+            std::wstring_view rest(std::to_address(first), static_cast<size_t>(last - first));
+            std::wstring_view text = rest.substr(0, item_length(rest));
+            if (auto it = cache->by_text.find(text); it != cache->by_text.end()) {
+                attr = it->second;
+                first += text.size();
+                return true;
+            }
+
+            Iterator begin = first;
+            ast::Expression expr;
+            if (!expression.parse(first, last, context, rcontext, expr)) return false;
+            ast::walk(expr, *cache);
+            if (static_cast<size_t>(first - begin) == text.size()) cache->by_text.emplace(text, expr);
+            attr = std::move(expr);
+            return true;
+        }
+    } const item_expression;
 
     // --- ResultColumn (expression の後に定義) ---
     x3::rule<class result_column_class, ast::ResultColumn> const result_column = "result_column";
     auto const as_kw_opt = x3::no_case[x3::lit(L"AS")];
     
     auto const result_column_def = 
-        expression >> -(as_kw_opt >> identifier);
+        item_expression >> -(as_kw_opt >> identifier);
     
     BOOST_SPIRIT_DEFINE(result_column);
 
@@ -724,7 +1074,7 @@ namespace sqlparser::parser {
 
     // GROUP BY リスト
     auto const group_by_list = 
-        (expression % L',');
+        (item_expression % L',');
 
     // Quantifier
     auto const select_quantifier = 
@@ -735,7 +1085,7 @@ namespace sqlparser::parser {
     // --- 構造解析ロジック ---
 
     // 大文字小文字を無視して文字列比較を行うヘルパー
-    inline bool is_iequal(std::wstring const& s1, std::wstring const& s2) {
+    inline bool is_iequal(std::wstring_view s1, std::wstring_view s2) {
         if (s1.size() != s2.size()) return false;
         for (size_t i = 0; i < s1.size(); ++i) {
             if (std::towupper(s1[i]) != std::towupper(s2[i])) return false;
@@ -743,21 +1093,45 @@ namespace sqlparser::parser {
         return true;
     }
 
-    // 大文字小文字を無視してキーワードを探す (括弧を考慮)
-    inline size_t find_keyword(std::wstring const& sql, std::wstring const& kw, size_t start_pos = 0) {
+    // sql の pos から kw が始まるか (大文字小文字を無視し、kw 中の ' ' は任意の空白 1 文字に一致する)
+    inline bool match_keyword_at(std::wstring_view sql, size_t pos, std::wstring_view kw) {
+        if (pos + kw.length() > sql.length()) return false;
+        for (size_t i = 0; i < kw.length(); ++i) {
+            wchar_t c = sql[pos + i];
+            if (kw[i] == L' ' ? !is_space_char(c) : std::towupper(c) != std::towupper(kw[i])) return false;
+        }
+        return true;
+    }
+
+    // pos にある文字列リテラルまたはコメントの直後を返す (どちらでもなければ pos)
+    inline size_t skip_quoted_or_comment(std::wstring_view sql, size_t pos) {
+        if (sql[pos] == L'\'') {
+            size_t close = sql.find(L'\'', pos + 1);
+            return close == std::wstring_view::npos ? sql.length() : close + 1;
+        }
+        return static_cast<size_t>(skip_comment(sql.begin() + pos, sql.end()) - sql.begin());
+    }
+
+    // 大文字小文字を無視してキーワードを探す (括弧・文字列リテラル・コメントを考慮)
+    // sql.substr() による一時文字列を作らないよう string_view 上で比較する
+    inline size_t find_keyword(std::wstring_view sql, std::wstring_view kw, size_t start_pos = 0) {
         size_t pos = start_pos;
         size_t len = sql.length();
-        size_t kw_len = kw.length();
         int paren_depth = 0;
 
         while (pos < len) {
             wchar_t c = sql[pos];
+            size_t skipped = skip_quoted_or_comment(sql, pos);
+            if (skipped != pos) {
+                pos = skipped;
+                continue;
+            }
             if (c == L'(') {
                 paren_depth++;
             } else if (c == L')') {
                 if (paren_depth > 0) paren_depth--;
             } else if (paren_depth == 0) {
-                if (pos + kw_len <= len && is_iequal(sql.substr(pos, kw_len), kw)) {
+                if (match_keyword_at(sql, pos, kw)) {
                     return pos;
                 }
             }
@@ -766,292 +1140,336 @@ namespace sqlparser::parser {
         return std::wstring::npos;
     }
 
-    // カンマで分割するヘルパー (括弧を考慮)
-    inline std::vector<std::wstring> split_by_comma(std::wstring const& str) {
-        std::vector<std::wstring> result;
-        int paren_depth = 0;
-        size_t start = 0;
-        for (size_t i = 0; i < str.length(); ++i) {
-            if (str[i] == L'(') paren_depth++;
-            else if (str[i] == L')') {
-                if (paren_depth > 0) paren_depth--;
-            } else if (str[i] == L',' && paren_depth == 0) {
-                result.push_back(str.substr(start, i - start));
-                start = i + 1;
+    // --- 字句スキャン用ヘルパー ---
+    // 式の AST を作らずに SQL テキストを走査する高速経路 (extract_tables など) で使う。
+
+    // 識別子を構成する文字か (identifier ルールと同じく英数字, '_', '.')
+    // ASCII は表引きなしで判定し、非 ASCII のみ Unicode 分類にフォールバックする
+    inline bool is_identifier_char(wchar_t c) {
+        if (c < 0x80) {
+            return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') ||
+                   (c >= L'0' && c <= L'9') || c == L'_' || c == L'.';
+        }
+        return boost::spirit::char_encoding::unicode::isalnum(static_cast<boost::uint32_t>(c));
+    }
+
+    // pos 以降の空白とコメントを読み飛ばした位置を返す
+    inline size_t skip_spaces(std::wstring_view sql, size_t pos) {
+        while (pos < sql.length()) {
+            if (is_space_char(sql[pos])) {
+                ++pos;
+                continue;
             }
+            size_t next = static_cast<size_t>(skip_comment(sql.begin() + pos, sql.end()) - sql.begin());
+            if (next == pos) break;
+            pos = next;
         }
-        result.push_back(str.substr(start));
-        return result;
+        return pos;
     }
 
-    // テーブル参照をパースするヘルパー
-    inline bool parse_table_reference(std::wstring const& sql, ast::TableReference& table_ref) {
-        auto begin = sql.begin();
-        auto end = sql.end();
-        
-        // 前後の空白をスキップ
-        while (begin != end && std::iswspace(*begin)) ++begin;
-        auto real_end = end;
-        while (real_end != begin && std::iswspace(*(real_end - 1))) --real_end;
+    // pos から始まる識別子の終端を返す (識別子でなければ pos)
+    inline size_t scan_word(std::wstring_view sql, size_t pos) {
+        while (pos < sql.length() && is_identifier_char(sql[pos])) ++pos;
+        return pos;
+    }
 
-        if (begin != real_end && *begin == L'(') {
-            // サブクエリ
-            // 最後の ')' を探す
-            auto rparen_it = real_end - 1;
-            while (rparen_it != begin && *rparen_it != L')') --rparen_it;
-            
-            if (*rparen_it == L')') {
-                 std::wstring subquery_sql(begin + 1, rparen_it);
-                 ast::SelectStatement sub_stmt;
-                 // 前方宣言された parse を呼び出す必要があるが、inline 定義されているため
-                 // ここで再帰呼び出しを行うには parse のプロトタイプ宣言が必要。
-                 // しかし、C++では定義済みの関数は呼び出せる。
-                 // parse はこの関数の後に定義されるため、この関数を parse の前に置くか、
-                 // parse 内でラムダを使うか、構造を変える必要がある。
-                 // ここでは parse を呼び出したいが、まだ定義されていない。
-                 // 解決策: parse_table_reference を parse の内部関数にするか、
-                 // parse のプロトタイプを前に置く。
-                 // ここでは parse のプロトタイプを前に置くことにする。
-                 return false; // プレースホルダー。実際には parse を呼び出す。
+    // pos にある '(' に対応する ')' の位置を返す (文字列リテラル・コメント内の括弧は無視)
+    inline size_t find_closing_paren(std::wstring_view sql, size_t pos) {
+        int depth = 0;
+        bool in_string = false;
+        for (size_t i = pos; i < sql.length(); ++i) {
+            wchar_t c = sql[i];
+            if (in_string) {
+                if (c == L'\'') in_string = false;
+                continue;
+            }
+            size_t comment_end = static_cast<size_t>(skip_comment(sql.begin() + i, sql.end()) - sql.begin());
+            if (comment_end != i) {
+                i = comment_end - 1;
+            } else if (c == L'\'') {
+                in_string = true;
+            } else if (c == L'(') {
+                depth++;
+            } else if (c == L')') {
+                if (--depth == 0) return i;
+            }
+        }
+        return std::wstring::npos;
+    }
+
+    // SELECT リスト・GROUP BY の項目 1 つの綴りの長さ
+    // 括弧・文字列リテラル・コメントの外にある ',' か AS の手前まで (末尾の空白とコメントは含めない)
+    inline size_t item_length(std::wstring_view sql) {
+        size_t pos = 0;
+        size_t end = 0;
+        while (pos < sql.length()) {
+            wchar_t c = sql[pos];
+            if (c == L',') break;
+            if (size_t skipped = skip_quoted_or_comment(sql, pos); skipped != pos) {
+                if (c == L'\'') end = skipped;
+                pos = skipped;
+            } else if (c == L'(') {
+                size_t close = find_closing_paren(sql, pos);
+                if (close == std::wstring_view::npos) return sql.length();
+                pos = end = close + 1;
+            } else if (is_identifier_char(c)) {
+                size_t w = scan_word(sql, pos);
+                if (is_iequal(sql.substr(pos, w - pos), L"AS")) break;
+                pos = end = w;
+            } else if (is_space_char(c)) {
+                ++pos;
             } else {
-                return false;
+                pos = end = pos + 1;
             }
-        } else {
-            // 通常のテーブル名
-            std::wstring table_part(begin, real_end);
-            auto t_begin = table_part.begin();
-            auto t_end = table_part.end();
-            std::wstring table_name;
-            if (!x3::phrase_parse(t_begin, t_end, identifier, x3::unicode::space, table_name)) return false;
-            ast::Table t;
-            t.name = table_name;
-            table_ref = t;
-            return true;
         }
+        return end;
     }
 
-    // プロトタイプ宣言
-    inline bool parse(std::wstring const& sql, ast::SelectStatement& ast);
+    // JOIN キーワード列の照合結果
+    struct JoinKeyword {
+        ast::JoinType type = ast::JoinType::INNER;
+        bool natural = false;
+        bool cross = false;
+        size_t end = 0; // "JOIN" の直後の位置
+    };
 
-    // 実装を修正した parse_table_reference
-    inline bool parse_table_reference_impl(std::wstring const& sql, ast::TableReference& table_ref) {
-        auto begin = sql.begin();
-        auto end = sql.end();
-        
-        while (begin != end && std::iswspace(*begin)) ++begin;
-        auto real_end = end;
-        while (real_end != begin && std::iswspace(*(real_end - 1))) --real_end;
-
-        // エイリアスのパース
-        // 末尾から識別子を探す
-        // ただし、サブクエリの場合は ')' の後にあるかもしれない
-        // テーブル名の場合は "table alias" または "table AS alias"
-        
-        // 簡易実装: 末尾の単語をエイリアス候補としてチェック
-        // ただし、AS がある場合もある
-        
-        // ここでは x3::phrase_parse を使って、
-        // (subquery | identifier) >> -( [AS] identifier )
-        // のようにパースしたいが、sql は文字列なので、
-        // 文字列全体をパースするルールを作るのが良い。
-
-        // サブクエリのルール
-        // '(' >> ... >> ')'
-        // これは再帰呼び出しが必要なので、x3::rule だけでは難しい（parse関数を呼びたい）
-        // しかし、parse関数は SelectStatement を返す。
-        
-        // 戦略:
-        // 1. 文字列全体をスキャンして、サブクエリかテーブル名か判断する
-        // 2. エイリアス部分を分離する
-
-        // エイリアス分離ロジック
-        // 後ろから見て、識別子があればエイリアスの可能性
-        // その前に AS があれば確定
-        // サブクエリの場合は ')' の後ろ
-        
-        // もっと単純に、x3::parse で構造を定義する
-        
-        // テーブル名 + エイリアス
-        auto const as_kw = x3::no_case[x3::lit(L"AS")];
-        auto const alias_def = -(as_kw) >> identifier;
-        
-        // テーブル名のみのパース
-        // identifier >> -alias_def
-        
-        // しかし、サブクエリの中身は parse() で処理したい。
-        
-        // 手順:
-        // 1. 先頭が '(' ならサブクエリ
-        if (begin != real_end && *begin == L'(') {
-            // 対応する閉じ括弧を探す
-            int paren_level = 0;
-            auto it = begin;
-            auto subquery_end = end;
-            
-            for (; it != end; ++it) {
-                if (*it == L'(') paren_level++;
-                else if (*it == L')') {
-                    paren_level--;
-                    if (paren_level == 0) {
-                        subquery_end = it + 1; // ')' の次
-                        break;
-                    }
-                }
+    // pos から [NATURAL] [INNER | CROSS | {LEFT | RIGHT | FULL} [OUTER]] JOIN を照合する
+    // pos は単語の先頭であること
+    inline bool match_join_keyword(std::wstring_view sql, size_t pos, JoinKeyword& out) {
+        out = JoinKeyword();
+        auto word_at = [&](size_t p) { return sql.substr(p, scan_word(sql, p) - p); };
+
+        std::wstring_view w = word_at(pos);
+        if (is_iequal(w, L"NATURAL")) {
+            out.natural = true;
+            pos = skip_spaces(sql, pos + w.length());
+            w = word_at(pos);
+        }
+
+        if (is_iequal(w, L"INNER")) {
+            out.type = ast::JoinType::INNER;
+        } else if (is_iequal(w, L"CROSS")) {
+            out.cross = true;
+        } else if (is_iequal(w, L"LEFT") || is_iequal(w, L"RIGHT") || is_iequal(w, L"FULL")) {
+            out.type = is_iequal(w, L"LEFT") ? ast::JoinType::LEFT
+                     : is_iequal(w, L"RIGHT") ? ast::JoinType::RIGHT
+                     : ast::JoinType::FULL;
+            size_t next = skip_spaces(sql, pos + w.length());
+            if (is_iequal(word_at(next), L"OUTER")) {
+                pos = next;
+                w = word_at(pos);
             }
-            
-            if (subquery_end == end && paren_level > 0) return false; // 括弧が閉じていない
-            
-            // サブクエリ部分
-            std::wstring subquery_sql(begin + 1, subquery_end - 1);
+        } else if (!is_iequal(w, L"JOIN")) {
+            return false;
+        }
+
+        if (!is_iequal(w, L"JOIN")) {
+            pos = skip_spaces(sql, pos + w.length());
+            w = word_at(pos);
+            if (!is_iequal(w, L"JOIN")) return false;
+        }
+        out.end = pos + w.length();
+        return true;
+    }
+
+    // テーブル名の直後に来てもエイリアスとはみなさない語
+    inline bool is_alias_stop_word(std::wstring_view w) {
+        static const wchar_t* const words[] = {
+            L"ON", L"USING", L"JOIN", L"INNER", L"LEFT", L"RIGHT", L"FULL", L"OUTER",
+            L"CROSS", L"NATURAL", L"WHERE", L"GROUP", L"HAVING", L"ORDER", L"LIMIT",
+            L"OFFSET", L"UNION"
+        };
+        for (const wchar_t* kw : words) {
+            if (is_iequal(w, kw)) return true;
+        }
+        return false;
+    }
+
+    // ON 条件の終端 (次の JOIN キーワードかトップレベルの ',') を返す
+    inline size_t find_join_condition_end(std::wstring_view from, size_t pos) {
+        while (pos < from.length()) {
+            wchar_t c = from[pos];
+            if (size_t skipped = skip_quoted_or_comment(from, pos); skipped != pos) {
+                pos = skipped;
+            } else if (c == L'(') {
+                size_t close = find_closing_paren(from, pos);
+                if (close == std::wstring::npos) return from.length();
+                pos = close + 1;
+            } else if (c == L',') {
+                return pos;
+            } else if (is_identifier_char(c)) {
+                JoinKeyword jk;
+                if (match_join_keyword(from, pos, jk)) return pos;
+                pos = scan_word(from, pos);
+            } else {
+                ++pos;
+            }
+        }
+        return pos;
+    }
+
+    // テーブル参照 1 つ (テーブル名 [[AS] エイリアス] / (サブクエリ) [[AS] エイリアス]) を pos から読む
+    // from は FROM 句の終端で切った SQL。成功時 pos は読み終えた位置を指す
+    inline bool parse_table_ref(std::wstring_view from, size_t& pos, ast::TableReference& table_ref,
+                                const ParseOptions& options = {}) {
+        pos = skip_spaces(from, pos);
+        if (pos >= from.length()) return false;
+
+        boost::optional<Identifier>* alias = nullptr;
+        if (from[pos] == L'(') {
+            // サブクエリ
+            size_t close = find_closing_paren(from, pos);
+            if (close == std::wstring::npos) return false;
             ast::SelectStatement sub_stmt;
-            if (!parse(subquery_sql, sub_stmt)) return false;
-            
+            if (!parse(from.substr(pos + 1, close - pos - 1), sub_stmt, options)) return false;
             ast::Subquery sub_node;
-            sub_node.select = sub_stmt;
-            
-            // エイリアス部分
-            auto alias_begin = subquery_end;
-            while (alias_begin != end && std::iswspace(*alias_begin)) ++alias_begin;
-            
-            if (alias_begin != end) {
-                std::wstring alias_part(alias_begin, end);
-                std::wstring alias;
-                auto a_begin = alias_part.begin();
-                auto a_end = alias_part.end();
-                if (x3::phrase_parse(a_begin, a_end, alias_def, x3::unicode::space, alias)) {
-                    sub_node.alias = alias;
-                }
-            }
-            
-            table_ref = sub_node;
-            return true;
+            sub_node.select = std::move(sub_stmt);
+            table_ref = std::move(sub_node);
+            alias = &boost::get<ast::Subquery>(table_ref).alias;
+            pos = close + 1;
         } else {
-            // テーブル名 + エイリアス
-            // identifier >> -( [AS] identifier )
-            
-            struct TableInfo {
-                std::wstring name;
-                boost::optional<std::wstring> alias;
-            };
-            
-            auto const table_parser = 
-                identifier >> -alias_def;
-                
-            // std::tuple<std::wstring, boost::optional<std::wstring>>
-            std::tuple<std::wstring, boost::optional<std::wstring>> attr;
-            
-            auto t_begin = begin;
-            auto t_end = real_end; // real_end はイテレータ
-            
-            // phrase_parse は入力イテレータを進める
-            if (!x3::phrase_parse(t_begin, t_end, table_parser, x3::unicode::space, attr)) return false;
-            
-            // 最後までパースできたか確認 (phrase_parse はスキップ後の位置を返す)
-            if (t_begin != t_end) return false; 
-            
+            size_t name_end = scan_word(from, pos);
+            if (name_end == pos || is_alias_stop_word(from.substr(pos, name_end - pos))) return false;
             ast::Table table_node;
-            table_node.name = std::get<0>(attr);
-            table_node.alias = std::get<1>(attr);
-            
-            table_ref = table_node;
+            table_node.name = Identifier(from.substr(pos, name_end - pos));
+            table_ref = std::move(table_node);
+            alias = &boost::get<ast::Table>(table_ref).alias;
+            pos = name_end;
+        }
+
+        // エイリアス
+        size_t p = skip_spaces(from, pos);
+        size_t w = scan_word(from, p);
+        if (is_iequal(from.substr(p, w - p), L"AS")) {
+            p = skip_spaces(from, w);
+            w = scan_word(from, p);
+            if (w == p) return false;
+        } else if (is_alias_stop_word(from.substr(p, w - p))) {
             return true;
         }
+        if (w > p) {
+            *alias = Identifier(from.substr(p, w - p));
+            pos = w;
+        }
+        return true;
     }
 
-    // SQL全体をパースする関数
-    // 再帰的に呼び出されるため、UNIONの処理もここで行う
-    inline bool parse(std::wstring const& sql_in, ast::SelectStatement& ast) {
-        // 前後の空白を除去する。
-        // "EXISTS ( SELECT ... )" のように括弧の直後に空白が入るケースでは、
-        // サブクエリ文字列の先頭に空白が残ったまま渡されるため、
-        // それを考慮せずに "SELECT" が先頭(位置0)にあるかを判定すると
-        // 誤って parse 失敗になり、EXISTS 式全体が消失してしまう。
-        std::wstring sql;
-        {
-            size_t ws_begin = sql_in.find_first_not_of(L" \t\r\n");
-            if (ws_begin == std::wstring::npos) return false;
-            size_t ws_end = sql_in.find_last_not_of(L" \t\r\n");
-            sql = sql_in.substr(ws_begin, ws_end - ws_begin + 1);
+    // USING (col, ...) の括弧内を読む (pos は '(' の手前)
+    inline bool parse_using_columns(std::wstring_view from, size_t& pos, std::vector<Identifier>& columns) {
+        pos = skip_spaces(from, pos);
+        if (pos >= from.length() || from[pos] != L'(') return false;
+        ++pos;
+        while (true) {
+            pos = skip_spaces(from, pos);
+            size_t w = scan_word(from, pos);
+            if (w == pos) return false;
+            columns.emplace_back(from.substr(pos, w - pos));
+            pos = skip_spaces(from, w);
+            if (pos >= from.length()) return false;
+            if (from[pos] == L')') {
+                ++pos;
+                return true;
+            }
+            if (from[pos] != L',') return false;
+            ++pos;
         }
+    }
 
-        // UNION の分割
-        // 括弧内の UNION は無視する必要があるため、単純な find_keyword では不十分かもしれないが、
-        // ここではトップレベルの UNION を探す簡易的な実装とする。
-        // ただし、サブクエリ内の UNION にマッチしないように注意が必要。
-        // 括弧のネストレベルを考慮して分割する。
+    // --- 句スキャナ ---
 
-        size_t union_pos = std::wstring::npos;
+    // 句の範囲 ([begin, end) は SQL 文字列内のオフセット。キーワード自体は含まない)
+    struct ClauseRange {
+        size_t begin = std::wstring::npos;
+        size_t end = std::wstring::npos;
+
+        bool present() const { return begin != std::wstring::npos; }
+    };
+
+    // scan_clauses() の結果
+    // トップレベルの UNION がある場合、各句の範囲は左側の SELECT のみを指し、
+    // union_rest が右側の SELECT 全体 (後続の UNION を含む) を指す
+    struct ClauseRanges {
+        ClauseRange header;  // SELECT の後 (修飾子 + カラムリスト)
+        ClauseRange from;
+        ClauseRange where;
+        ClauseRange groupBy;
+        ClauseRange having;
+        ClauseRange orderBy;
+        ClauseRange limit;
+        ClauseRange offset;
+        ClauseRange union_rest;
         ast::SetOperationType union_type = ast::SetOperationType::Union;
-        size_t union_len = 0;
+    };
+
+    // 前後の空白を除去した範囲を返す
+    // "EXISTS ( SELECT ... )" のように括弧の直後に空白が入るケースでは、
+    // サブクエリ文字列の先頭に空白が残ったまま渡されるため、
+    // それを考慮せずに "SELECT" が先頭(位置0)にあるかを判定すると
+    // 誤って parse 失敗になり、EXISTS 式全体が消失してしまう。
+    // 先頭のコメント (ORM が付けるヒントなど) も除去する。
+    inline std::wstring_view trim_sql(std::wstring_view sql) {
+        size_t ws_begin = skip_spaces(sql, 0);
+        if (ws_begin == sql.length()) return {};
+        size_t ws_end = sql.length();
+        while (ws_end > ws_begin && is_space_char(sql[ws_end - 1])) --ws_end;
+        return sql.substr(ws_begin, ws_end - ws_begin);
+    }
 
+    // 句の位置だけを特定する (式の解析は行わない)
+    // sql は trim_sql() 済みであること
+    inline bool scan_clauses(std::wstring_view sql, ClauseRanges& ranges) {
+        ranges = ClauseRanges();
+
+        // UNION の分割
+        // 括弧のネストレベルを考慮し、トップレベルの最初の UNION で分割する。
+        size_t union_pos = std::wstring::npos;
         int paren_level = 0;
         for (size_t i = 0; i < sql.length(); ++i) {
+            size_t skipped = skip_quoted_or_comment(sql, i);
+            if (skipped != i) {
+                i = skipped - 1;
+                continue;
+            }
             if (sql[i] == L'(') paren_level++;
             else if (sql[i] == L')') paren_level--;
             else if (paren_level == 0) {
-                // UNION を探す
                 // " UNION "
-                if (i + 7 <= sql.length() && is_iequal(sql.substr(i, 7), L" UNION ")) {
+                if (match_keyword_at(sql, i, L" UNION ")) {
                     union_pos = i;
-                    union_len = 7;
-                    union_type = ast::SetOperationType::Union;
-                    
+                    size_t union_len = 7;
+                    ranges.union_type = ast::SetOperationType::Union;
+
                     // UNION ALL チェック
-                    if (i + 11 <= sql.length() && is_iequal(sql.substr(i, 11), L" UNION ALL ")) {
+                    if (match_keyword_at(sql, i, L" UNION ALL ")) {
                         union_len = 11;
-                        union_type = ast::SetOperationType::UnionAll;
+                        ranges.union_type = ast::SetOperationType::UnionAll;
                     }
+                    ranges.union_rest = { i + union_len, sql.length() };
                     break; // 最初の UNION で分割
                 }
             }
         }
 
-        if (union_pos != std::wstring::npos) {
-            // UNION が見つかった場合
-            std::wstring left_sql = sql.substr(0, union_pos);
-            std::wstring right_sql = sql.substr(union_pos + union_len);
+        // 左側 (UNION がなければ全体) の SELECT
+        std::wstring_view stmt = sql.substr(0, union_pos);
 
-            // 左側をパース (再帰)
-            if (!parse(left_sql, ast)) return false;
-
-            // 右側をパース (再帰)
-            ast::SelectStatement right_ast;
-            if (!parse(right_sql, right_ast)) return false;
-
-            // カラム数チェック
-            if (ast.columns.size() != right_ast.columns.size()) {
-                std::wcerr << L"Error: UNION column count mismatch. Left: " << ast.columns.size() << L", Right: " << right_ast.columns.size() << std::endl;
-                return false;
-            }
-
-            // UNION句を追加
-            ast::UnionClause union_clause;
-            union_clause.type = union_type;
-            union_clause.select = right_ast;
-            ast.unions.push_back(union_clause);
-
-            return true;
-        }
-
-        // UNION がない場合、通常の SELECT 文としてパース
         // 1. キーワードの位置を特定する
-        size_t select_pos = find_keyword(sql, L"SELECT");
+        size_t select_pos = find_keyword(stmt, L"SELECT");
         if (select_pos != 0) return false;
 
-        size_t from_pos = find_keyword(sql, L" FROM ", select_pos);
-        // if (from_pos == std::wstring::npos) return false; // Allow missing FROM
+        size_t from_pos = find_keyword(stmt, L" FROM ", select_pos);
 
         size_t search_start_pos = (from_pos != std::wstring::npos) ? from_pos : select_pos;
-        size_t where_pos = find_keyword(sql, L" WHERE ", search_start_pos);
-        size_t group_by_pos = find_keyword(sql, L" GROUP BY ", search_start_pos);
-        size_t having_pos = find_keyword(sql, L" HAVING ", search_start_pos);
-        size_t order_by_pos = find_keyword(sql, L" ORDER BY ", search_start_pos);
-        size_t limit_pos = find_keyword(sql, L" LIMIT ", search_start_pos);
-        size_t offset_pos = find_keyword(sql, L" OFFSET ", search_start_pos);
+        size_t where_pos = find_keyword(stmt, L" WHERE ", search_start_pos);
+        size_t group_by_pos = find_keyword(stmt, L" GROUP BY ", search_start_pos);
+        size_t having_pos = find_keyword(stmt, L" HAVING ", search_start_pos);
+        size_t order_by_pos = find_keyword(stmt, L" ORDER BY ", search_start_pos);
+        size_t limit_pos = find_keyword(stmt, L" LIMIT ", search_start_pos);
+        size_t offset_pos = find_keyword(stmt, L" OFFSET ", search_start_pos);
 
         // 各セクションの終了位置を計算するヘルパー
         auto get_end_pos = [&](size_t start, std::initializer_list<size_t> candidates) {
-            size_t end = sql.length();
+            size_t end = stmt.length();
             for (size_t pos : candidates) {
                 if (pos != std::wstring::npos && pos > start && pos < end) {
                     end = pos;
@@ -1060,34 +1478,55 @@ namespace sqlparser::parser {
             return end;
         };
 
+        // SELECT (len 6) の後から FROM の前まで
         size_t columns_end = (from_pos != std::wstring::npos) ? from_pos : get_end_pos(select_pos, {where_pos, group_by_pos, having_pos, order_by_pos, limit_pos, offset_pos});
-        size_t table_end = (from_pos != std::wstring::npos) ? get_end_pos(from_pos, {where_pos, group_by_pos, having_pos, order_by_pos, limit_pos, offset_pos}) : 0;
-        size_t where_end = (where_pos != std::wstring::npos) ? get_end_pos(where_pos, {group_by_pos, having_pos, order_by_pos, limit_pos, offset_pos}) : 0;
-        size_t group_by_end = (group_by_pos != std::wstring::npos) ? get_end_pos(group_by_pos, {having_pos, order_by_pos, limit_pos, offset_pos}) : 0;
-        size_t having_end = (having_pos != std::wstring::npos) ? get_end_pos(having_pos, {order_by_pos, limit_pos, offset_pos}) : 0;
-        size_t order_by_end = (order_by_pos != std::wstring::npos) ? get_end_pos(order_by_pos, {limit_pos, offset_pos}) : 0;
-        size_t limit_end = (limit_pos != std::wstring::npos) ? get_end_pos(limit_pos, {offset_pos}) : 0;
+        ranges.header = { select_pos + 6, columns_end };
 
-        // 2. 各パートの切り出しとパース
+        // 2. 各句の範囲 (キーワード長を除いた本体)
+        if (from_pos != std::wstring::npos) {
+            // " FROM " の長さは 6
+            ranges.from = { from_pos + 6, get_end_pos(from_pos, {where_pos, group_by_pos, having_pos, order_by_pos, limit_pos, offset_pos}) };
+        }
+        if (where_pos != std::wstring::npos) {
+            // " WHERE " の長さは 7
+            ranges.where = { where_pos + 7, get_end_pos(where_pos, {group_by_pos, having_pos, order_by_pos, limit_pos, offset_pos}) };
+        }
+        if (group_by_pos != std::wstring::npos) {
+            // " GROUP BY " の長さは 10
+            ranges.groupBy = { group_by_pos + 10, get_end_pos(group_by_pos, {having_pos, order_by_pos, limit_pos, offset_pos}) };
+        }
+        if (having_pos != std::wstring::npos) {
+            // " HAVING " の長さは 8
+            ranges.having = { having_pos + 8, get_end_pos(having_pos, {order_by_pos, limit_pos, offset_pos}) };
+        }
+        if (order_by_pos != std::wstring::npos) {
+            // " ORDER BY " の長さは 10
+            ranges.orderBy = { order_by_pos + 10, get_end_pos(order_by_pos, {limit_pos, offset_pos}) };
+        }
+        if (limit_pos != std::wstring::npos) {
+            // " LIMIT " の長さは 7
+            ranges.limit = { limit_pos + 7, get_end_pos(limit_pos, {offset_pos}) };
+        }
+        if (offset_pos != std::wstring::npos) {
+            // " OFFSET " の長さは 8
+            ranges.offset = { offset_pos + 8, stmt.length() };
+        }
+        return true;
+    }
 
-        // Columns (Header)
-        // SELECT (len 6) の後から FROM の前まで
-        auto header_begin = sql.begin() + select_pos + 6;
-        auto header_end = sql.begin() + columns_end;
-        
-        // boost::fusion::vector を使うためにヘッダが必要だが、
-        // ここでは直接パース結果を受け取る構造体を使うか、
-        // あるいは std::tuple を使う (X3 は std::tuple にも対応している)
-        // しかし、ast::SelectStatement のフィールドに直接パースするのは難しい（順序が違うため）
-        
-        // 一時的な属性変数を用意
-        boost::optional<ast::SelectQuantifier> quantifier_attr;
-        std::vector<ast::ResultColumn> columns_attr;
+    // --- 句ごとのパーサー ---
+    // いずれも scan_clauses() が返した範囲だけを解析する。
+    // LazySelectStatement (lazy.hpp) からも個別に呼び出される。
 
-        // X3 の attribute propagation ルールに従い、シーケンスの各要素をそれぞれの変数にバインドする
-        // これには x3::rule を使うのが一番簡単だが、ローカル変数に直接入れるには参照を使う
-        
-        auto const parser = 
+    // SELECT [修飾子] カラムリスト
+    inline bool parse_header_clause(std::wstring_view sql, ClauseRange range,
+                                    ast::SelectQuantifier& quantifier,
+                                    std::vector<ast::ResultColumn>& columns,
+                                    const ParseOptions& options = {}) {
+        auto header_begin = sql.begin() + range.begin;
+        auto header_end = sql.begin() + range.end;
+
+        auto const parser =
             -(select_quantifier) >> column_list;
 
         // std::tuple で受ける
@@ -1096,189 +1535,159 @@ namespace sqlparser::parser {
             std::vector<ast::ResultColumn>
         > header_attr;
 
-        if (!x3::phrase_parse(header_begin, header_end, parser, x3::unicode::space, header_attr)) return false;
-
-        // 代入
-        if (std::get<0>(header_attr)) ast.quantifier = *std::get<0>(header_attr);
-        ast.columns = std::get<1>(header_attr);
-
-        // Table & Joins
-        if (from_pos != std::wstring::npos) {
-            // " FROM " の長さは 6
-            std::wstring from_section = sql.substr(from_pos + 6, table_end - (from_pos + 6));
-            
-            auto segments = split_by_comma(from_section);
-            
-            for (size_t i = 0; i < segments.size(); ++i) {
-                std::wstring segment = segments[i];
-                
-                // JOIN キーワードのリスト
-                struct JoinKw { std::wstring kw; ast::JoinType type; };
-                std::vector<JoinKw> join_kws = {
-                    {L" LEFT OUTER JOIN ", ast::JoinType::LEFT},
-                    {L" RIGHT OUTER JOIN ", ast::JoinType::RIGHT},
-                    {L" FULL OUTER JOIN ", ast::JoinType::FULL},
-                    {L" LEFT JOIN ", ast::JoinType::LEFT},
-                    {L" RIGHT JOIN ", ast::JoinType::RIGHT},
-                    {L" FULL JOIN ", ast::JoinType::FULL},
-                    {L" INNER JOIN ", ast::JoinType::INNER},
-                    {L" JOIN ", ast::JoinType::INNER}
-                };
-
-                // このセグメント内の最初の JOIN を探す
-                size_t current_pos = 0;
-                size_t first_join_pos = std::wstring::npos;
-                ast::JoinType first_join_type = ast::JoinType::INNER;
-                size_t join_keyword_len = 0;
-
-                for (const auto& jk : join_kws) {
-                    size_t p = find_keyword(segment, jk.kw, 0);
-                    if (p != std::wstring::npos) {
-                        if (first_join_pos == std::wstring::npos || p < first_join_pos) {
-                            first_join_pos = p;
-                            first_join_type = jk.type;
-                            join_keyword_len = jk.kw.length();
-                        }
-                    }
-                }
+        if (!x3::phrase_parse(header_begin, header_end, x3::with<parse_options_tag>(options)[parser], sql_space, header_attr)) return false;
 
-                // テーブル部分の切り出し
-                std::wstring table_part = (first_join_pos == std::wstring::npos) 
-                    ? segment 
-                    : segment.substr(0, first_join_pos);
+        if (std::get<0>(header_attr)) quantifier = *std::get<0>(header_attr);
+        columns = std::move(std::get<1>(header_attr));
+        return true;
+    }
 
-                ast::TableReference current_table_ref;
-                if (!parse_table_reference_impl(table_part, current_table_ref)) return false;
+    // FROM テーブル参照 + JOIN 句
+    // FROM 句を先頭から 1 回だけ走査し、',' と JOIN キーワードで連結されたテーブル参照を順に読む。
+    // 部分文字列のコピーは作らず、ON 条件も元の SQL 上の範囲をそのまま解析する。
+    inline bool parse_from_clause(std::wstring_view sql, ClauseRange range,
+                                  ast::TableReference& table,
+                                  std::vector<ast::Join>& joins,
+                                  const ParseOptions& options = {}) {
+        std::wstring_view from = sql.substr(0, range.end);
+        size_t pos = range.begin;
+        if (!parse_table_ref(from, pos, table, options)) return false;
+
+        while (true) {
+            pos = skip_spaces(from, pos);
+            if (pos >= from.length()) return true;
+
+            ast::Join join_node;
+            if (from[pos] == L',') {
+                // カンマ区切りのテーブル -> 結合条件なしの Implicit Join
+                ++pos;
+                if (!parse_table_ref(from, pos, join_node.table, options)) return false;
+                join_node.type = ast::JoinType::IMPLICIT;
+                joins.push_back(std::move(join_node));
+                continue;
+            }
 
-                if (i == 0) {
-                    // 最初のセグメントの最初のテーブル -> ast.table
-                    ast.table = current_table_ref;
+            JoinKeyword jk;
+            if (!match_join_keyword(from, pos, jk)) return false;
+            pos = jk.end;
+            join_node.type = jk.cross ? ast::JoinType::CROSS : jk.type;
+            join_node.natural = jk.natural;
+            if (!parse_table_ref(from, pos, join_node.table, options)) return false;
+
+            // CROSS JOIN / NATURAL JOIN は結合条件を持たない
+            if (!jk.cross && !jk.natural) {
+                size_t p = skip_spaces(from, pos);
+                size_t w = scan_word(from, p);
+                std::wstring_view word = from.substr(p, w - p);
+                if (is_iequal(word, L"ON")) {
+                    size_t cond_end = find_join_condition_end(from, w);
+                    auto on_begin = from.begin() + w;
+                    auto on_end = from.begin() + cond_end;
+                    ast::Expression on;
+                    if (!x3::phrase_parse(on_begin, on_end, x3::with<parse_options_tag>(options)[expression], sql_space, on)) return false;
+                    if (on_begin != on_end) return false;
+                    join_node.on = std::move(on);
+                    pos = cond_end;
+                } else if (is_iequal(word, L"USING")) {
+                    pos = w;
+                    if (!parse_using_columns(from, pos, join_node.using_columns)) return false;
                 } else {
-                    // 2つ目以降のセグメントの最初のテーブル -> Implicit Join (INNER JOIN 1=1)
-                    ast::Join implicit_join;
-                    implicit_join.type = ast::JoinType::INNER;
-                    implicit_join.table = current_table_ref;
-                    
-                    // ON 1=1
-                    ast::BinaryOp true_op;
-                    true_op.op = ast::OpType::EQ;
-                    true_op.left = ast::IntLiteral(1);
-                    true_op.right = ast::IntLiteral(1);
-                    implicit_join.on = true_op;
-                    
-                    ast.joins.push_back(implicit_join);
-                }
-
-                // Explicit Joins の処理
-                if (first_join_pos != std::wstring::npos) {
-                    current_pos = first_join_pos;
-                    
-                    while (current_pos != std::wstring::npos) {
-                        size_t next_search_pos = current_pos + join_keyword_len;
-                        
-                        // 次の JOIN を探す
-                        size_t next_join_pos = std::wstring::npos;
-                        ast::JoinType next_join_type = ast::JoinType::INNER;
-                        size_t next_join_len = 0;
-                        
-                        for (const auto& jk : join_kws) {
-                            size_t p = find_keyword(segment, jk.kw, next_search_pos);
-                            if (p != std::wstring::npos) {
-                                if (next_join_pos == std::wstring::npos || p < next_join_pos) {
-                                    next_join_pos = p;
-                                    next_join_type = jk.type;
-                                    next_join_len = jk.kw.length();
-                                }
-                            }
-                        }
-                        
-                        // 現在の JOIN の範囲
-                        size_t content_end = (next_join_pos == std::wstring::npos) ? segment.length() : next_join_pos;
-                        std::wstring join_content = segment.substr(next_search_pos, content_end - next_search_pos);
-                        
-                        // ON を探す
-                        size_t on_pos = find_keyword(join_content, L" ON ");
-                        if (on_pos == std::wstring::npos) return false;
-                        
-                        std::wstring join_table_str = join_content.substr(0, on_pos);
-                        std::wstring join_on_str = join_content.substr(on_pos + 4); // " ON " len 4
-                        
-                        ast::Join join_node;
-                        join_node.type = first_join_type;
-                        
-                        if (!parse_table_reference_impl(join_table_str, join_node.table)) return false;
-                        
-                        // ON 句のパース
-                        auto on_begin = join_on_str.begin();
-                        auto on_end = join_on_str.end();
-                        if (!x3::phrase_parse(on_begin, on_end, expression, x3::unicode::space, join_node.on)) return false;
-                        if (on_begin != on_end) return false;
-                        
-                        ast.joins.push_back(join_node);
-                        
-                        // 次のイテレーションへ
-                        current_pos = next_join_pos;
-                        first_join_type = next_join_type;
-                        join_keyword_len = next_join_len;
-                    }
+                    return false;
                 }
             }
+            joins.push_back(std::move(join_node));
         }
+    }
 
-        // WHERE
-        if (where_pos != std::wstring::npos) {
-            // " WHERE " の長さは 7
-            auto where_begin = sql.begin() + where_pos + 7;
-            auto where_end_iter = sql.begin() + where_end;
-            ast::Expression expr;
-            if (!x3::phrase_parse(where_begin, where_end_iter, expression, x3::unicode::space, expr)) return false;
-            ast.where = expr;
-        }
+    // WHERE / HAVING / LIMIT / OFFSET (単一の式)
+    inline bool parse_expression_clause(std::wstring_view sql, ClauseRange range,
+                                        boost::optional<ast::Expression>& out,
+                                        const ParseOptions& options = {}) {
+        auto expr_begin = sql.begin() + range.begin;
+        auto expr_end = sql.begin() + range.end;
+        ast::Expression expr;
+        if (!x3::phrase_parse(expr_begin, expr_end, x3::with<parse_options_tag>(options)[expression], sql_space, expr)) return false;
+        out = std::move(expr);
+        return true;
+    }
 
-        // GROUP BY
-        if (group_by_pos != std::wstring::npos) {
-            // " GROUP BY " の長さは 10
-            auto gb_begin = sql.begin() + group_by_pos + 10;
-            auto gb_end_iter = sql.begin() + group_by_end;
-            if (!x3::phrase_parse(gb_begin, gb_end_iter, group_by_list, x3::unicode::space, ast.groupBy)) return false;
-        }
+    // 式を 1 つパースする (条件式のテンプレートなど)。式の後に余分な文字があれば失敗
+    inline bool parse_expression(std::wstring_view sql_in, ast::Expression& out, const ParseOptions& options = {}) {
+        std::wstring_view sql = trim_sql(sql_in);
+        if (sql.empty()) return false;
+        auto expr_begin = sql.begin();
+        auto expr_end = sql.end();
+        ast::Expression expr;
+        if (!x3::phrase_parse(expr_begin, expr_end, x3::with<parse_options_tag>(options)[expression], sql_space, expr)) return false;
+        if (expr_begin != expr_end) return false;
+        out = std::move(expr);
+        return true;
+    }
 
-        // HAVING
-        if (having_pos != std::wstring::npos) {
-            // " HAVING " の長さは 8
-            auto hav_begin = sql.begin() + having_pos + 8;
-            auto hav_end_iter = sql.begin() + having_end;
-            ast::Expression expr;
-            if (!x3::phrase_parse(hav_begin, hav_end_iter, expression, x3::unicode::space, expr)) return false;
-            ast.having = expr;
-        }
+    // GROUP BY 式リスト
+    inline bool parse_group_by_clause(std::wstring_view sql, ClauseRange range,
+                                      std::vector<ast::Expression>& out,
+                                      const ParseOptions& options = {}) {
+        auto gb_begin = sql.begin() + range.begin;
+        auto gb_end = sql.begin() + range.end;
+        return x3::phrase_parse(gb_begin, gb_end, x3::with<parse_options_tag>(options)[group_by_list], sql_space, out);
+    }
 
-        // ORDER BY
-        if (order_by_pos != std::wstring::npos) {
-            // " ORDER BY " の長さは 10
-            auto order_begin = sql.begin() + order_by_pos + 10;
-            auto order_end_iter = sql.begin() + order_by_end;
-            if (!x3::phrase_parse(order_begin, order_end_iter, order_by_list, x3::unicode::space, ast.orderBy)) return false;
-        }
+    // ORDER BY リスト
+    inline bool parse_order_by_clause(std::wstring_view sql, ClauseRange range,
+                                      std::vector<ast::OrderByElement>& out,
+                                      const ParseOptions& options = {}) {
+        auto order_begin = sql.begin() + range.begin;
+        auto order_end = sql.begin() + range.end;
+        return x3::phrase_parse(order_begin, order_end, x3::with<parse_options_tag>(options)[order_by_list], sql_space, out);
+    }
 
-        // LIMIT
-        if (limit_pos != std::wstring::npos) {
-            // " LIMIT " の長さは 7
-            auto limit_begin = sql.begin() + limit_pos + 7;
-            auto limit_end_iter = sql.begin() + limit_end;
-            ast::Expression expr;
-            if (!x3::phrase_parse(limit_begin, limit_end_iter, expression, x3::unicode::space, expr)) return false;
-            ast.limit = expr;
+    // SQL全体をパースする関数
+    // 再帰的に呼び出されるため、UNIONの処理もここで行う
+    inline bool parse(std::wstring_view sql_in, ast::SelectStatement& ast, const ParseOptions& options) {
+        // 共有表は文全体 (UNION の右側・サブクエリを含む) で 1 つ
+        if (options.share_subexpressions && !options.subexpressions) {
+            SubexpressionCache cache;
+            ParseOptions shared = options;
+            shared.subexpressions = &cache;
+            if (!parse(sql_in, ast, shared)) return false;
+            // SELECT リスト・GROUP BY 以外の式 (WHERE・ON など) も表のノードと共有する
+            ast::walk(ast, cache);
+            return true;
         }
 
-        // OFFSET
-        if (offset_pos != std::wstring::npos) {
-            // " OFFSET " の長さは 8
-            auto offset_begin = sql.begin() + offset_pos + 8;
-            auto offset_end_iter = sql.end();
-            ast::Expression expr;
-            if (!x3::phrase_parse(offset_begin, offset_end_iter, expression, x3::unicode::space, expr)) return false;
-            ast.offset = expr;
+        std::wstring_view sql = trim_sql(sql_in);
+        if (sql.empty()) return false;
+
+        ClauseRanges ranges;
+        if (!scan_clauses(sql, ranges)) return false;
+
+        // 各句のパース
+        if (!parse_header_clause(sql, ranges.header, ast.quantifier, ast.columns, options)) return false;
+        if (ranges.from.present() && !parse_from_clause(sql, ranges.from, ast.table, ast.joins, options)) return false;
+        if (ranges.where.present() && !parse_expression_clause(sql, ranges.where, ast.where, options)) return false;
+        if (ranges.groupBy.present() && !parse_group_by_clause(sql, ranges.groupBy, ast.groupBy, options)) return false;
+        if (ranges.having.present() && !parse_expression_clause(sql, ranges.having, ast.having, options)) return false;
+        if (ranges.orderBy.present() && !parse_order_by_clause(sql, ranges.orderBy, ast.orderBy, options)) return false;
+        if (ranges.limit.present() && !parse_expression_clause(sql, ranges.limit, ast.limit, options)) return false;
+        if (ranges.offset.present() && !parse_expression_clause(sql, ranges.offset, ast.offset, options)) return false;
+
+        if (ranges.union_rest.present()) {
+            // 右側をパース (再帰)
+            ast::SelectStatement right_ast;
+            if (!parse(sql.substr(ranges.union_rest.begin, ranges.union_rest.end - ranges.union_rest.begin), right_ast, options)) return false;
+
+            // カラム数チェック
+            if (ast.columns.size() != right_ast.columns.size()) {
+                std::wcerr << L"Error: UNION column count mismatch. Left: " << ast.columns.size() << L", Right: " << right_ast.columns.size() << std::endl;
+                return false;
+            }
+
+            // UNION句を追加
+            ast::UnionClause union_clause;
+            union_clause.type = ranges.union_type;
+            union_clause.select = std::move(right_ast);
+            ast.unions.push_back(std::move(union_clause));
         }
 
         return true;
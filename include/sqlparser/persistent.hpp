@@ -0,0 +1,40 @@
+#pragma once
+#include <utility>
+#include <sqlparser/ast.hpp>
+
+namespace sqlparser::ast {
+
+    // 不変の SELECT 文
+    // 1 回パースしたクエリから、条件だけが異なる版 (テナントごとの ID 条件など) を大量に作るためのハンドル。
+    // 構築時に AST を凍結し (frozen_copy、shared_node.hpp)、コピーは参照カウントの増加のみで、内容は const でしか参照できない。
+    //
+    // update() は根の SelectStatement だけを複製して編集関数に渡す。子ノードは元の版と共有したままで、
+    // 編集関数が非 const でたどったノード (変更の経路) だけが書き込み時に複製される (パスコピー)。
+    // 新しい版の構築で凍結し直すのも、凍結されていない変更の経路だけになる。
+    // 例えば UNION の右側に条件を追加すると、複製されるのは根・右側の SELECT 文・WHERE の論理演算ノードだけになる。
+    // 読むだけの部分は const の参照でたどること (非 const の boost::get や visitor はそのノードを複製する)。
+    class PersistentSelect {
+    public:
+        PersistentSelect() : root_(frozen_copy(boost::recursive_wrapper<SelectStatement>())) {}
+        explicit PersistentSelect(SelectStatement stmt)
+            : root_(frozen_copy(boost::recursive_wrapper<SelectStatement>(std::move(stmt)))) {}
+
+        const SelectStatement& get() const { return root_.get(); }
+        const SelectStatement& operator*() const { return root_.get(); }
+        const SelectStatement* operator->() const { return root_.get_pointer(); }
+
+        // edit(SelectStatement&) を適用した新しい版を返す (この版は変更されない)
+        template <typename F>
+        PersistentSelect update(F&& edit) const {
+            SelectStatement next = root_.get();
+            std::forward<F>(edit)(next);
+            return PersistentSelect(std::move(next));
+        }
+
+        // 同じ根を共有しているか (update を経ていないコピー同士なら true)
+        bool same_root(const PersistentSelect& other) const { return root_.get_pointer() == other.root_.get_pointer(); }
+
+    private:
+        boost::recursive_wrapper<SelectStatement> root_;
+    };
+}
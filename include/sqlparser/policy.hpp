@@ -0,0 +1,220 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/parser.hpp>
+#include <sqlparser/traverse.hpp>
+
+namespace sqlparser {
+
+    namespace detail {
+
+        // 修飾子のないカラム参照か (NULL / TRUE / FALSE と * は除く)
+        inline bool is_unqualified_column(std::wstring_view name) {
+            ast::detail::IgnoreCaseEqual iequal;
+            return !name.empty() && name != L"*" && name.find(L'.') == std::wstring_view::npos &&
+                   !iequal(name, L"NULL") && !iequal(name, L"TRUE") && !iequal(name, L"FALSE");
+        }
+
+        // テンプレートの修飾子のないカラム参照を "qualifier.column" に書き換える (テンプレート内のサブクエリは別スコープなので対象外)
+        struct ColumnQualifier {
+            std::wstring_view qualifier;
+
+            ast::Visit enter(ast::SelectStatement&) { return ast::Visit::Skip; }
+
+            void enter(Identifier& id) {
+                std::wstring_view name = id;
+                if (!is_unqualified_column(name)) return;
+                // 短い名前は一時的な std::wstring を作らずに組み立てる
+                wchar_t buf[64];
+                size_t length = qualifier.size() + 1 + name.size();
+                if (length <= std::size(buf)) {
+                    std::wstring_view::traits_type::copy(buf, qualifier.data(), qualifier.size());
+                    buf[qualifier.size()] = L'.';
+                    std::wstring_view::traits_type::copy(buf + qualifier.size() + 1, name.data(), name.size());
+                    id = Identifier(std::wstring_view(buf, length));
+                } else {
+                    String qualified;
+                    qualified.reserve(length);
+                    qualified.append(qualifier).append(1, L'.').append(name);
+                    id = Identifier(qualified);
+                }
+            }
+        };
+
+        struct UnqualifiedColumnFinder {
+            bool found = false;
+
+            ast::Visit enter(const ast::SelectStatement&) { return ast::Visit::Skip; }
+
+            ast::Visit enter(const Identifier& id) {
+                found = is_unqualified_column(id);
+                return found ? ast::Visit::Stop : ast::Visit::Continue;
+            }
+        };
+    }
+
+    // 行レベルセキュリティのポリシー (テーブル名 → 条件式のテンプレート)
+    // apply() は SELECT 文中の全てのテーブル参照 (FROM・JOIN・派生テーブル・EXISTS サブクエリ・UNION の各ブランチ) に、
+    // 登録されたテーブルであれば条件式を AST の 1 回の走査で追加する。
+    // テンプレート中の修飾子のないカラム名は、参照ごとのエイリアス (なければテーブル名) で修飾される。
+    //
+    // 条件の置き場所は外部結合の意味を変えないように選ぶ:
+    //   - NULL で補われない (FROM のテーブル、INNER / CROSS / カンマ区切り / RIGHT JOIN の結合先) : その SELECT 文の WHERE
+    //   - LEFT JOIN の結合先 (以降に RIGHT / FULL JOIN がない場合)                                 : その JOIN の ON
+    //   - それ以外 (FULL JOIN、RIGHT / FULL JOIN の左側、USING / NATURAL の LEFT JOIN)            :
+    //     テーブルを "(SELECT * FROM t alias WHERE 条件) alias" の派生テーブルに置き換える
+    class RowSecurityPolicy {
+    public:
+        // table (スキーマ修飾可、大文字小文字を区別しない) の条件式を登録する。同じテーブルに複数登録すると AND で結合する
+        // predicate_sql をパースできなければ false
+        bool add(std::wstring_view table, std::wstring_view predicate_sql) {
+            ast::Expression predicate;
+            if (!parser::parse_expression(predicate_sql, predicate)) return false;
+            add_expression(table, std::move(predicate));
+            return true;
+        }
+
+        // 条件式を AST で登録する
+        void add_expression(std::wstring_view table, ast::Expression predicate) {
+            auto it = index_.find(table);
+            if (it == index_.end()) {
+                it = index_.emplace(String(table), static_cast<uint32_t>(policies_.size())).first;
+                policies_.emplace_back();
+                policies_.back().predicate = std::move(predicate);
+            } else {
+                ast::combine(policies_[it->second].predicate, std::move(predicate), ast::OpType::AND);
+            }
+            Policy& policy = policies_[it->second];
+            const ast::Expression& view = policy.predicate;
+            detail::UnqualifiedColumnFinder finder;
+            ast::walk(view, finder);
+            policy.qualify = finder.found;
+        }
+
+        size_t size() const { return policies_.size(); }
+        bool empty() const { return policies_.empty(); }
+
+        // stmt に条件式を追加し、追加した件数を返す
+        size_t apply(ast::SelectStatement& stmt) const {
+            if (policies_.empty()) return 0;
+            Injector injector(*this);
+            ast::walk(stmt, injector);
+            return injector.injected;
+        }
+
+    private:
+        struct Policy {
+            ast::Expression predicate;
+            bool qualify = false; // 修飾子のないカラム参照を含むか
+        };
+
+        // テーブル名 (スキーマ修飾付きなら修飾なしの名前でも) からポリシーを引く
+        const Policy* find(std::wstring_view name) const {
+            auto it = index_.find(name);
+            if (it == index_.end()) {
+                size_t dot = name.rfind(L'.');
+                if (dot == std::wstring_view::npos) return nullptr;
+                it = index_.find(name.substr(dot + 1));
+                if (it == index_.end()) return nullptr;
+            }
+            return &policies_[it->second];
+        }
+
+        // 1 回の apply の状態
+        // 後置順 (leave) で SELECT 文ごとに条件を追加する。内側のサブクエリは先に処理済みで、追加した条件は走査されない
+        struct Injector {
+            const RowSecurityPolicy& owner;
+            // 修飾子ごとに具体化した条件 (同じエイリアスへの参照はノードを共有する)
+            std::vector<std::unordered_map<Identifier, ast::Expression>> instances;
+            size_t injected = 0;
+
+            explicit Injector(const RowSecurityPolicy& owner) : owner(owner), instances(owner.policies_.size()) {}
+
+            ast::Expression instantiate(const Policy& policy, const Identifier& qualifier) {
+                if (!policy.qualify) return policy.predicate;
+                auto& cache = instances[static_cast<size_t>(&policy - owner.policies_.data())];
+                auto it = cache.find(qualifier);
+                if (it == cache.end()) {
+                    ast::Expression expr = policy.predicate;
+                    ast::walk(expr, detail::ColumnQualifier{ qualifier });
+                    it = cache.emplace(qualifier, std::move(expr)).first;
+                }
+                return it->second;
+            }
+
+            // ref が登録されたテーブルなら具体化した条件を返す
+            bool predicate_for(const ast::TableReference& ref, ast::Expression& out) {
+                auto const* table = boost::get<ast::Table>(&ref);
+                if (!table) return false;
+                const Policy* policy = owner.find(table->name);
+                if (!policy) return false;
+                out = instantiate(*policy, table->alias ? *table->alias : table->name);
+                return true;
+            }
+
+            // テーブルを条件付きの派生テーブルに置き換える
+            static void wrap(ast::TableReference& ref, ast::Expression predicate) {
+                ast::Table table = std::move(boost::get<ast::Table>(ref));
+                ast::Subquery wrapped;
+                if (table.alias) {
+                    wrapped.alias = *table.alias;
+                } else {
+                    std::wstring_view name = table.name;
+                    size_t dot = name.rfind(L'.');
+                    wrapped.alias = Identifier(dot == std::wstring_view::npos ? name : name.substr(dot + 1));
+                }
+                ast::SelectStatement inner;
+                inner.columns.push_back(ast::ResultColumn{ Identifier(L"*"), boost::none });
+                inner.table = std::move(table);
+                inner.where = std::move(predicate);
+                wrapped.select = std::move(inner);
+                ref = std::move(wrapped);
+            }
+
+            void leave(ast::SelectStatement& stmt) {
+                const size_t n = stmt.joins.size();
+                // k 番目のテーブル (0 は FROM、i + 1 は joins[i]) は joins[k..] に RIGHT / FULL JOIN があれば NULL で補われる
+                size_t right_or_full_end = 0; // 最後の RIGHT / FULL JOIN の添字 + 1 (なければ 0)
+                for (size_t i = 0; i < n; ++i) {
+                    if (stmt.joins[i].type == ast::JoinType::RIGHT || stmt.joins[i].type == ast::JoinType::FULL) right_or_full_end = i + 1;
+                }
+
+                ast::Expression predicate;
+                if (predicate_for(stmt.table, predicate)) {
+                    if (right_or_full_end > 0) {
+                        wrap(stmt.table, std::move(predicate));
+                    } else {
+                        ast::and_where(stmt, std::move(predicate));
+                    }
+                    ++injected;
+                }
+
+                for (size_t i = 0; i < n; ++i) {
+                    ast::Join& join = stmt.joins[i];
+                    if (!predicate_for(join.table, predicate)) continue;
+                    ++injected;
+                    bool nullable_by_later = i + 1 < right_or_full_end;
+                    if (nullable_by_later || join.type == ast::JoinType::FULL) {
+                        wrap(join.table, std::move(predicate));
+                    } else if (join.type == ast::JoinType::LEFT) {
+                        if (join.natural || !join.using_columns.empty()) {
+                            wrap(join.table, std::move(predicate));
+                        } else {
+                            ast::add_conjunct(join.on, std::move(predicate));
+                        }
+                    } else {
+                        ast::and_where(stmt, std::move(predicate));
+                    }
+                }
+            }
+        };
+
+        std::vector<Policy> policies_;
+        std::unordered_map<String, uint32_t, ast::detail::IgnoreCaseHash, ast::detail::IgnoreCaseEqual> index_;
+    };
+}
@@ -0,0 +1,329 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/traverse.hpp>
+
+namespace sqlparser::ast {
+
+    namespace detail {
+
+        // 評価のたびに値が変わる関数 (条件を移すと評価回数が変わる)
+        inline bool is_volatile_function(std::wstring_view name) {
+            for (std::wstring_view f : { L"RANDOM", L"RAND", L"NEWID", L"UUID", L"GEN_RANDOM_UUID", L"NEXTVAL", L"SETVAL",
+                                         L"CLOCK_TIMESTAMP", L"TIMEOFDAY" }) {
+                if (iequals_ascii(name, f)) return true;
+            }
+            return false;
+        }
+
+        // カラム参照ではない識別子
+        inline bool is_keyword_constant(std::wstring_view name) {
+            return name == L"*" || iequals_ascii(name, L"NULL") || iequals_ascii(name, L"TRUE") || iequals_ascii(name, L"FALSE");
+        }
+
+        // "q.col" の修飾子 q (修飾子がなければ空)
+        inline std::wstring_view qualifier_of(std::wstring_view name) {
+            size_t dot = name.rfind(L'.');
+            return dot == std::wstring_view::npos ? std::wstring_view() : name.substr(0, dot);
+        }
+
+        inline std::wstring_view column_of(std::wstring_view name) {
+            size_t dot = name.rfind(L'.');
+            return dot == std::wstring_view::npos ? name : name.substr(dot + 1);
+        }
+
+        // AND の各項に分ける
+        inline void split_conjuncts(const Expression& e, std::vector<Expression>& out) {
+            if (auto const* l = boost::get<LogicalOp>(&e); l && l->op == OpType::AND) {
+                out.insert(out.end(), l->operands.begin(), l->operands.end());
+            } else {
+                out.push_back(e);
+            }
+        }
+
+        inline boost::optional<Expression> join_conjuncts(std::vector<Expression>& conjuncts) {
+            if (conjuncts.empty()) return boost::none;
+            if (conjuncts.size() == 1) return std::move(conjuncts.front());
+            return Expression(LogicalOp{ OpType::AND, std::move(conjuncts) });
+        }
+
+        // SELECT 文の FROM / JOIN のテーブル参照 (0 は FROM、i + 1 は joins[i])
+        struct PushdownSources {
+            static constexpr size_t max_sources = 64;
+
+            const SelectStatement& stmt;
+            std::vector<const TableReference*> refs;
+
+            explicit PushdownSources(const SelectStatement& stmt) : stmt(stmt) {
+                refs.reserve(stmt.joins.size() + 1);
+                refs.push_back(&stmt.table);
+                for (auto const& join : stmt.joins) refs.push_back(&join.table);
+            }
+
+            // 修飾子が参照するテーブル参照の位置 (見つからない・曖昧なら -1)
+            int find(std::wstring_view qualifier) const {
+                IgnoreCaseEqual iequal;
+                int found = -1;
+                for (size_t i = 0; i < refs.size(); ++i) {
+                    bool match = false;
+                    if (auto const* t = boost::get<Table>(refs[i])) {
+                        if (t->alias) {
+                            match = iequal(*t->alias, qualifier);
+                        } else {
+                            std::wstring_view name = t->name;
+                            match = iequal(name, qualifier) || iequal(column_of(name), qualifier);
+                        }
+                    } else if (auto const& alias = boost::get<Subquery>(*refs[i]).alias) {
+                        match = iequal(*alias, qualifier);
+                    }
+                    if (!match) continue;
+                    if (found >= 0) return -1;
+                    found = static_cast<int>(i);
+                }
+                return found;
+            }
+
+            // k 番目のテーブル参照が外部結合で NULL に補われうるか
+            // (LEFT JOIN の右側、RIGHT JOIN より前、FULL JOIN の両側)
+            bool null_extended(size_t k) const {
+                if (k >= 1 && (stmt.joins[k - 1].type == JoinType::LEFT || stmt.joins[k - 1].type == JoinType::FULL)) return true;
+                for (size_t j = k; j < stmt.joins.size(); ++j) {
+                    if (stmt.joins[j].type == JoinType::RIGHT || stmt.joins[j].type == JoinType::FULL) return true;
+                }
+                return false;
+            }
+        };
+
+        // 条件が参照するテーブル参照の集合 (ビット k が k 番目)
+        // サブクエリ・ウィンドウ関数・値が毎回変わる関数を含む条件、解決できないカラム参照を含む条件は移せない
+        struct ReferenceCollector {
+            const PushdownSources& sources;
+            uint64_t mask = 0;
+            bool movable = true;
+
+            Visit enter(const SelectStatement&) {
+                movable = false;
+                return Visit::Stop;
+            }
+            Visit enter(const WindowFunction&) {
+                movable = false;
+                return Visit::Stop;
+            }
+            Visit enter(const FunctionCall& call) {
+                movable = !is_volatile_function(call.name);
+                return movable ? Visit::Continue : Visit::Stop;
+            }
+            Visit enter(const Identifier& id) {
+                std::wstring_view name = id;
+                if (is_keyword_constant(name)) return Visit::Continue;
+                std::wstring_view qualifier = qualifier_of(name);
+                int k = qualifier.empty() ? (sources.refs.size() == 1 ? 0 : -1) : sources.find(qualifier);
+                if (k < 0) {
+                    movable = false;
+                    return Visit::Stop;
+                }
+                mask |= uint64_t(1) << k;
+                return Visit::Continue;
+            }
+        };
+
+        // 派生テーブルの出力カラムの式を引く
+        inline bool output_column(const SelectStatement& inner, std::wstring_view column, Expression& out) {
+            IgnoreCaseEqual iequal;
+            const Expression* found = nullptr;
+            bool star = false;
+            for (auto const& col : inner.columns) {
+                bool match = false;
+                if (col.alias) {
+                    match = iequal(*col.alias, column);
+                } else if (auto const* id = boost::get<Identifier>(&col.expr)) {
+                    std::wstring_view name = *id;
+                    if (column_of(name) == L"*") {
+                        star = true;
+                        continue;
+                    }
+                    match = iequal(column_of(name), column);
+                }
+                if (!match) continue;
+                if (found) return false; // 同じ名前の出力カラムが複数ある
+                found = &col.expr;
+            }
+            if (found) {
+                out = *found;
+                return true;
+            }
+            // SELECT * (結合なし) の出力カラムは FROM のテーブル参照のカラム
+            if (star && inner.joins.empty()) {
+                out = Identifier(column);
+                return true;
+            }
+            return false;
+        }
+
+        // "alias.col" を派生テーブルの出力カラムの式に置き換える
+        struct ColumnSubstituter {
+            const SelectStatement& inner;
+            bool ok = true;
+
+            Visit enter_expression(Expression& e) {
+                auto const* id = boost::get<Identifier>(&static_cast<const Expression&>(e));
+                if (!id) return Visit::Continue;
+                std::wstring_view name = *id;
+                if (is_keyword_constant(name)) return Visit::Skip;
+                Expression replacement;
+                if (!output_column(inner, column_of(name), replacement)) {
+                    ok = false;
+                    return Visit::Stop;
+                }
+                e = std::move(replacement);
+                return Visit::Skip;
+            }
+        };
+
+        // 選択リストに集約関数・ウィンドウ関数・値が毎回変わる関数があるか
+        struct SelectListShape {
+            bool aggregate = false;
+            bool window = false;
+            bool volatile_function = false;
+
+            Visit enter(const SelectStatement&) { return Visit::Skip; }
+            void enter(const WindowFunction&) { window = true; }
+            void enter(const FunctionCall& call) {
+                if (is_aggregate_function(call.name)) aggregate = true;
+                if (is_volatile_function(call.name)) volatile_function = true;
+            }
+        };
+
+        // 派生テーブルへ条件を移す (移せなければ false で inner は変更しない)
+        // 集約する SELECT 文には HAVING に、それ以外は WHERE に追加する
+        inline bool push_into_subquery(Subquery& sub, const Expression& cond) {
+            const SelectStatement& inner = sub.select.get();
+            if (!inner.unions.empty() || inner.limit || inner.offset) return false;
+            SelectListShape shape;
+            for (auto const& col : inner.columns) walk(col.expr, shape);
+            if (shape.window || shape.volatile_function) return false;
+
+            Expression rewritten = cond;
+            ColumnSubstituter substituter{ inner };
+            walk(rewritten, substituter);
+            if (!substituter.ok) return false;
+
+            SelectStatement& target = sub.select.get();
+            if (shape.aggregate || !target.groupBy.empty()) {
+                and_having(target, std::move(rewritten));
+            } else {
+                and_where(target, std::move(rewritten));
+            }
+            return true;
+        }
+
+        // SELECT 文 1 つ分の押し下げ (内側の SELECT 文は walk がこの後に処理する)
+        struct PredicatePusher {
+            size_t pushed = 0;
+
+            void enter(SelectStatement& stmt) {
+                const SelectStatement& view = stmt;
+                if (view.joins.size() + 1 > PushdownSources::max_sources) return;
+                push_join_conditions(stmt);
+                push_where(stmt);
+            }
+
+            // ON の条件のうち結合先の派生テーブルだけを参照するものは、その派生テーブルに移す
+            // (INNER / LEFT JOIN の結合先は ON の条件を満たす行だけが結合される側)
+            void push_join_conditions(SelectStatement& stmt) {
+                for (size_t i = 0; i < stmt.joins.size(); ++i) {
+                    const Join& join = static_cast<const SelectStatement&>(stmt).joins[i];
+                    if (!join.on || !boost::get<Subquery>(&join.table)) continue;
+                    if (join.type != JoinType::INNER && join.type != JoinType::LEFT) continue;
+                    PushdownSources sources(stmt);
+                    std::vector<Expression> conjuncts, kept;
+                    split_conjuncts(*join.on, conjuncts);
+                    size_t moved = 0;
+                    for (auto& c : conjuncts) {
+                        ReferenceCollector refs{ sources };
+                        walk(static_cast<const Expression&>(c), refs);
+                        if (refs.movable && refs.mask == (uint64_t(1) << (i + 1)) &&
+                            push_into_subquery(boost::get<Subquery>(stmt.joins[i].table), c)) {
+                            ++moved;
+                        } else {
+                            kept.push_back(std::move(c));
+                        }
+                    }
+                    if (moved == 0) continue;
+                    pushed += moved;
+                    Join& target = stmt.joins[i];
+                    target.on = join_conjuncts(kept);
+                    if (!target.on) {
+                        if (target.type == JoinType::INNER) {
+                            target.type = JoinType::CROSS;
+                        } else {
+                            target.on = Expression(Identifier(L"TRUE"));
+                        }
+                    }
+                }
+            }
+
+            // WHERE の条件を、NULL で補われないテーブル参照だけを参照する限り内側に移す
+            //   1 つの派生テーブルだけを参照する条件 → その派生テーブル
+            //   それ以外で、参照する最後のテーブル参照が INNER / CROSS JOIN の結合先 → その JOIN の ON
+            void push_where(SelectStatement& stmt) {
+                if (!stmt.where) return;
+                PushdownSources sources(stmt);
+                std::vector<Expression> conjuncts, kept;
+                split_conjuncts(*static_cast<const SelectStatement&>(stmt).where, conjuncts);
+                size_t moved = 0;
+                for (auto& c : conjuncts) {
+                    if (push_where_conjunct(stmt, sources, c)) {
+                        ++moved;
+                    } else {
+                        kept.push_back(std::move(c));
+                    }
+                }
+                if (moved == 0) return;
+                pushed += moved;
+                stmt.where = join_conjuncts(kept);
+            }
+
+            bool push_where_conjunct(SelectStatement& stmt, const PushdownSources& sources, const Expression& c) {
+                ReferenceCollector refs{ sources };
+                walk(c, refs);
+                if (!refs.movable || refs.mask == 0) return false;
+                size_t last = 0;
+                for (size_t k = 0; k < sources.refs.size(); ++k) {
+                    if (!(refs.mask & (uint64_t(1) << k))) continue;
+                    if (sources.null_extended(k)) return false;
+                    last = k;
+                }
+                if (refs.mask == (uint64_t(1) << last)) {
+                    TableReference& ref = last == 0 ? stmt.table : stmt.joins[last - 1].table;
+                    if (auto* sub = boost::get<Subquery>(&ref); sub && push_into_subquery(*sub, c)) return true;
+                }
+                if (last == 0) return false;
+                const Join& join = static_cast<const SelectStatement&>(stmt).joins[last - 1];
+                if (join.type != JoinType::INNER && join.type != JoinType::CROSS) return false;
+                return and_join_on(stmt, last - 1, c);
+            }
+        };
+    }
+
+    // 述語の押し下げ
+    // WHERE を AND の項に分け、各項が参照するテーブル参照 (エイリアス) を解決して、意味が変わらない範囲で内側に移す。
+    //   - 1 つの派生テーブルだけを参照する項は、その派生テーブルの WHERE (集約する場合は HAVING) に移す。
+    //     カラム参照は派生テーブルの出力カラムの式に置き換える。
+    //   - 複数のテーブル参照にまたがる項などは、参照する最後のテーブル参照が INNER / CROSS JOIN の結合先なら、その ON に移す。
+    //   - INNER / LEFT JOIN の ON の項で、結合先の派生テーブルだけを参照するものは、その派生テーブルに移す。
+    // 外部結合で NULL に補われる側 (LEFT JOIN の右側、RIGHT JOIN の左側、FULL JOIN の両側) を参照する WHERE の項は移さない。
+    // 移さない派生テーブル: UNION・LIMIT / OFFSET・ウィンドウ関数・RANDOM() などを含むもの、出力カラムを解決できないもの。
+    // 移さない項: サブクエリ・ウィンドウ関数・RANDOM() などを含むもの、どのテーブル参照か解決できないカラム参照を含むもの
+    // (修飾子のないカラム参照は、テーブル参照が 1 つの場合だけ解決する)。
+    // 外側の SELECT 文から順に処理するため、移した条件はさらに内側の派生テーブルまで押し下げられる。
+    // 移した項の数を返す。
+    inline size_t push_down_predicates(SelectStatement& stmt) {
+        detail::PredicatePusher pusher;
+        walk(stmt, pusher);
+        return pusher.pushed;
+    }
+}
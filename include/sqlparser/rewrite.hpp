@@ -0,0 +1,367 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <boost/mpl/size.hpp>
+#include <boost/optional.hpp>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/traverse.hpp>
+#include <sqlparser/types.hpp>
+
+namespace sqlparser::rewrite {
+
+    // パターンで指定するノードの種類 (Expression の型と同じ順)
+    enum class NodeKind : uint8_t {
+        Int, Float, Identifier, String, BinaryOp, LogicalOp, UnaryOp, Cast, FunctionCall, Case, Between, In, WindowFunction, Exists,
+        Any // どのノードにもマッチする
+    };
+
+    inline constexpr size_t node_kind_count = static_cast<size_t>(NodeKind::Any);
+    static_assert(boost::mpl::size<ast::Expression::types>::value == node_kind_count, "NodeKind must follow the order of ast::Expression");
+
+    inline NodeKind kind_of(const ast::Expression& e) { return static_cast<NodeKind>(e.which()); }
+
+    // 式のパターン
+    // 指定しなかった項目は問わない。children を指定した場合は子の数も一致する必要がある。
+    // 子の並び: BinaryOp は left, right / LogicalOp は operands / UnaryOp と Cast は expr / FunctionCall は args /
+    //           Between は expr, lower, upper / In は expr に続けて values (リテラルのリストには子のパターンはマッチしない)
+    struct Pattern {
+        NodeKind kind = NodeKind::Any;
+        boost::optional<ast::OpType> op; // BinaryOp / LogicalOp / UnaryOp の演算子
+        String name;                     // FunctionCall の関数名・Identifier の名前 (大文字小文字を区別しない)、数値リテラルの綴り
+        boost::optional<TypeId> type;    // Cast の型
+        std::vector<Pattern> children;
+        bool match_children = false;
+        int8_t slot = -1; // マッチしたノードを記録する Match の位置
+
+        // マッチしたノードを Match[index] に記録する
+        Pattern as(int index) const {
+            Pattern p = *this;
+            p.slot = static_cast<int8_t>(index);
+            return p;
+        }
+    };
+
+    inline Pattern any() { return Pattern{}; }
+
+    inline Pattern node(NodeKind kind) {
+        Pattern p;
+        p.kind = kind;
+        return p;
+    }
+
+    inline Pattern binary(ast::OpType op, Pattern left, Pattern right) {
+        Pattern p = node(NodeKind::BinaryOp);
+        p.op = op;
+        p.children = { std::move(left), std::move(right) };
+        p.match_children = true;
+        return p;
+    }
+
+    // AND / OR (オペランドは問わない)
+    inline Pattern logical(ast::OpType op) {
+        Pattern p = node(NodeKind::LogicalOp);
+        p.op = op;
+        return p;
+    }
+
+    inline Pattern unary(ast::OpType op, Pattern operand) {
+        Pattern p = node(NodeKind::UnaryOp);
+        p.op = op;
+        p.children = { std::move(operand) };
+        p.match_children = true;
+        return p;
+    }
+
+    inline Pattern cast(TypeId type, Pattern expr = any()) {
+        Pattern p = node(NodeKind::Cast);
+        p.type = type;
+        p.children = { std::move(expr) };
+        p.match_children = true;
+        return p;
+    }
+
+    // 関数呼び出し (引数は問わない)
+    inline Pattern function(std::wstring_view name) {
+        Pattern p = node(NodeKind::FunctionCall);
+        p.name = String(name);
+        return p;
+    }
+
+    inline Pattern function(std::wstring_view name, std::vector<Pattern> args) {
+        Pattern p = function(name);
+        p.children = std::move(args);
+        p.match_children = true;
+        return p;
+    }
+
+    inline Pattern identifier(std::wstring_view name) {
+        Pattern p = node(NodeKind::Identifier);
+        p.name = String(name);
+        return p;
+    }
+
+    inline Pattern int_literal(std::wstring_view text) {
+        Pattern p = node(NodeKind::Int);
+        p.name = String(text);
+        return p;
+    }
+
+    // マッチしたノード (Pattern::as で指定した位置)
+    // 書き換え対象のノードの中を指すため、ノードを書き換える前にコピーするかムーブで取り出しておくこと
+    // (node は書き換えてよいので、const_cast してムーブしてよい)
+    struct Match {
+        static constexpr size_t max_slots = 8;
+        std::array<const ast::Expression*, max_slots> nodes{};
+
+        const ast::Expression& operator[](size_t index) const { return *nodes[index]; }
+    };
+
+    namespace detail {
+
+        inline bool match_children(const std::vector<Pattern>& patterns, const std::vector<ast::Expression>& children, Match& m);
+
+        inline bool match(const Pattern& p, const ast::Expression& e, Match& m) {
+            NodeKind kind = kind_of(e);
+            if (p.kind != NodeKind::Any && p.kind != kind) return false;
+            ast::detail::IgnoreCaseEqual iequal;
+            bool ok = true;
+            switch (p.kind) {
+            case NodeKind::Int:
+                ok = p.name.empty() || boost::get<ast::IntLiteral>(e).text.view() == std::wstring_view(p.name);
+                break;
+            case NodeKind::Float:
+                ok = p.name.empty() || boost::get<ast::FloatLiteral>(e).text.view() == std::wstring_view(p.name);
+                break;
+            case NodeKind::Identifier:
+                ok = p.name.empty() || iequal(boost::get<Identifier>(e), p.name);
+                break;
+            case NodeKind::BinaryOp: {
+                auto const& n = boost::get<ast::BinaryOp>(e);
+                ok = (!p.op || n.op == *p.op) &&
+                     (!p.match_children || (p.children.size() == 2 && match(p.children[0], n.left, m) && match(p.children[1], n.right, m)));
+                break;
+            }
+            case NodeKind::LogicalOp: {
+                auto const& n = boost::get<ast::LogicalOp>(e);
+                ok = (!p.op || n.op == *p.op) && (!p.match_children || match_children(p.children, n.operands, m));
+                break;
+            }
+            case NodeKind::UnaryOp: {
+                auto const& n = boost::get<ast::UnaryOp>(e);
+                ok = (!p.op || n.op == *p.op) && (!p.match_children || (p.children.size() == 1 && match(p.children[0], n.expr, m)));
+                break;
+            }
+            case NodeKind::Cast: {
+                auto const& n = boost::get<ast::Cast>(e);
+                ok = (!p.type || n.type.id == *p.type) && (!p.match_children || (p.children.size() == 1 && match(p.children[0], n.expr, m)));
+                break;
+            }
+            case NodeKind::FunctionCall: {
+                auto const& n = boost::get<ast::FunctionCall>(e);
+                ok = (p.name.empty() || iequal(n.name, p.name)) && (!p.match_children || match_children(p.children, n.args, m));
+                break;
+            }
+            case NodeKind::Between: {
+                auto const& n = boost::get<ast::Between>(e);
+                ok = !p.match_children || (p.children.size() == 3 && match(p.children[0], n.expr, m) &&
+                                           match(p.children[1], n.lower, m) && match(p.children[2], n.upper, m));
+                break;
+            }
+            case NodeKind::In: {
+                auto const& n = boost::get<ast::In>(e);
+                if (p.match_children) {
+                    ok = !p.children.empty() && p.children.size() == n.values.size() + 1 && n.literals.empty() &&
+                         match(p.children[0], n.expr, m);
+                    for (size_t i = 1; ok && i < p.children.size(); ++i) ok = match(p.children[i], n.values[i - 1], m);
+                }
+                break;
+            }
+            default:
+                // 子のパターンを持たない種類 (Any の子の指定は無視する)
+                ok = !p.match_children || p.kind == NodeKind::Any;
+                break;
+            }
+            if (!ok) return false;
+            if (p.slot >= 0) m.nodes[static_cast<size_t>(p.slot)] = &e;
+            return true;
+        }
+
+        inline bool match_children(const std::vector<Pattern>& patterns, const std::vector<ast::Expression>& children, Match& m) {
+            if (patterns.size() != children.size()) return false;
+            for (size_t i = 0; i < patterns.size(); ++i) {
+                if (!match(patterns[i], children[i], m)) return false;
+            }
+            return true;
+        }
+    }
+
+    // 書き換え規則の集合
+    // add() で登録した規則は、根のパターンの種類・演算子・関数名で振り分けた表に入る。
+    // apply() は AST を 1 回だけ帰りがけ順 (子が先) に走査し、各ノードで表から引いた候補の規則だけを試す。
+    // 規則が適用されたノードは、置き換えで新しく作られた子に適用してから同じノードで再び規則を試す (そのノードで何も変わらなくなるまで)。
+    // 置き換え後の式に残った元の子 (ムーブで移したもの) はたどり直さないため、書き換えの回数が多くても走査は線形になる。
+    // 候補は種類と演算子・関数名が一致する規則に限られるため、1 ノードあたりの費用は規則の総数にほぼよらない。
+    // 候補の順序: 演算子・関数名を指定した規則 → 種類だけを指定した規則 → NodeKind::Any の規則 (それぞれ登録順)。
+    class RuleSet {
+    public:
+        // node を書き換えたら true を返す (マッチしても書き換えなければ false を返し、次の候補に進む)
+        using Action = std::function<bool(ast::Expression& node, const Match& match)>;
+
+        // 1 ノードで規則を適用し直す回数の上限 (互いに打ち消し合う規則による無限ループを防ぐ)
+        static constexpr size_t max_rounds = 32;
+
+        void add(Pattern pattern, Action action) {
+            uint32_t index = static_cast<uint32_t>(rules_.size());
+            std::vector<uint32_t>& bucket = bucket_for(pattern);
+            bucket.push_back(index);
+            rules_.push_back({ std::move(pattern), std::move(action) });
+        }
+
+        size_t size() const { return rules_.size(); }
+        bool empty() const { return rules_.empty(); }
+
+        // 書き換えた回数を返す
+        size_t apply(ast::SelectStatement& stmt) const {
+            if (rules_.empty()) return 0;
+            Rewriter rewriter{ *this };
+            ast::walk(stmt, rewriter);
+            return rewriter.rewrites;
+        }
+
+        size_t apply(ast::Expression& expr) const {
+            if (rules_.empty()) return 0;
+            Rewriter rewriter{ *this };
+            ast::walk(expr, rewriter);
+            return rewriter.rewrites;
+        }
+
+    private:
+        struct Rule {
+            Pattern pattern;
+            Action action;
+        };
+
+        static constexpr size_t op_count = static_cast<size_t>(ast::OpType::BIT_RSHIFT) + 1;
+
+        // 演算子で振り分ける種類の表の位置 (振り分けない種類は -1)
+        static int op_table(NodeKind kind) {
+            switch (kind) {
+            case NodeKind::BinaryOp: return 0;
+            case NodeKind::LogicalOp: return 1;
+            case NodeKind::UnaryOp: return 2;
+            default: return -1;
+            }
+        }
+
+        std::vector<uint32_t>& bucket_for(const Pattern& p) {
+            if (p.kind == NodeKind::Any) return any_;
+            int table = op_table(p.kind);
+            if (table >= 0 && p.op) return by_op_[static_cast<size_t>(table)][static_cast<size_t>(*p.op)];
+            if (p.kind == NodeKind::FunctionCall && !p.name.empty()) return by_function_[p.name];
+            return by_kind_[static_cast<size_t>(p.kind)];
+        }
+
+        // e の候補の規則を順に試し、最初に書き換えた規則で止める
+        bool apply_at(ast::Expression& e) const {
+            const ast::Expression& view = e;
+            NodeKind kind = kind_of(view);
+            const std::vector<uint32_t>* specific = nullptr;
+            if (int table = op_table(kind); table >= 0) {
+                ast::OpType op = kind == NodeKind::BinaryOp  ? boost::get<ast::BinaryOp>(view).op
+                                 : kind == NodeKind::LogicalOp ? boost::get<ast::LogicalOp>(view).op
+                                                               : boost::get<ast::UnaryOp>(view).op;
+                specific = &by_op_[static_cast<size_t>(table)][static_cast<size_t>(op)];
+            } else if (kind == NodeKind::FunctionCall && !by_function_.empty()) {
+                auto it = by_function_.find(std::wstring_view(boost::get<ast::FunctionCall>(view).name));
+                if (it != by_function_.end()) specific = &it->second;
+            }
+            for (const std::vector<uint32_t>* bucket : { specific, &by_kind_[static_cast<size_t>(kind)], &any_ }) {
+                if (!bucket) continue;
+                for (uint32_t index : *bucket) {
+                    const Rule& rule = rules_[index];
+                    Match m;
+                    if (detail::match(rule.pattern, view, m) && rule.action(e, m)) return true;
+                }
+            }
+            return false;
+        }
+
+        // 帰りがけ順に各式の置き場所で規則を適用する
+        // 規則を試し終えた複合ノードには apply ごとの印を付け、置き換え後は印のない (新しく作られた) ノードだけをたどる
+        struct Rewriter {
+            const RuleSet& rules;
+            uint32_t mark = ast::new_node_mark();
+            size_t rewrites = 0;
+            size_t rewalking = 0; // 置き換え後の走査の深さ (最初の走査では印を見ない)
+
+            // e が処理済みのノードか (リテラルと識別子は印を持たず、常に未処理として扱う)
+            bool processed(ast::Expression& e) const {
+                return ast::detail::visit_expression(e, [&](auto& node) {
+                    if constexpr (ast::is_shared_node<std::remove_const_t<std::remove_reference_t<decltype(node)>>>) {
+                        return ast::node_mark(node) == mark;
+                    } else {
+                        return false;
+                    }
+                });
+            }
+
+            void set_processed(ast::Expression& e) const {
+                ast::detail::visit_expression(e, [&](auto& node) {
+                    if constexpr (ast::is_shared_node<std::remove_const_t<std::remove_reference_t<decltype(node)>>>) {
+                        ast::set_node_mark(node, mark);
+                    }
+                });
+            }
+
+            ast::Visit enter_expression(ast::Expression& e) {
+                return rewalking > 0 && processed(e) ? ast::Visit::Skip : ast::Visit::Continue;
+            }
+
+            void leave_expression(ast::Expression& e) {
+                if (rewalking > 0 && processed(e)) return;
+                for (size_t round = 0; round < max_rounds && rules.apply_at(e); ++round) {
+                    ++rewrites;
+                    // 処理済みのノードに置き換わった場合 (replace_with など) は、そのノードで規則を試し終えている
+                    if (processed(e)) return;
+                    // 置き換えで新しく作られた子にだけ規則を適用する (移されてきた元の子は印で飛ばす)
+                    ++rewalking;
+                    ast::detail::visit_expression(e, [&](auto& node) { ast::detail::walk_children(node, *this); });
+                    --rewalking;
+                }
+                set_processed(e);
+            }
+        };
+
+        std::vector<Rule> rules_;
+        std::array<std::array<std::vector<uint32_t>, op_count>, 3> by_op_;
+        std::unordered_map<String, std::vector<uint32_t>, ast::detail::IgnoreCaseHash, ast::detail::IgnoreCaseEqual> by_function_;
+        std::array<std::vector<uint32_t>, node_kind_count> by_kind_;
+        std::vector<uint32_t> any_;
+    };
+
+    // マッチした位置 index のノードで置き換える
+    // マッチしたノードは node の中にあるため、コピーせずにムーブで取り出す (処理済みの印も引き継ぐ)
+    inline RuleSet::Action replace_with(int index) {
+        return [index](ast::Expression& node, const Match& m) {
+            ast::Expression replacement = std::move(const_cast<ast::Expression&>(m[static_cast<size_t>(index)]));
+            node = std::move(replacement);
+            return true;
+        };
+    }
+
+    // 関数名を name に変える (引数はそのまま)
+    inline RuleSet::Action rename_function(std::wstring_view name) {
+        return [name = Identifier(name)](ast::Expression& node, const Match&) {
+            auto& call = boost::get<ast::FunctionCall>(node);
+            if (std::wstring_view(call.name) == std::wstring_view(name)) return false;
+            call.name = name;
+            return true;
+        };
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <boost/variant/recursive_wrapper.hpp>
+
+namespace sqlparser::ast {
+
+    // AST の再帰ノード (Expression の recursive_wrapper<T> と SELECT 文のサブクエリ) を共有できるようにするか
+    // ast.hpp で対象のノード型ごとに true に特殊化する
+    template <typename T>
+    inline constexpr bool is_shared_node = false;
+
+    namespace detail {
+        // frozen_copy() の実行中か (このスレッドで行うコピーを凍結する)
+        inline bool& freezing() {
+            thread_local bool on = false;
+            return on;
+        }
+    }
+
+    // value を凍結したコピーを返す
+    // 凍結されたノードはコピーしても複製されず、参照カウントで共有される (既に凍結されている部分木は複製もしない)。
+    // hash-consing (ParseOptions::share_subexpressions) と PersistentSelect が使う。
+    template <typename T>
+    T frozen_copy(const T& value) {
+        bool& on = detail::freezing();
+        bool outer = on;
+        on = true;
+        struct Restore {
+            bool& on;
+            bool value;
+            ~Restore() { on = value; }
+        } restore{ on, outer };
+        return T(value);
+    }
+}
+
+namespace boost {
+
+    // AST ノード用の recursive_wrapper
+    // 既定の recursive_wrapper と同じく、コピーはノードを new して深くコピーする。
+    // frozen_copy() で凍結されたノードだけは参照カウント付きのブロックを共有し、コピーは参照カウントの増加だけになる。
+    // 凍結されたノードへの書き込み用のアクセス (非 const の get()) は、他と共有されていれば複製してから、
+    // 共有されていなければ凍結を解いてから参照を返す。取り出した参照の先は常に凍結されていないノードなので、
+    // その後に持ち主をコピーしても深くコピーされ、参照を通した変更がコピーに見えることはない。
+    // 凍結されたノードの子は全て凍結されている (凍結は子から順に行い、凍結を解くのは書き込む親だけ)。
+    // ムーブはブロックを移し、移動元と既定の構築には型ごとに 1 つの凍結された空のノードを指させる
+    // (例外を投げないため、boost::variant が異なる型の代入でコピーに退避しない)。
+    template <typename T>
+        requires sqlparser::ast::is_shared_node<T>
+    class recursive_wrapper<T> {
+    public:
+        typedef T type;
+
+        recursive_wrapper() noexcept : p_(empty()) { acquire(); }
+        recursive_wrapper(const T& operand) : p_(new Block(operand)) { p_->frozen = sqlparser::ast::detail::freezing(); }
+        recursive_wrapper(T&& operand) : p_(new Block(std::move(operand))) {}
+
+        recursive_wrapper(const recursive_wrapper& operand) {
+            if (operand.p_->frozen) {
+                p_ = operand.p_;
+                acquire();
+            } else {
+                p_ = new Block(operand.p_->value);
+                p_->frozen = sqlparser::ast::detail::freezing();
+            }
+        }
+
+        recursive_wrapper(recursive_wrapper&& operand) noexcept : p_(operand.p_) {
+            operand.p_ = empty();
+            operand.acquire();
+        }
+
+        ~recursive_wrapper() { release(p_); }
+
+        recursive_wrapper& operator=(const recursive_wrapper& rhs) {
+            if (this != &rhs) {
+                recursive_wrapper copy(rhs);
+                swap(copy);
+            }
+            return *this;
+        }
+
+        recursive_wrapper& operator=(recursive_wrapper&& rhs) noexcept {
+            swap(rhs);
+            return *this;
+        }
+
+        recursive_wrapper& operator=(const T& rhs) {
+            if (p_->frozen) {
+                recursive_wrapper copy(rhs);
+                swap(copy);
+            } else {
+                p_->value = rhs;
+            }
+            return *this;
+        }
+
+        recursive_wrapper& operator=(T&& rhs) {
+            if (p_->frozen) {
+                recursive_wrapper moved(std::move(rhs));
+                swap(moved);
+            } else {
+                p_->value = std::move(rhs);
+            }
+            return *this;
+        }
+
+        void swap(recursive_wrapper& operand) noexcept { std::swap(p_, operand.p_); }
+
+        // 書き込み用のアクセス: 凍結されていれば、共有中なら複製し、そうでなければ凍結を解いてから返す
+        T& get() { return *get_pointer(); }
+        const T& get() const { return p_->value; }
+
+        T* get_pointer() {
+            if (p_->frozen) {
+                if (unique()) {
+                    p_->frozen = false;
+                } else {
+                    Block* old = p_;
+                    p_ = new Block(old->value);
+                    release(old);
+                }
+            }
+            return &p_->value;
+        }
+        const T* get_pointer() const { return &p_->value; }
+
+        // value を持つノードに付けた印 (value は recursive_wrapper が持つノードであること)
+        static uint32_t mark_of(const T& value) noexcept { return block_of(value)->mark; }
+        // 書き込み用のアクセスで取り出した value にだけ付けること (凍結されたノードは共有されうる)
+        static void set_mark(T& value, uint32_t mark) noexcept { block_of(value)->mark = mark & mark_mask; }
+
+        // 凍結されたノードか (コピーで共有される)
+        bool frozen() const { return p_->frozen; }
+        // 他の recursive_wrapper とノードを共有していないか
+        bool unique() const { return p_->refs.load(std::memory_order_acquire) == 1; }
+        uint32_t use_count() const { return p_->refs.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr uint32_t mark_mask = 0x7fffffff;
+
+        // 凍結されていないブロックは常に持ち主が 1 つなので、frozen と mark を書き換えるのは持ち主だけ
+        // mark はコピーや複製では引き継がず、ムーブでは引き継ぐ
+        struct Block {
+            std::atomic<uint32_t> refs{ 1 };
+            uint32_t frozen : 1 = 0;
+            uint32_t mark : 31 = 0;
+            T value;
+
+            Block() = default;
+            explicit Block(const T& v) : value(v) {}
+            explicit Block(T&& v) : value(std::move(v)) {}
+        };
+
+        // 既定値の共有ノード (参照を 1 つ持ち続けるため解放されない)
+        static Block* empty() noexcept {
+            static Block* const block = [] {
+                Block* b = new Block();
+                b->frozen = true;
+                return b;
+            }();
+            return block;
+        }
+
+        // value を持つブロック (value の位置は型ごとに一定なので、既定値のノードから求める)
+        static Block* block_of(const T& value) noexcept {
+            static const std::ptrdiff_t offset = reinterpret_cast<const char*>(&empty()->value) - reinterpret_cast<const char*>(empty());
+            return reinterpret_cast<Block*>(const_cast<char*>(reinterpret_cast<const char*>(&value)) - offset);
+        }
+
+        void acquire() noexcept { p_->refs.fetch_add(1, std::memory_order_relaxed); }
+
+        static void release(Block* b) noexcept {
+            if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete b;
+        }
+
+        Block* p_;
+    };
+}
+
+namespace sqlparser::ast {
+
+    // 走査が処理済みのノードに付ける印 (rewrite::RuleSet::apply が使う)
+    // value は Expression などが recursive_wrapper で持つノードであること。印は 31 ビットで、0 は印なし。
+    template <typename T>
+        requires is_shared_node<T>
+    uint32_t node_mark(const T& value) {
+        return boost::recursive_wrapper<T>::mark_of(value);
+    }
+
+    template <typename T>
+        requires is_shared_node<T>
+    void set_node_mark(T& value, uint32_t mark) {
+        boost::recursive_wrapper<T>::set_mark(value, mark);
+    }
+
+    // 新しい印を返す (プロセス内で 2^31 - 1 回ごとに一巡する)
+    inline uint32_t new_node_mark() {
+        static std::atomic<uint32_t> last{ 0 };
+        uint32_t mark;
+        do {
+            mark = (last.fetch_add(1, std::memory_order_relaxed) + 1) & 0x7fffffff;
+        } while (mark == 0);
+        return mark;
+    }
+}
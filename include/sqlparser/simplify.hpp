@@ -0,0 +1,421 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/compare.hpp>
+#include <sqlparser/traverse.hpp>
+
+namespace sqlparser::ast {
+
+    namespace detail {
+
+        // 定数としての真偽値 (TRUE / FALSE の識別子)
+        enum class Truth : uint8_t { Unknown, True, False };
+
+        inline Truth truth_of(const Expression& e) {
+            auto const* id = boost::get<Identifier>(&e);
+            if (!id) return Truth::Unknown;
+            std::wstring_view name = *id;
+            if (iequals_ascii(name, L"TRUE")) return Truth::True;
+            if (iequals_ascii(name, L"FALSE")) return Truth::False;
+            return Truth::Unknown;
+        }
+
+        inline Expression boolean_literal(bool value) { return Expression(Identifier(value ? L"TRUE" : L"FALSE")); }
+
+        // NULL 以外の定数 (数値・文字列リテラル、TRUE / FALSE)
+        inline bool is_non_null_constant(const Expression& e) {
+            return boost::get<IntLiteral>(&e) || boost::get<FloatLiteral>(&e) || boost::get<StringLiteral>(&e) ||
+                   truth_of(e) != Truth::Unknown;
+        }
+
+        inline bool is_null_literal(const Expression& e) {
+            auto const* id = boost::get<Identifier>(&e);
+            return id && iequals_ascii(*id, L"NULL");
+        }
+
+        // 比較演算子の否定 (NOT (a < b) は a >= b。どちらも NULL なら NULL で三値論理でも同じ)
+        inline bool negate_comparison(OpType op, OpType& out) {
+            switch (op) {
+            case OpType::EQ: out = OpType::NE; return true;
+            case OpType::NE: out = OpType::EQ; return true;
+            case OpType::LT: out = OpType::GE; return true;
+            case OpType::GE: out = OpType::LT; return true;
+            case OpType::GT: out = OpType::LE; return true;
+            case OpType::LE: out = OpType::GT; return true;
+            default: return false;
+            }
+        }
+
+        // 数値リテラル (IntLiteral / FloatLiteral) の符号を綴りの上で反転する (int64_t に収まらない値もそのまま扱う)
+        template <typename Literal>
+        Literal negate_literal(const Literal& literal) {
+            std::wstring_view text = literal.text.view();
+            if (!text.empty() && text[0] == L'-') return Literal(text.substr(1));
+            if (!text.empty() && text[0] == L'+') text.remove_prefix(1);
+            wchar_t buf[64];
+            if (text.size() + 1 > std::size(buf)) {
+                String s(1, L'-');
+                s.append(text);
+                return Literal(std::wstring_view(s));
+            }
+            buf[0] = L'-';
+            std::wstring_view::traits_type::copy(buf + 1, text.data(), text.size());
+            return Literal(std::wstring_view(buf, text.size() + 1));
+        }
+
+        // 整数リテラル同士の演算 (オーバーフローする場合と除算は畳み込まない)
+        // 整数の除算は DB によって結果の型が異なる (PostgreSQL は整数、MySQL は小数) ため対象外
+        inline bool fold_integer(OpType op, int64_t a, int64_t b, int64_t& out) {
+            constexpr int64_t max = std::numeric_limits<int64_t>::max();
+            constexpr int64_t min = std::numeric_limits<int64_t>::min();
+            switch (op) {
+            case OpType::ADD:
+                if ((b > 0 && a > max - b) || (b < 0 && a < min - b)) return false;
+                out = a + b;
+                return true;
+            case OpType::SUB:
+                if ((b < 0 && a > max + b) || (b > 0 && a < min + b)) return false;
+                out = a - b;
+                return true;
+            case OpType::MUL:
+                if (a > 0 ? (b > 0 ? a > max / b : b < min / a) : (b > 0 ? a < min / b : (a != 0 && b < max / a))) return false;
+                out = a * b;
+                return true;
+            case OpType::MOD:
+                if (b == 0 || (b == -1 && a == min)) return false;
+                out = a % b;
+                return true;
+            case OpType::BIT_AND: out = a & b; return true;
+            case OpType::BIT_OR: out = a | b; return true;
+            default: return false;
+            }
+        }
+
+        // 数値リテラルの綴りを 10 進のまま表したもの (double を経由すると 0.30000000000000001 と 0.3 が等しくなるため)
+        // 値は (-1)^negative × 0.d1d2...dn × 10^exponent。d1...dn は先頭と末尾の 0 を除いた有効数字で、
+        // 整数部と小数部の 2 つのビューにまたがる (ヒープ確保なし)。n == 0 なら 0
+        struct DecimalText {
+            bool negative = false;
+            std::wstring_view int_digits;
+            std::wstring_view frac_digits;
+            int64_t exponent = 0;
+
+            size_t size() const { return int_digits.size() + frac_digits.size(); }
+            wchar_t digit(size_t i) const { return i < int_digits.size() ? int_digits[i] : frac_digits[i - int_digits.size()]; }
+
+            // [+-]digits[.digits][e[+-]digits] を読む (それ以外の綴りと、極端な指数は false)
+            static bool parse(std::wstring_view text, DecimalText& out) {
+                auto digits = [&](size_t& i) {
+                    size_t from = i;
+                    while (i < text.size() && text[i] >= L'0' && text[i] <= L'9') ++i;
+                    return text.substr(from, i - from);
+                };
+                size_t i = 0;
+                out = DecimalText{};
+                if (i < text.size() && (text[i] == L'+' || text[i] == L'-')) out.negative = text[i++] == L'-';
+                std::wstring_view int_part = digits(i);
+                std::wstring_view frac_part;
+                if (i < text.size() && text[i] == L'.') frac_part = digits(++i);
+                if (int_part.empty() && frac_part.empty()) return false;
+                int64_t exp = 0;
+                if (i < text.size() && (text[i] == L'e' || text[i] == L'E')) {
+                    bool exp_negative = false;
+                    if (++i < text.size() && (text[i] == L'+' || text[i] == L'-')) exp_negative = text[i++] == L'-';
+                    std::wstring_view exp_digits = digits(i);
+                    if (exp_digits.empty() || exp_digits.size() > 9) return false;
+                    for (wchar_t c : exp_digits) exp = exp * 10 + (c - L'0');
+                    if (exp_negative) exp = -exp;
+                }
+                if (i != text.size()) return false;
+
+                while (!int_part.empty() && int_part.front() == L'0') int_part.remove_prefix(1);
+                out.exponent = static_cast<int64_t>(int_part.size()) + exp;
+                if (int_part.empty()) {
+                    while (!frac_part.empty() && frac_part.front() == L'0') {
+                        frac_part.remove_prefix(1);
+                        --out.exponent;
+                    }
+                }
+                while (!frac_part.empty() && frac_part.back() == L'0') frac_part.remove_suffix(1);
+                if (frac_part.empty()) {
+                    while (!int_part.empty() && int_part.back() == L'0') int_part.remove_suffix(1);
+                }
+                out.int_digits = int_part;
+                out.frac_digits = frac_part;
+                if (out.size() == 0) out.negative = false; // -0 は 0
+                return true;
+            }
+
+            // 大小比較 (a < b なら負、等しければ 0、a > b なら正)
+            static int compare(const DecimalText& a, const DecimalText& b) {
+                if (a.negative != b.negative) return a.negative ? -1 : 1;
+                int sign = a.negative ? -1 : 1;
+                if (a.size() == 0 || b.size() == 0) return sign * ((a.size() != 0) - (b.size() != 0));
+                if (a.exponent != b.exponent) return sign * (a.exponent < b.exponent ? -1 : 1);
+                size_t n = std::min(a.size(), b.size());
+                for (size_t i = 0; i < n; ++i) {
+                    if (a.digit(i) != b.digit(i)) return sign * (a.digit(i) < b.digit(i) ? -1 : 1);
+                }
+                return sign * ((a.size() > n) - (b.size() > n));
+            }
+        };
+
+        inline const SmallString* numeric_text(const Expression& e) {
+            if (auto const* i = boost::get<IntLiteral>(&e)) return &i->text;
+            if (auto const* f = boost::get<FloatLiteral>(&e)) return &f->text;
+            return nullptr;
+        }
+
+        // 数値リテラル同士の比較 (文字列は照合順序に依存するため対象外)
+        // 綴りを 10 進のまま比べるため、int64_t や double に収まらない桁数でも正確に比較する
+        inline bool fold_comparison(OpType op, const Expression& left, const Expression& right, bool& out) {
+            const SmallString* l = numeric_text(left);
+            const SmallString* r = numeric_text(right);
+            DecimalText a, b;
+            if (!l || !r || !DecimalText::parse(l->view(), a) || !DecimalText::parse(r->view(), b)) return false;
+            int order = DecimalText::compare(a, b);
+            switch (op) {
+            case OpType::EQ: out = order == 0; return true;
+            case OpType::NE: out = order != 0; return true;
+            case OpType::LT: out = order < 0; return true;
+            case OpType::LE: out = order <= 0; return true;
+            case OpType::GT: out = order > 0; return true;
+            case OpType::GE: out = order >= 0; return true;
+            default: return false;
+            }
+        }
+
+        // GROUP BY があるか、SELECT リストが集約する (HAVING の有無で結果の行数が変わらない) SELECT 文か
+        inline bool is_grouped(const SelectStatement& stmt) {
+            if (!stmt.groupBy.empty()) return true;
+            AggregateFinder finder; // 集約関数を含むか (サブクエリとウィンドウ関数の中は見ない)
+            for (auto const& col : stmt.columns) {
+                if (!walk(col.expr, finder)) return true;
+            }
+            return false;
+        }
+
+        // 帰りがけ順に各式を簡約する (子は簡約済み)
+        // 判定は const の参照で行い、書き換えるときだけ書き込み用に取り出す
+        struct Simplifier {
+            size_t rewrites = 0;
+
+            void replace(Expression& e, Expression replacement) {
+                e = std::move(replacement);
+                ++rewrites;
+            }
+
+            void leave_expression(Expression& e) {
+                const Expression& view = e;
+                if (auto const* b = boost::get<BinaryOp>(&view)) {
+                    simplify_binary(e, *b);
+                } else if (auto const* l = boost::get<LogicalOp>(&view)) {
+                    simplify_logical(e, *l);
+                } else if (auto const* u = boost::get<UnaryOp>(&view)) {
+                    simplify_unary(e, *u);
+                } else if (auto const* c = boost::get<Case>(&view)) {
+                    simplify_case(e, *c);
+                } else if (auto const* between = boost::get<Between>(&view)) {
+                    simplify_between(e, *between);
+                } else if (auto const* in = boost::get<In>(&view)) {
+                    simplify_in(e, *in);
+                }
+            }
+
+            void simplify_binary(Expression& e, const BinaryOp& n) {
+                bool truth = false;
+                if (fold_comparison(n.op, n.left, n.right, truth)) {
+                    replace(e, boolean_literal(truth));
+                    return;
+                }
+                auto const* a = boost::get<IntLiteral>(&n.left);
+                auto const* b = boost::get<IntLiteral>(&n.right);
+                int64_t x = 0, y = 0, result = 0;
+                if (a && b && a->to_int64(x) && b->to_int64(y) && fold_integer(n.op, x, y, result)) {
+                    replace(e, IntLiteral(result));
+                }
+            }
+
+            // AND / OR の恒等元 (TRUE / FALSE) を除き、吸収元があれば定数にし、同じ演算子の子は平坦化する
+            void simplify_logical(Expression& e, const LogicalOp& n) {
+                const Truth identity = n.op == OpType::AND ? Truth::True : Truth::False;
+                bool changed = false;
+                for (auto const& operand : n.operands) {
+                    Truth t = truth_of(operand);
+                    if (t != Truth::Unknown && t != identity) {
+                        replace(e, boolean_literal(t == Truth::True));
+                        return;
+                    }
+                    auto const* child = boost::get<LogicalOp>(&operand);
+                    if (t == identity || (child && child->op == n.op)) changed = true;
+                }
+                if (!changed && n.operands.size() > 1) return;
+
+                std::vector<Expression> operands;
+                operands.reserve(n.operands.size());
+                for (auto const& operand : n.operands) {
+                    if (truth_of(operand) == identity) continue;
+                    auto const* child = boost::get<LogicalOp>(&operand);
+                    if (child && child->op == n.op) {
+                        operands.insert(operands.end(), child->operands.begin(), child->operands.end());
+                    } else {
+                        operands.push_back(operand);
+                    }
+                }
+                if (operands.empty()) {
+                    replace(e, boolean_literal(identity == Truth::True));
+                } else if (operands.size() == 1) {
+                    replace(e, std::move(operands.front()));
+                } else {
+                    boost::get<LogicalOp>(e).operands = std::move(operands);
+                    ++rewrites;
+                }
+            }
+
+            void simplify_unary(Expression& e, const UnaryOp& n) {
+                switch (n.op) {
+                case OpType::NOT: simplify_not(e, n.expr); break;
+                case OpType::SUB:
+                    if (auto const* i = boost::get<IntLiteral>(&n.expr)) {
+                        replace(e, negate_literal(*i));
+                    } else if (auto const* f = boost::get<FloatLiteral>(&n.expr)) {
+                        replace(e, negate_literal(*f));
+                    }
+                    break;
+                case OpType::IS_NULL:
+                case OpType::IS_NOT_NULL:
+                    if (is_null_literal(n.expr)) {
+                        replace(e, boolean_literal(n.op == OpType::IS_NULL));
+                    } else if (is_non_null_constant(n.expr)) {
+                        replace(e, boolean_literal(n.op == OpType::IS_NOT_NULL));
+                    }
+                    break;
+                default: break;
+                }
+            }
+
+            // NOT を子に吸収させる (NOT TRUE, NOT NOT x, NOT (a = b), NOT (x IS NULL), NOT (x IN ...), NOT (x BETWEEN ...))
+            void simplify_not(Expression& e, const Expression& operand) {
+                if (Truth t = truth_of(operand); t != Truth::Unknown) {
+                    replace(e, boolean_literal(t == Truth::False));
+                } else if (auto const* u = boost::get<UnaryOp>(&operand)) {
+                    if (u->op == OpType::NOT) {
+                        replace(e, u->expr);
+                    } else if (u->op == OpType::IS_NULL || u->op == OpType::IS_NOT_NULL) {
+                        UnaryOp flipped = *u;
+                        flipped.op = u->op == OpType::IS_NULL ? OpType::IS_NOT_NULL : OpType::IS_NULL;
+                        replace(e, Expression(std::move(flipped)));
+                    }
+                } else if (auto const* b = boost::get<BinaryOp>(&operand)) {
+                    OpType negated = b->op;
+                    if (negate_comparison(b->op, negated)) replace(e, Expression(BinaryOp{ negated, b->left, b->right }));
+                } else if (auto const* in = boost::get<In>(&operand)) {
+                    In flipped = *in;
+                    flipped.not_in = !in->not_in;
+                    replace(e, Expression(std::move(flipped)));
+                } else if (auto const* between = boost::get<Between>(&operand)) {
+                    replace(e, Expression(Between{ between->expr, between->lower, between->upper, !between->not_between }));
+                }
+            }
+
+            // 検索 CASE の WHEN FALSE を除き、先頭の WHEN TRUE はその結果にする
+            void simplify_case(Expression& e, const Case& n) {
+                if (n.arg) return;
+                bool changed = false;
+                for (auto const& w : n.when_clauses) {
+                    if (truth_of(w.when) != Truth::Unknown) {
+                        changed = true;
+                        break;
+                    }
+                }
+                if (!changed) return;
+
+                std::vector<WhenClause> clauses;
+                for (auto const& w : n.when_clauses) {
+                    Truth t = truth_of(w.when);
+                    if (t == Truth::False) continue;
+                    if (t == Truth::True) {
+                        if (clauses.empty()) {
+                            replace(e, w.then);
+                            return;
+                        }
+                        // 以降の WHEN には到達しない
+                        Case rest{ boost::none, std::move(clauses), w.then };
+                        replace(e, Expression(std::move(rest)));
+                        return;
+                    }
+                    clauses.push_back(w);
+                }
+                if (clauses.empty()) {
+                    replace(e, n.else_result ? *n.else_result : Expression(Identifier(L"NULL")));
+                } else {
+                    Case rest{ boost::none, std::move(clauses), n.else_result };
+                    replace(e, Expression(std::move(rest)));
+                }
+            }
+
+            // x BETWEEN a AND a は x = a
+            void simplify_between(Expression& e, const Between& n) {
+                if (!structural_equal(n.lower, n.upper)) return;
+                replace(e, Expression(BinaryOp{ n.not_between ? OpType::NE : OpType::EQ, n.expr, n.lower }));
+            }
+
+            // 要素が 1 つの x IN (v) は x = v
+            void simplify_in(Expression& e, const In& n) {
+                if (n.size() != 1) return;
+                replace(e, Expression(BinaryOp{ n.not_in ? OpType::NE : OpType::EQ, n.expr, n.value_at(0) }));
+            }
+
+            // WHERE TRUE / HAVING TRUE を除き、INNER JOIN ... ON TRUE は CROSS JOIN にする
+            // GROUP BY も集約もない SELECT 文の HAVING は全体を 1 グループにするため、HAVING TRUE でも残す
+            void leave(SelectStatement& stmt) {
+                if (stmt.where && truth_of(*stmt.where) == Truth::True) {
+                    stmt.where = boost::none;
+                    ++rewrites;
+                }
+                if (stmt.having && truth_of(*stmt.having) == Truth::True && is_grouped(stmt)) {
+                    stmt.having = boost::none;
+                    ++rewrites;
+                }
+                for (auto& join : stmt.joins) {
+                    if (join.type == JoinType::INNER && join.on && !join.natural && join.using_columns.empty() &&
+                        truth_of(*join.on) == Truth::True) {
+                        join.type = JoinType::CROSS;
+                        join.on = boost::none;
+                        ++rewrites;
+                    }
+                }
+            }
+        };
+    }
+
+    // 定数の畳み込みと式の簡約
+    // AST を 1 回だけ帰りがけ順に走査し、子を簡約してから親を簡約する。
+    //   - 数値リテラル同士の比較 (1 = 1 → TRUE) と整数の +, -, *, %, &, |、数値リテラルの単項マイナス
+    //   - AND / OR の TRUE / FALSE (x AND TRUE → x, x OR TRUE → TRUE) と、入れ子の同じ演算子の平坦化
+    //   - NOT の吸収 (NOT NOT x → x, NOT (a = b) → a <> b, NOT (x IS NULL) → x IS NOT NULL, IN / BETWEEN の NOT の反転)
+    //   - 定数の IS [NOT] NULL、検索 CASE の WHEN TRUE / WHEN FALSE
+    //   - 要素が 1 つの IN (x IN (v) → x = v) と、上下限が同じ BETWEEN (x BETWEEN a AND a → x = a)
+    //   - SELECT 文の WHERE TRUE / HAVING TRUE (GROUP BY か集約がある場合) の削除、INNER JOIN ... ON TRUE → CROSS JOIN
+    // どれも NULL を含む三値論理で結果が変わらない変換に限る。文字列の比較と整数の除算、^ (PostgreSQL ではべき乗) は DB に依存するため畳み込まない。
+    // 判定は const の参照で行うため、書き換えのない部分木ではヒープ確保は発生しない
+    // (非 const の walk と同様に、他と共有されているノードは走査の時点で複製される)。
+    // 書き換えた回数を返す。
+    inline size_t simplify(Expression& e) {
+        detail::Simplifier simplifier;
+        walk(e, simplifier);
+        return simplifier.rewrites;
+    }
+
+    inline size_t simplify(SelectStatement& stmt) {
+        detail::Simplifier simplifier;
+        walk(stmt, simplifier);
+        return simplifier.rewrites;
+    }
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace sqlparser {
+
+    // 短い文字列をインラインで保持する不変文字列 (AST の識別子・型名・文字列リテラル用)
+    // オブジェクトは wchar_t 24 個分 (wchar_t が 4 バイトなら 96 バイト、2 バイトなら 48 バイト) で、
+    // inline_capacity (23) 文字以下はヒープ確保なしでオブジェクト内に格納する。
+    // libstdc++ の std::wstring の SSO は 3 文字までのため、ほぼ全ての識別子で malloc が発生していた。
+    // customer_id_fk や total_amount_with_tax のような長めの識別子もインラインに収めるため、文字数で大きさを決めている
+    // (view() が wchar_t の連続した領域を返すため、狭い文字での格納はしない)。
+    // ヒープのバッファは参照カウントで共有するため、長い文字列もコピーでは確保しない (内容は変更されない)。
+    //
+    // 配置 (buf_ の最後の 1 文字がタグ)
+    //   インライン: buf_[0, size) が文字列、buf_[size] が L'\0'、タグは inline_capacity - size
+    //               (inline_capacity 文字ちょうどのときタグの 0 が終端を兼ねる)
+    //   ヒープ:     buf_ の先頭にバッファへのポインタと文字数、タグは heap_tag
+    class SmallString {
+        static constexpr size_t slots = 24;
+
+    public:
+        using value_type = wchar_t;
+        using size_type = size_t;
+        using const_iterator = const wchar_t*;
+        using traits_type = std::char_traits<wchar_t>;
+
+        static constexpr size_type npos = std::wstring_view::npos;
+        // インラインに収まる文字数
+        static constexpr size_type inline_capacity = slots - 1;
+
+        SmallString() { set_inline_size(0); }
+        SmallString(std::wstring_view s) { init(s.data(), s.size()); }
+        SmallString(const std::wstring& s) : SmallString(std::wstring_view(s)) {}
+        SmallString(const wchar_t* s) : SmallString(std::wstring_view(s)) {}
+        SmallString(const wchar_t* s, size_type n) { init(s, n); }
+
+        // 入力バッファの範囲から直接構築する (一時的な std::wstring を作らない)
+        template <typename It>
+            requires (!std::is_convertible_v<It, size_type>)
+        SmallString(It first, It last) {
+            if constexpr (std::contiguous_iterator<It>) {
+                init(std::to_address(first), static_cast<size_type>(last - first));
+            } else {
+                std::wstring tmp(first, last);
+                init(tmp.data(), tmp.size());
+            }
+        }
+
+        // オブジェクト全体を固定長でコピーする (可変長の memcpy 呼び出しより速い)
+        // ヒープの場合はバッファを共有して参照カウントを増やす
+        SmallString(const SmallString& other) noexcept {
+            std::memcpy(buf_, other.buf_, sizeof(buf_));
+            if (!is_inline()) header(heap_data())->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        SmallString(SmallString&& other) noexcept {
+            std::memcpy(buf_, other.buf_, sizeof(buf_));
+            if (!other.is_inline()) other.set_inline_size(0);
+        }
+
+        SmallString& operator=(const SmallString& other) noexcept {
+            if (this != &other) {
+                SmallString tmp(other);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        SmallString& operator=(SmallString&& other) noexcept {
+            if (this != &other) {
+                SmallString tmp(std::move(other));
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        SmallString& operator=(std::wstring_view s) { return *this = SmallString(s); }
+        SmallString& operator=(const std::wstring& s) { return *this = SmallString(s); }
+        SmallString& operator=(const wchar_t* s) { return *this = SmallString(s); }
+
+        ~SmallString() { release(); }
+
+        // オブジェクト内を指すポインタを持たないため、バイト列の交換でよい
+        void swap(SmallString& other) noexcept {
+            wchar_t tmp[slots];
+            std::memcpy(tmp, buf_, sizeof(buf_));
+            std::memcpy(buf_, other.buf_, sizeof(buf_));
+            std::memcpy(other.buf_, tmp, sizeof(buf_));
+        }
+
+        const wchar_t* data() const { return is_inline() ? buf_ : heap_data(); }
+        const wchar_t* c_str() const { return data(); }
+        size_type size() const { return is_inline() ? inline_capacity - static_cast<size_type>(tag()) : heap_size(); }
+        size_type length() const { return size(); }
+        bool empty() const { return size() == 0; }
+        // ヒープ確保なしで保持しているか
+        bool is_inline() const { return tag() != heap_tag; }
+        // ヒープのバッファを他の SmallString と共有しているか
+        bool shares_buffer(const SmallString& other) const { return !is_inline() && !other.is_inline() && heap_data() == other.heap_data(); }
+
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + size(); }
+        wchar_t operator[](size_type i) const { return data()[i]; }
+
+        std::wstring_view view() const { return is_inline() ? std::wstring_view(buf_, size()) : std::wstring_view(heap_data(), heap_size()); }
+        std::wstring str() const { return std::wstring(view()); }
+        operator std::wstring_view() const { return view(); }
+
+        friend bool operator==(const SmallString& a, const SmallString& b) { return a.view() == b.view(); }
+
+        // 文字列との比較 (std::wstring / const wchar_t* / std::wstring_view)
+        template <typename T>
+            requires (!std::is_same_v<T, SmallString> && std::is_convertible_v<const T&, std::wstring_view>)
+        friend bool operator==(const SmallString& a, const T& b) {
+            return a.view() == std::wstring_view(b);
+        }
+
+        friend bool operator<(const SmallString& a, const SmallString& b) { return a.view() < b.view(); }
+
+        friend std::wostream& operator<<(std::wostream& os, const SmallString& s) { return os << s.view(); }
+
+    private:
+        // ヒープのバッファの先頭に置く参照カウント (ポインタはその直後の文字列を指す)
+        struct Header {
+            std::atomic<uint32_t> refs;
+        };
+        static_assert(sizeof(Header) % alignof(wchar_t) == 0);
+
+        // インラインのタグは 0 〜 inline_capacity なので、それ以外の値をヒープの印にする
+        static constexpr wchar_t heap_tag = static_cast<wchar_t>(slots);
+        static constexpr size_t size_offset = sizeof(wchar_t*);
+        static_assert(size_offset + sizeof(size_type) <= inline_capacity * sizeof(wchar_t));
+
+        static Header* header(wchar_t* p) { return reinterpret_cast<Header*>(reinterpret_cast<char*>(p) - sizeof(Header)); }
+
+        wchar_t tag() const { return buf_[slots - 1]; }
+
+        wchar_t* heap_data() const {
+            wchar_t* p;
+            std::memcpy(&p, buf_, sizeof(p));
+            return p;
+        }
+
+        size_type heap_size() const {
+            size_type n;
+            std::memcpy(&n, reinterpret_cast<const char*>(buf_) + size_offset, sizeof(n));
+            return n;
+        }
+
+        void set_inline_size(size_type n) {
+            buf_[n] = L'\0';
+            buf_[slots - 1] = static_cast<wchar_t>(inline_capacity - n);
+        }
+
+        void init(const wchar_t* s, size_type n) {
+            if (n <= inline_capacity) {
+                traits_type::copy(buf_, s, n);
+                set_inline_size(n);
+                return;
+            }
+            char* block = static_cast<char*>(::operator new(sizeof(Header) + (n + 1) * sizeof(wchar_t)));
+            new (block) Header{ 1 };
+            wchar_t* p = reinterpret_cast<wchar_t*>(block + sizeof(Header));
+            traits_type::copy(p, s, n);
+            p[n] = L'\0';
+            std::memcpy(buf_, &p, sizeof(p));
+            std::memcpy(reinterpret_cast<char*>(buf_) + size_offset, &n, sizeof(n));
+            buf_[slots - 1] = heap_tag;
+        }
+
+        void release() {
+            if (is_inline()) return;
+            Header* h = header(heap_data());
+            if (h->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                h->~Header();
+                ::operator delete(h);
+            }
+        }
+
+        alignas(wchar_t*) wchar_t buf_[slots];
+    };
+
+    static_assert(sizeof(SmallString) == 24 * sizeof(wchar_t));
+    static_assert(SmallString::inline_capacity >= 22);
+}
+
+template <>
+struct std::hash<sqlparser::SmallString> {
+    size_t operator()(const sqlparser::SmallString& s) const noexcept { return std::hash<std::wstring_view>()(s.view()); }
+};
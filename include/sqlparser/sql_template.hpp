@@ -0,0 +1,135 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+#include <sqlparser/ast.hpp>
+#include <sqlparser/generator.hpp>
+#include <sqlparser/parser.hpp>
+
+namespace sqlparser {
+
+    namespace detail {
+        // プレースホルダの綴り (SQL には現れない私用領域の文字で番号を囲む)
+        inline constexpr wchar_t placeholder_open = L'\uE000';
+        inline constexpr wchar_t placeholder_close = L'\uE001';
+    }
+
+    // 生成時に index 番目のパラメータになる整数リテラル
+    // AST に置いてから SqlTemplate::compile() に渡す (generate() の出力にはそのまま使えない)
+    inline ast::IntLiteral placeholder(uint32_t index) {
+        wchar_t buf[16];
+        size_t n = 0;
+        buf[n++] = detail::placeholder_open;
+        wchar_t digits[10];
+        size_t d = 0;
+        do {
+            digits[d++] = static_cast<wchar_t>(L'0' + index % 10);
+            index /= 10;
+        } while (index != 0);
+        while (d > 0) buf[n++] = digits[--d];
+        buf[n++] = detail::placeholder_close;
+        return ast::IntLiteral(std::wstring_view(buf, n));
+    }
+
+    // 整数パラメータの位置だけが異なる SQL を、パースも AST の操作も generate() もせずに作るための生成済みテンプレート
+    // compile() で一度だけ SQL を生成してプレースホルダの位置で断片に分け、
+    // render() は断片と整数の 10 進表記をバッファに書き込むだけ (出力先の容量が足りていればヒープ確保なし)。
+    class SqlTemplate {
+    public:
+        // ast を生成してテンプレートにする。ast 中のプレースホルダ以外に私用領域の文字 (U+E000, U+E001) があれば false
+        bool compile(const ast::SelectStatement& ast) {
+            text_.clear();
+            segments_.clear();
+            parameter_count_ = 0;
+
+            String sql = generate(ast);
+            size_t literal_begin = 0;
+            size_t pos = 0;
+            while (pos < sql.size()) {
+                wchar_t c = sql[pos];
+                if (c == detail::placeholder_close) return false;
+                if (c != detail::placeholder_open) {
+                    ++pos;
+                    continue;
+                }
+                size_t close = sql.find(detail::placeholder_close, pos + 1);
+                if (close == String::npos || close == pos + 1) return false;
+                uint32_t index = 0;
+                for (size_t i = pos + 1; i < close; ++i) {
+                    if (sql[i] < L'0' || sql[i] > L'9') return false;
+                    index = index * 10 + static_cast<uint32_t>(sql[i] - L'0');
+                }
+                segments_.push_back({ static_cast<uint32_t>(text_.size()), static_cast<uint32_t>(pos - literal_begin), index });
+                text_.append(sql, literal_begin, pos - literal_begin);
+                if (index + 1 > parameter_count_) parameter_count_ = index + 1;
+                pos = close + 1;
+                literal_begin = pos;
+            }
+            tail_offset_ = static_cast<uint32_t>(text_.size());
+            text_.append(sql, literal_begin, String::npos);
+            return true;
+        }
+
+        size_t parameter_count() const { return parameter_count_; }
+
+        // values[i] を i 番目のパラメータに埋めた SQL を out に書き込む (out の既存の内容は破棄する)
+        // values が parameter_count() より少なければ false
+        bool render(const int64_t* values, size_t count, String& out) const {
+            if (count < parameter_count_) return false;
+            out.clear();
+            for (auto const& seg : segments_) {
+                out.append(text_, seg.offset, seg.length);
+                append_integer(out, values[seg.parameter]);
+            }
+            out.append(text_, tail_offset_, String::npos);
+            return true;
+        }
+
+        bool render(std::initializer_list<int64_t> values, String& out) const {
+            return render(values.begin(), values.size(), out);
+        }
+
+        // パラメータが 1 つのテンプレート用
+        String render(int64_t value) const {
+            String out;
+            out.reserve(text_.size() + segments_.size() * 20);
+            render(&value, 1, out);
+            return out;
+        }
+
+    private:
+        // 10 進表記を固定長バッファで組み立てて追加する
+        static void append_integer(String& out, int64_t value) {
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), value);
+            wchar_t wide[24];
+            size_t n = static_cast<size_t>(result.ptr - buf);
+            for (size_t i = 0; i < n; ++i) wide[i] = static_cast<wchar_t>(buf[i]);
+            out.append(wide, n);
+        }
+
+        // text_[offset, offset + length) の後に parameter 番目の値を書く
+        struct Segment {
+            uint32_t offset;
+            uint32_t length;
+            uint32_t parameter;
+        };
+
+        String text_; // プレースホルダを除いた SQL の断片を連結したもの
+        std::vector<Segment> segments_;
+        uint32_t tail_offset_ = 0; // 最後のプレースホルダより後の断片の位置
+        size_t parameter_count_ = 0;
+    };
+
+    // "先頭カラム = id" で絞り込む SQL (examples/add_exsiting_sql.cpp の build_id_filter_sql) のテンプレートを作る
+    // sql を一度だけパースし、先頭カラムの条件をプレースホルダ 0 番で追加して compile() する。
+    // パースできない場合や、先頭カラムが条件に使えない SELECT 文がある場合は false
+    inline bool compile_id_filter(std::wstring_view sql, SqlTemplate& out, ast::UnionScope scope = ast::UnionScope::All) {
+        ast::SelectStatement stmt;
+        if (!parser::parse(sql, stmt)) return false;
+        if (!ast::and_where_first_column(stmt, ast::OpType::EQ, placeholder(0), scope)) return false;
+        return out.compile(stmt);
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace sqlparser {
+
+    // 識別子のインターン表 (プロセス全体で共有)
+    // 登録済みの文字列は移動も解放もされないため、id から文字列への変換はロックなしで行える。
+    // 検索は shared_mutex の共有ロック、未登録の文字列の追加時のみ排他ロックを取る。
+    class SymbolTable {
+    public:
+        static SymbolTable& global() {
+            static SymbolTable table;
+            return table;
+        }
+
+        // 文字列を登録して id を返す (登録済みなら既存の id)
+        // 表が一杯 (capacity() 語) なら std::length_error を投げる
+        uint32_t intern(std::wstring_view s) {
+            {
+                std::shared_lock lock(mutex_);
+                auto it = index_.find(s);
+                if (it != index_.end()) return it->second;
+            }
+            std::unique_lock lock(mutex_);
+            auto it = index_.find(s);
+            if (it != index_.end()) return it->second;
+
+            uint32_t id = size_.load(std::memory_order_relaxed);
+            if (id >= capacity()) throw std::length_error("sqlparser::SymbolTable: too many distinct identifiers");
+            size_t chunk_index = id / chunk_size;
+            Chunk* chunk = chunks_[chunk_index].load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = new Chunk();
+                chunks_[chunk_index].store(chunk, std::memory_order_release);
+            }
+            std::wstring& slot = (*chunk)[id % chunk_size];
+            slot.assign(s);
+            index_.emplace(std::wstring_view(slot), id);
+            size_.store(id + 1, std::memory_order_release);
+            return id;
+        }
+
+        // id に対応する文字列 (ロックなし)
+        const std::wstring& str(uint32_t id) const {
+            Chunk* chunk = chunks_[id / chunk_size].load(std::memory_order_acquire);
+            return (*chunk)[id % chunk_size];
+        }
+
+        size_t size() const { return size_.load(std::memory_order_acquire); }
+
+        static constexpr size_t capacity() { return chunk_size * max_chunks; }
+
+        ~SymbolTable() {
+            for (size_t i = 0; i < max_chunks; ++i) delete chunks_[i].load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t chunk_size = 4096;
+        static constexpr size_t max_chunks = 1 << 12; // 最大 1600 万語
+        using Chunk = std::array<std::wstring, chunk_size>;
+
+        SymbolTable() {
+            intern(std::wstring_view()); // id 0 は空文字列
+        }
+
+        SymbolTable(const SymbolTable&) = delete;
+        SymbolTable& operator=(const SymbolTable&) = delete;
+
+        std::unique_ptr<std::atomic<Chunk*>[]> chunks_{ new std::atomic<Chunk*>[max_chunks]() };
+        std::atomic<uint32_t> size_{ 0 };
+        std::shared_mutex mutex_;
+        std::unordered_map<std::wstring_view, uint32_t> index_;
+    };
+
+    // インターンされた識別子 (32bit の id)
+    // 比較とハッシュは id だけで O(1)。元の文字列は str() で取得でき、generate() でもそのまま出力される。
+    class Symbol {
+    public:
+        Symbol() = default;
+        Symbol(std::wstring_view s) : id_(SymbolTable::global().intern(s)) {}
+        Symbol(const std::wstring& s) : Symbol(std::wstring_view(s)) {}
+        Symbol(const wchar_t* s) : Symbol(std::wstring_view(s)) {}
+
+        uint32_t id() const { return id_; }
+        const std::wstring& str() const { return SymbolTable::global().str(id_); }
+        bool empty() const { return id_ == 0; }
+        size_t size() const { return str().size(); }
+
+        operator const std::wstring&() const { return str(); }
+        operator std::wstring_view() const { return str(); }
+
+        friend bool operator==(const Symbol& a, const Symbol& b) { return a.id_ == b.id_; }
+
+        // 文字列との比較 (std::wstring / const wchar_t* / std::wstring_view)
+        template <typename T>
+            requires (!std::is_same_v<T, Symbol> && std::is_convertible_v<const T&, std::wstring_view>)
+        friend bool operator==(const Symbol& a, const T& b) {
+            return std::wstring_view(a.str()) == std::wstring_view(b);
+        }
+
+        friend bool operator<(const Symbol& a, const Symbol& b) { return a.str() < b.str(); }
+
+        friend std::wostream& operator<<(std::wostream& os, const Symbol& s) { return os << s.str(); }
+
+    private:
+        uint32_t id_ = 0;
+    };
+}
+
+template <>
+struct std::hash<sqlparser::Symbol> {
+    size_t operator()(const sqlparser::Symbol& s) const noexcept { return std::hash<uint32_t>()(s.id()); }
+};
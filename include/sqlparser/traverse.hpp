@@ -0,0 +1,330 @@
+#pragma once
+#include <type_traits>
+#include <utility>
+#include <boost/mpl/at.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/variant/recursive_wrapper_fwd.hpp>
+#include <sqlparser/ast.hpp>
+
+namespace sqlparser::ast {
+
+    // enter / leave の戻り値 (void を返す場合は Continue と同じ)
+    enum class Visit {
+        Continue, // 子ノードを走査する
+        Skip,     // このノードの子ノードを走査しない (enter のみ。leave は呼ばれる)
+        Stop      // 走査全体を打ち切る
+    };
+
+    // AST の走査
+    // visitor には必要なノード型のメンバ関数だけを定義する (どれも省略可能、呼び出しはコンパイル時に解決される)。
+    //   Visit enter(T& node)  : 子ノードより前 (行きがけ順) に呼ばれる
+    //   Visit leave(T& node)  : 子ノードより後 (帰りがけ順) に呼ばれる
+    //   T は Expression の各ノード型 (IntLiteral, Identifier, BinaryOp, ... , Exists) と
+    //   SelectStatement, ResultColumn, Table, Subquery, Join, OrderByElement。
+    //   const 版の walk では const T& で受け取る。template で全ノードを受けてもよい。
+    //
+    //   Visit enter_expression(Expression& e) / Visit leave_expression(Expression& e)
+    //   : 式の置き場所そのもの。e に代入するとその場でノードを置き換えられる (ムーブで置き換えれば確保なし)。
+    //     enter_expression で置き換えた場合は置き換え後の式を走査する。
+    //     (ノード型の enter と名前を分けているのは、const Expression& が各ノード型から暗黙変換で作れてしまうため)
+    //
+    // 走査順は SQL 上の出現順 (SELECT リスト, FROM, JOIN, WHERE, GROUP BY, HAVING, ORDER BY, LIMIT, OFFSET, UNION)。
+    // EXISTS・派生テーブル・UNION の SELECT 文も再帰的に走査する。不要なら enter(SelectStatement&) で Skip を返す。
+    // 非 const 版の walk は、他と共有されている凍結されたノードを走査の時点で複製する (shared_node.hpp)。
+    // 読むだけの走査は const 版を使うこと。
+    // 走査中のコンテナ (LogicalOp::operands など) に要素を追加・削除しないこと。
+    // Stop で打ち切られた場合は false を返す。
+    template <typename Visitor>
+    bool walk(Expression& expr, Visitor&& visitor);
+    template <typename Visitor>
+    bool walk(const Expression& expr, Visitor&& visitor);
+    template <typename Visitor>
+    bool walk(SelectStatement& stmt, Visitor&& visitor);
+    template <typename Visitor>
+    bool walk(const SelectStatement& stmt, Visitor&& visitor);
+
+    namespace detail {
+
+        template <typename V, typename N>
+        Visit call_enter(V& v, N& node) {
+            if constexpr (requires { v.enter(node); }) {
+                if constexpr (std::is_void_v<decltype(v.enter(node))>) {
+                    v.enter(node);
+                    return Visit::Continue;
+                } else {
+                    return v.enter(node);
+                }
+            } else {
+                return Visit::Continue;
+            }
+        }
+
+        template <typename V, typename N>
+        Visit call_leave(V& v, N& node) {
+            if constexpr (requires { v.leave(node); }) {
+                if constexpr (std::is_void_v<decltype(v.leave(node))>) {
+                    v.leave(node);
+                    return Visit::Continue;
+                } else {
+                    return v.leave(node);
+                }
+            } else {
+                return Visit::Continue;
+            }
+        }
+
+        template <typename V, typename E>
+        Visit call_enter_expression(V& v, E& e) {
+            if constexpr (requires { v.enter_expression(e); }) {
+                if constexpr (std::is_void_v<decltype(v.enter_expression(e))>) {
+                    v.enter_expression(e);
+                    return Visit::Continue;
+                } else {
+                    return v.enter_expression(e);
+                }
+            } else {
+                return Visit::Continue;
+            }
+        }
+
+        template <typename V, typename E>
+        Visit call_leave_expression(V& v, E& e) {
+            if constexpr (requires { v.leave_expression(e); }) {
+                if constexpr (std::is_void_v<decltype(v.leave_expression(e))>) {
+                    v.leave_expression(e);
+                    return Visit::Continue;
+                } else {
+                    return v.leave_expression(e);
+                }
+            } else {
+                return Visit::Continue;
+            }
+        }
+
+        // E / N は const 付きの型も取る (const 版と非 const 版を同じコードで走査する)
+        template <typename V, typename E>
+        bool walk_expression(E& e, V& v);
+
+        template <typename V, typename N>
+        bool walk_node(N& node, V& v);
+
+        template <typename V, typename O>
+        bool walk_optional(O& opt, V& v) {
+            return !opt || walk_expression(*opt, v);
+        }
+
+        template <typename V, typename C>
+        bool walk_expressions(C& list, V& v) {
+            for (auto& e : list) {
+                if (!walk_expression(e, v)) return false;
+            }
+            return true;
+        }
+
+        // FROM / JOIN のテーブル参照 (walk_expression と同じく which() で直接分岐する)
+        template <typename V, typename R>
+        bool walk_table_reference(R& ref, V& v) {
+            static_assert(boost::mpl::size<TableReference::types>::value == 2, "walk_table_reference の分岐に新しい型を追加すること");
+            if (ref.which() == 0) return walk_node(*boost::get<Table>(&ref), v);
+            return walk_node(*boost::get<Subquery>(&ref), v);
+        }
+
+        template <typename V, typename N>
+        bool walk_children(N& node, V& v) {
+            using T = std::remove_const_t<N>;
+            if constexpr (std::is_same_v<T, BinaryOp>) {
+                return walk_expression(node.left, v) && walk_expression(node.right, v);
+            } else if constexpr (std::is_same_v<T, LogicalOp>) {
+                return walk_expressions(node.operands, v);
+            } else if constexpr (std::is_same_v<T, UnaryOp> || std::is_same_v<T, Cast>) {
+                return walk_expression(node.expr, v);
+            } else if constexpr (std::is_same_v<T, FunctionCall>) {
+                return walk_expressions(node.args, v);
+            } else if constexpr (std::is_same_v<T, Case>) {
+                if (!walk_optional(node.arg, v)) return false;
+                for (auto& w : node.when_clauses) {
+                    if (!walk_expression(w.when, v) || !walk_expression(w.then, v)) return false;
+                }
+                return walk_optional(node.else_result, v);
+            } else if constexpr (std::is_same_v<T, Between>) {
+                return walk_expression(node.expr, v) && walk_expression(node.lower, v) && walk_expression(node.upper, v);
+            } else if constexpr (std::is_same_v<T, In>) {
+                // LiteralList の値は式ノードを持たないため走査しない
+                return walk_expression(node.expr, v) && walk_expressions(node.values, v);
+            } else if constexpr (std::is_same_v<T, WindowFunction>) {
+                if (!walk_node(node.func, v) || !walk_expressions(node.window.partitionBy, v)) return false;
+                for (auto& o : node.window.orderBy) {
+                    if (!walk_node(o, v)) return false;
+                }
+                return true;
+            } else if constexpr (std::is_same_v<T, Exists>) {
+                return walk_node(node.subquery.get(), v);
+            } else if constexpr (std::is_same_v<T, ResultColumn>) {
+                return walk_expression(node.expr, v);
+            } else if constexpr (std::is_same_v<T, Subquery>) {
+                return walk_node(node.select.get(), v);
+            } else if constexpr (std::is_same_v<T, Join>) {
+                return walk_table_reference(node.table, v) && walk_optional(node.on, v);
+            } else if constexpr (std::is_same_v<T, SelectStatement>) {
+                for (auto& col : node.columns) {
+                    if (!walk_node(col, v)) return false;
+                }
+                if (!walk_table_reference(node.table, v)) return false;
+                for (auto& join : node.joins) {
+                    if (!walk_node(join, v)) return false;
+                }
+                if (!walk_optional(node.where, v) || !walk_expressions(node.groupBy, v) || !walk_optional(node.having, v)) return false;
+                for (auto& o : node.orderBy) {
+                    if (!walk_node(o, v)) return false;
+                }
+                if (!walk_optional(node.limit, v) || !walk_optional(node.offset, v)) return false;
+                for (auto& u : node.unions) {
+                    if (!walk_node(u.select.get(), v)) return false;
+                }
+                return true;
+            } else {
+                // IntLiteral, FloatLiteral, Identifier, StringLiteral, Table, OrderByElement
+                return true;
+            }
+        }
+
+        template <typename V, typename N>
+        bool walk_node(N& node, V& v) {
+            Visit action = call_enter(v, node);
+            if (action == Visit::Stop) return false;
+            if (action == Visit::Continue && !walk_children(node, v)) return false;
+            return call_leave(v, node) != Visit::Stop;
+        }
+
+        // Expression の I 番目の型のノードを f に渡す (e.which() == I を確認済み)
+        // 非 const の Expression からは recursive_wrapper の中身を書き込み用に取り出す
+        template <int I, typename E, typename F>
+        decltype(auto) visit_alternative(E& e, F& f) {
+            using T = typename boost::unwrap_recursive<typename boost::mpl::at_c<Expression::types, I>::type>::type;
+            return f(*boost::get<T>(&e));
+        }
+
+        // e のノードを f に渡す
+        // apply_visitor (訪問用の関数オブジェクトの生成と間接呼び出し) を避け、which() で直接分岐する
+        template <typename E, typename F>
+        decltype(auto) visit_expression(E& e, F&& f) {
+            static_assert(boost::mpl::size<Expression::types>::value == 14, "visit_expression の switch に新しいノード型を追加すること");
+            switch (e.which()) {
+            case 0: return visit_alternative<0>(e, f);
+            case 1: return visit_alternative<1>(e, f);
+            case 2: return visit_alternative<2>(e, f);
+            case 3: return visit_alternative<3>(e, f);
+            case 4: return visit_alternative<4>(e, f);
+            case 5: return visit_alternative<5>(e, f);
+            case 6: return visit_alternative<6>(e, f);
+            case 7: return visit_alternative<7>(e, f);
+            case 8: return visit_alternative<8>(e, f);
+            case 9: return visit_alternative<9>(e, f);
+            case 10: return visit_alternative<10>(e, f);
+            case 11: return visit_alternative<11>(e, f);
+            case 12: return visit_alternative<12>(e, f);
+            default: return visit_alternative<13>(e, f);
+            }
+        }
+
+        template <typename V, typename E>
+        bool walk_expression(E& e, V& v) {
+            Visit action = call_enter_expression(v, e);
+            if (action == Visit::Stop) return false;
+            if (action == Visit::Continue && !visit_expression(e, [&](auto& node) { return walk_node(node, v); })) return false;
+            return call_leave_expression(v, e) != Visit::Stop;
+        }
+    }
+
+    template <typename Visitor>
+    bool walk(Expression& expr, Visitor&& visitor) {
+        return detail::walk_expression(expr, visitor);
+    }
+
+    template <typename Visitor>
+    bool walk(const Expression& expr, Visitor&& visitor) {
+        return detail::walk_expression(expr, visitor);
+    }
+
+    template <typename Visitor>
+    bool walk(SelectStatement& stmt, Visitor&& visitor) {
+        return detail::walk_node(stmt, visitor);
+    }
+
+    template <typename Visitor>
+    bool walk(const SelectStatement& stmt, Visitor&& visitor) {
+        return detail::walk_node(stmt, visitor);
+    }
+
+    namespace detail {
+        // 集約関数 (windows なら加えてウィンドウ関数) を探す。内側の SELECT 文は別のスコープなので探さない
+        // ウィンドウ関数の引数の集約 (SUM(x) OVER ()) は windows でなければ数えない
+        struct AggregateFinder {
+            bool windows = false;
+            bool found = false;
+
+            Visit enter(const SelectStatement&) { return Visit::Skip; }
+            Visit enter(const WindowFunction&) {
+                if (!windows) return Visit::Skip;
+                found = true;
+                return Visit::Stop;
+            }
+            Visit enter(const FunctionCall& call) {
+                if (!is_aggregate_function(call.name)) return Visit::Continue;
+                found = true;
+                return Visit::Stop;
+            }
+        };
+    }
+
+    // WHERE の条件に使える先頭カラムの式 (テナント ID などの "先頭カラム = 値" 条件用)
+    // カラムがない・* / t.*・リテラル、集約関数かウィンドウ関数を含む式 (SUM(x) + 1 など) の場合は nullptr
+    // (エイリアスは WHERE から参照できないため、エイリアスではなく式そのものを返す)
+    inline const Expression* first_column_expression(const SelectStatement& stmt) {
+        if (stmt.columns.empty()) return nullptr;
+        const Expression& expr = stmt.columns.front().expr;
+        if (boost::get<IntLiteral>(&expr) || boost::get<FloatLiteral>(&expr) || boost::get<StringLiteral>(&expr)) return nullptr;
+        if (auto* id = boost::get<Identifier>(&expr)) {
+            std::wstring_view name = *id;
+            if (name == L"*" || (name.size() >= 2 && name.substr(name.size() - 2) == L".*")) return nullptr;
+        }
+        detail::AggregateFinder finder{ .windows = true };
+        if (!walk(expr, finder)) return nullptr;
+        return &expr;
+    }
+
+    namespace detail {
+        inline bool first_columns_usable(const SelectStatement& stmt, UnionScope scope) {
+            if (!first_column_expression(stmt)) return false;
+            if (scope == UnionScope::All) {
+                for (auto const& u : stmt.unions) {
+                    if (!first_columns_usable(u.select.get(), scope)) return false;
+                }
+            }
+            return true;
+        }
+
+        inline void and_where_first_column_unchecked(SelectStatement& stmt, OpType op, const Expression& value, UnionScope scope) {
+            if (scope == UnionScope::All) {
+                for (auto& u : stmt.unions) {
+                    and_where_first_column_unchecked(u.select.get(), op, value, scope);
+                }
+            }
+            const SelectStatement& view = stmt;
+            BinaryOp cond;
+            cond.op = op;
+            cond.left = *first_column_expression(view);
+            cond.right = value;
+            add_conjunct(stmt.where, std::move(cond));
+        }
+    }
+
+    // "先頭カラム op value" を WHERE に AND で追加する
+    // 対象の SELECT 文のいずれかで先頭カラムが使えない場合 (first_column_expression が nullptr) は何も変更せず false
+    // 先頭カラムの式は条件ごとにコピーする
+    inline bool and_where_first_column(SelectStatement& stmt, OpType op, const Expression& value, UnionScope scope = UnionScope::All) {
+        if (!detail::first_columns_usable(stmt, scope)) return false;
+        detail::and_where_first_column_unchecked(stmt, op, value, scope);
+        return true;
+    }
+}
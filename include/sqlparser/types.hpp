@@ -0,0 +1,127 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace sqlparser {
+
+    // PostgreSQL の組み込み型 (postgresql_type.csv から生成した pg_type_catalog.inc の定義順)
+    enum class TypeId : uint8_t {
+        UNKNOWN, // カタログにない型 (ユーザー定義型など)
+#define SQLPARSER_PG_TYPE(id, name) id,
+#include <sqlparser/pg_type_catalog.inc>
+#undef SQLPARSER_PG_TYPE
+    };
+
+    // 型名の解析結果 (CAST / :: の型)
+    // 比較は TypeId と修飾子の整数比較のみ。UNKNOWN 同士の型名の比較は Cast::type_name で行うこと。
+    struct TypeInfo {
+        TypeId id = TypeId::UNKNOWN;
+        int32_t precision = -1; // 長さ・精度 (varchar(n) の n, numeric(p, s) の p)。指定なしは -1
+        int32_t scale = -1;     // 位取り (numeric(p, s) の s)。指定なしは -1
+        uint8_t array_dims = 0; // 配列の次元数 (int[][] なら 2)
+
+        friend bool operator==(const TypeInfo&, const TypeInfo&) = default;
+    };
+
+    namespace detail {
+        struct TypeCatalogName {
+            std::wstring_view name;
+            TypeId id;
+        };
+
+        // 正規名・エイリアス・省略可能な語を含む全ての綴り (小文字、語は空白 1 つで区切る)
+        inline constexpr TypeCatalogName type_catalog_names[] = {
+#define SQLPARSER_PG_TYPE_NAME(id, name) { name, TypeId::id },
+#include <sqlparser/pg_type_catalog.inc>
+#undef SQLPARSER_PG_TYPE_NAME
+        };
+
+        inline constexpr std::wstring_view type_catalog_canonical[] = {
+            L"",
+#define SQLPARSER_PG_TYPE(id, name) name,
+#include <sqlparser/pg_type_catalog.inc>
+#undef SQLPARSER_PG_TYPE
+        };
+
+        constexpr wchar_t type_name_lower(wchar_t c) {
+            return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+        }
+
+        // ASCII の大文字小文字を区別しない FNV-1a
+        constexpr uint32_t type_name_hash(std::wstring_view s) {
+            uint32_t h = 2166136261u;
+            for (wchar_t c : s) {
+                h ^= static_cast<uint32_t>(type_name_lower(c));
+                h *= 16777619u;
+            }
+            return h;
+        }
+
+        constexpr bool type_name_equals(std::wstring_view a, std::wstring_view b) {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (type_name_lower(a[i]) != b[i]) return false;
+            }
+            return true;
+        }
+
+        constexpr size_t type_catalog_size = std::size(type_catalog_names);
+        static_assert(type_catalog_size < 255, "type catalog index must fit in uint8_t");
+
+        // オープンアドレス法のハッシュ表 (値は type_catalog_names の添字 + 1、0 は空き)
+        constexpr size_t type_table_size = 256;
+        static_assert(type_table_size >= type_catalog_size * 2);
+
+        constexpr std::array<uint8_t, type_table_size> build_type_table() {
+            std::array<uint8_t, type_table_size> table{};
+            for (size_t i = 0; i < type_catalog_size; ++i) {
+                size_t slot = type_name_hash(type_catalog_names[i].name) & (type_table_size - 1);
+                while (table[slot] != 0) slot = (slot + 1) & (type_table_size - 1);
+                table[slot] = static_cast<uint8_t>(i + 1);
+            }
+            return table;
+        }
+
+        inline constexpr std::array<uint8_t, type_table_size> type_table = build_type_table();
+
+        constexpr size_t max_type_name_words() {
+            size_t result = 0;
+            for (auto const& entry : type_catalog_names) {
+                size_t words = 1;
+                for (wchar_t c : entry.name) if (c == L' ') ++words;
+                if (words > result) result = words;
+            }
+            return result;
+        }
+
+        constexpr size_t max_type_name_length() {
+            size_t result = 0;
+            for (auto const& entry : type_catalog_names) {
+                if (entry.name.size() > result) result = entry.name.size();
+            }
+            return result;
+        }
+    }
+
+    // カタログ中の名前で最も多い語数 ("timestamp without time zone" の 4)
+    inline constexpr size_t type_name_max_words = detail::max_type_name_words();
+    inline constexpr size_t type_name_max_length = detail::max_type_name_length();
+
+    // 型名 (語を空白 1 つで区切ったもの、大文字小文字は区別しない) から型を引く。見つからなければ UNKNOWN
+    constexpr TypeId find_type(std::wstring_view name) {
+        size_t slot = detail::type_name_hash(name) & (detail::type_table_size - 1);
+        while (uint8_t index = detail::type_table[slot]) {
+            auto const& entry = detail::type_catalog_names[index - 1];
+            if (detail::type_name_equals(name, entry.name)) return entry.id;
+            slot = (slot + 1) & (detail::type_table_size - 1);
+        }
+        return TypeId::UNKNOWN;
+    }
+
+    // 型の正規名 ("int4" なら "integer")。UNKNOWN は空文字列
+    constexpr std::wstring_view canonical_type_name(TypeId id) {
+        return detail::type_catalog_canonical[static_cast<size_t>(id)];
+    }
+}
@@ -1,9 +1,26 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <functional>
+#include <unordered_map>
 #include <sqlparser/parser.hpp>
 #include <sqlparser/generator.hpp>
+#include <sqlparser/lazy.hpp>
+#include <sqlparser/extract.hpp>
+#include <sqlparser/analysis.hpp>
+#include <sqlparser/compare.hpp>
+#include <sqlparser/persistent.hpp>
+#include <sqlparser/traverse.hpp>
+#include <sqlparser/policy.hpp>
+#include <sqlparser/sql_template.hpp>
+#include <sqlparser/rewrite.hpp>
+#include <sqlparser/simplify.hpp>
+#include <sqlparser/canonical.hpp>
+#include <sqlparser/pushdown.hpp>
+#include <sqlparser/decorrelate.hpp>
+#include <sqlparser/symbol.hpp>
+#include <sqlparser/small_string.hpp>
 
 int g_tests_passed = 0;
 int g_tests_failed = 0;
@@ -336,11 +353,12 @@ bool test_not_exists_with_and() {
     sqlparser::ast::SelectStatement ast;
     ASSERT_TRUE(sqlparser::parser::parse(input_sql, ast));
     ASSERT_TRUE(ast.where.has_value());
-    // WHERE 全体が BinaryOp(AND, ..., UnaryOp(NOT, Exists)) であることを確認
-    auto* and_op = boost::get<sqlparser::ast::BinaryOp>(&(*ast.where));
+    // WHERE 全体が LogicalOp(AND, [..., UnaryOp(NOT, Exists)]) であることを確認
+    auto* and_op = boost::get<sqlparser::ast::LogicalOp>(&(*ast.where));
     ASSERT_TRUE(and_op != nullptr);
     ASSERT_TRUE(and_op->op == sqlparser::ast::OpType::AND);
-    auto* unary_node = boost::get<sqlparser::ast::UnaryOp>(&(and_op->right));
+    ASSERT_EQ(and_op->operands.size(), 2u);
+    auto* unary_node = boost::get<sqlparser::ast::UnaryOp>(&(and_op->operands[1]));
     ASSERT_TRUE(unary_node != nullptr);
     ASSERT_TRUE(unary_node->op == sqlparser::ast::OpType::NOT);
     auto* exists_node = boost::get<sqlparser::ast::Exists>(&(unary_node->expr));
@@ -357,6 +375,1236 @@ bool test_not_exists_original_sql() {
     return true;
 }
 
+// --- Lazy Clause Parsing Tests ---
+
+bool test_lazy_from_only() {
+    // FROM にしかアクセスしなければ WHERE の解析失敗は表面化しない
+    sqlparser::LazySelectStatement stmt(L"SELECT id FROM users u WHERE (((");
+    ASSERT_TRUE(stmt.valid());
+    auto* table = stmt.table();
+    ASSERT_TRUE(table != nullptr);
+    auto* t = boost::get<sqlparser::ast::Table>(table);
+    ASSERT_TRUE(t != nullptr);
+    ASSERT_EQ(std::wstring(L"users"), t->name);
+    ASSERT_TRUE(stmt.where() == nullptr);
+    return true;
+}
+
+bool test_lazy_materialize() {
+    std::wstring sql = L"SELECT DISTINCT id, name FROM users u INNER JOIN orders o ON (u.id = o.user_id) WHERE (age > 20) ORDER BY id DESC LIMIT 10 UNION SELECT id, name FROM admins";
+    sqlparser::LazySelectStatement stmt(sql);
+    ASSERT_TRUE(stmt.valid());
+    ASSERT_TRUE(stmt.columns() != nullptr);
+    ASSERT_TRUE(stmt.columns()->size() == 2);
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(stmt.materialize(ast));
+    sqlparser::ast::SelectStatement expected;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, expected));
+    ASSERT_EQ(sqlparser::generate(expected), sqlparser::generate(ast));
+    return true;
+}
+
+// --- Table Extraction Tests ---
+
+bool test_extract_tables_joins() {
+    std::wstring sql = L"SELECT * FROM users u LEFT OUTER JOIN orders AS o ON (u.id = o.user_id), items";
+    std::vector<sqlparser::ReferencedTable> tables;
+    ASSERT_TRUE(sqlparser::extract_tables(sql, tables));
+    ASSERT_TRUE(tables.size() == 3);
+    ASSERT_EQ(std::wstring(L"users"), tables[0].name);
+    ASSERT_EQ(std::wstring(L"u"), *tables[0].alias);
+    ASSERT_TRUE(tables[0].offset == sql.find(L"users"));
+    // 名前とエイリアスは入力の SQL を指す
+    ASSERT_TRUE(tables[0].name.data() == sql.data() + tables[0].offset);
+    ASSERT_TRUE(tables[0].alias->data() == sql.data() + tables[0].alias_offset);
+    ASSERT_EQ(std::wstring(L"orders"), tables[1].name);
+    ASSERT_EQ(std::wstring(L"o"), *tables[1].alias);
+    ASSERT_TRUE(tables[1].alias_offset == sql.find(L"o ON"));
+    ASSERT_EQ(std::wstring(L"items"), tables[2].name);
+    ASSERT_TRUE(!tables[2].alias);
+    return true;
+}
+
+bool test_extract_tables_subqueries() {
+    std::wstring sql = L"SELECT * FROM (SELECT * FROM t1) s WHERE EXISTS (SELECT * FROM GIS.T2 A WHERE (s.id = A.id)) UNION SELECT * FROM t3";
+    std::vector<sqlparser::ReferencedTable> tables;
+    ASSERT_TRUE(sqlparser::extract_tables(sql, tables));
+    ASSERT_TRUE(tables.size() == 3);
+    ASSERT_EQ(std::wstring(L"t1"), tables[0].name);
+    ASSERT_EQ(std::wstring(L"GIS.T2"), tables[1].name);
+    ASSERT_EQ(std::wstring(L"A"), *tables[1].alias);
+    ASSERT_EQ(std::wstring(L"t3"), tables[2].name);
+    return true;
+}
+
+// --- Column Analysis Tests ---
+
+bool test_collect_columns_aliases() {
+    std::wstring sql = L"SELECT u.name, o.total FROM users u INNER JOIN orders o ON (u.id = o.user_id) WHERE (u.age > 20) AND (o.total > 10) ORDER BY name";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    sqlparser::ReferencedColumns cols;
+    sqlparser::collect_columns(ast, cols);
+
+    auto* users = boost::get<sqlparser::ast::Table>(&ast.table);
+    auto* orders = boost::get<sqlparser::ast::Table>(&ast.joins[0].table);
+    auto has = [&](const sqlparser::ast::Table* t, const std::wstring& col, sqlparser::ClauseKind clause) {
+        for (auto const& r : cols.refs) {
+            if (r.table == t && cols.name(r) == col && r.clause == clause) return true;
+        }
+        return false;
+    };
+    ASSERT_TRUE(has(users, L"name", sqlparser::ClauseKind::Select));
+    ASSERT_TRUE(has(orders, L"total", sqlparser::ClauseKind::Select));
+    ASSERT_TRUE(has(users, L"id", sqlparser::ClauseKind::Join));
+    ASSERT_TRUE(has(orders, L"user_id", sqlparser::ClauseKind::Join));
+    ASSERT_TRUE(has(users, L"age", sqlparser::ClauseKind::Where));
+    // 非修飾名はテーブルが複数あるため未解決
+    ASSERT_TRUE(has(nullptr, L"name", sqlparser::ClauseKind::OrderBy));
+    // "total" は重複排除されインターンされる
+    size_t total_names = 0;
+    for (auto const& n : cols.names) if (n == L"total") ++total_names;
+    ASSERT_TRUE(total_names == 1);
+    return true;
+}
+
+bool test_collect_columns_subquery_scopes() {
+    std::wstring sql = L"SELECT * FROM t1 WHERE EXISTS (SELECT * FROM t2 WHERE (t1.id = t2.ref_id))";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    sqlparser::ReferencedColumns cols;
+    sqlparser::collect_columns(ast, cols);
+
+    auto* t1 = boost::get<sqlparser::ast::Table>(&ast.table);
+    auto* exists_node = boost::get<sqlparser::ast::Exists>(&(*ast.where));
+    auto* t2 = boost::get<sqlparser::ast::Table>(&exists_node->subquery.get().table);
+    bool t1_star = false, t1_id = false, t2_ref = false;
+    for (auto const& r : cols.refs) {
+        if (r.table == t1 && cols.name(r) == L"*") t1_star = true;
+        if (r.table == t1 && cols.name(r) == L"id" && r.clause == sqlparser::ClauseKind::Where) t1_id = true;
+        if (r.table == t2 && cols.name(r) == L"ref_id") t2_ref = true;
+    }
+    ASSERT_TRUE(t1_star);
+    ASSERT_TRUE(t1_id);
+    ASSERT_TRUE(t2_ref);
+    return true;
+}
+
+// --- Join Chain Tests ---
+
+bool test_join_chain() {
+    std::wstring sql = L"SELECT * FROM a LEFT OUTER JOIN b ON (a.id = b.a_id) JOIN c ON (b.id = c.b_id) FULL JOIN (SELECT id FROM d) x ON (x.id = c.id)";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    ASSERT_TRUE(ast.joins.size() == 3);
+    ASSERT_TRUE(ast.joins[0].type == sqlparser::ast::JoinType::LEFT);
+    ASSERT_TRUE(ast.joins[1].type == sqlparser::ast::JoinType::INNER);
+    ASSERT_TRUE(ast.joins[2].type == sqlparser::ast::JoinType::FULL);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Subquery>(&ast.joins[2].table) != nullptr);
+    std::wstring expected = L"SELECT * FROM a LEFT JOIN b ON (a.id = b.a_id) INNER JOIN c ON (b.id = c.b_id) FULL JOIN (SELECT id FROM d) x ON (x.id = c.id)";
+    ASSERT_EQ(expected, sqlparser::generate(ast));
+    return true;
+}
+
+bool test_join_cross_natural_using() {
+    std::wstring sql = L"SELECT * FROM a CROSS JOIN b NATURAL LEFT JOIN c INNER JOIN d USING (id, code)";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    ASSERT_TRUE(ast.joins.size() == 3);
+    ASSERT_TRUE(ast.joins[0].type == sqlparser::ast::JoinType::CROSS);
+    ASSERT_TRUE(!ast.joins[0].on);
+    ASSERT_TRUE(ast.joins[1].natural && ast.joins[1].type == sqlparser::ast::JoinType::LEFT);
+    ASSERT_TRUE(ast.joins[2].using_columns.size() == 2);
+    ASSERT_TRUE(ast.joins[2].using_columns[1] == L"code");
+    ASSERT_EQ(std::wstring(L"SELECT * FROM a CROSS JOIN b NATURAL LEFT JOIN c INNER JOIN d USING (id, code)"), sqlparser::generate(ast));
+
+    // NATURAL JOIN に ON は付けられない
+    ASSERT_TRUE(!sqlparser::parser::parse(L"SELECT * FROM a NATURAL JOIN b ON (a.id = b.id)", ast));
+    return true;
+}
+
+bool test_implicit_join() {
+    std::wstring sql = L"SELECT * FROM a, b x, c LEFT JOIN d ON (c.id = d.c_id) WHERE (a.id = x.a_id)";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    ASSERT_TRUE(ast.joins.size() == 3);
+    ASSERT_TRUE(ast.joins[0].type == sqlparser::ast::JoinType::IMPLICIT);
+    ASSERT_TRUE(!ast.joins[0].on);
+    ASSERT_TRUE(ast.joins[1].type == sqlparser::ast::JoinType::IMPLICIT);
+    ASSERT_EQ(sql, sqlparser::generate(ast));
+
+    // 条件を付けたカンマ結合は INNER JOIN として出力される
+    ast.joins[0].on = sqlparser::ast::Expression(sqlparser::Identifier(L"ok"));
+    ASSERT_EQ(std::wstring(L"SELECT * FROM a INNER JOIN b x ON ok, c LEFT JOIN d ON (c.id = d.c_id) WHERE (a.id = x.a_id)"), sqlparser::generate(ast));
+    return true;
+}
+
+// --- Comment Tests ---
+
+bool test_comments() {
+    std::wstring sql = L"/* app=orm, route=/users */ -- leading hint\n"
+                       L"SELECT id, /* pk */ name -- display name\n"
+                       L"FROM users u /* (unbalanced */ INNER JOIN orders o ON (u.id = o.user_id) -- join\n"
+                       L"WHERE (name = '-- not a comment') ORDER BY id";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    std::wstring expected = L"SELECT id, name FROM users u INNER JOIN orders o ON (u.id = o.user_id) WHERE (name = '-- not a comment') ORDER BY id";
+    ASSERT_EQ(expected, sqlparser::generate(ast));
+    return true;
+}
+
+// --- IN List Tests ---
+
+bool test_in_literal_list() {
+    // 整数だけのリストは LiteralList (int64_t 配列) に格納される
+    {
+        std::wstring sql = L"SELECT * FROM t WHERE (id IN (10, -20, 0, 2147483647))";
+        sqlparser::ast::SelectStatement ast;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+        auto* in = boost::get<sqlparser::ast::In>(&(*ast.where));
+        ASSERT_TRUE(in != nullptr);
+        ASSERT_TRUE(in->values.empty());
+        ASSERT_TRUE(in->literals.kind == sqlparser::ast::LiteralList::Kind::INT);
+        ASSERT_EQ(in->size(), 4u);
+        ASSERT_EQ(in->literals.int_at(1), int64_t(-20));
+        auto v = in->value_at(3);
+        ASSERT_EQ(boost::get<sqlparser::ast::IntLiteral>(v).value(), int64_t(2147483647));
+        ASSERT_EQ(sqlparser::generate(ast), sql);
+    }
+    // 文字列だけのリスト
+    {
+        std::wstring sql = L"SELECT * FROM t WHERE (code NOT IN ('a', '', 'xyz'))";
+        sqlparser::ast::SelectStatement ast;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+        auto* in = boost::get<sqlparser::ast::In>(&(*ast.where));
+        ASSERT_TRUE(in != nullptr && in->not_in);
+        ASSERT_TRUE(in->literals.kind == sqlparser::ast::LiteralList::Kind::STRING);
+        ASSERT_EQ(in->size(), 3u);
+        ASSERT_TRUE(in->literals.string_at(1).empty());
+        ASSERT_TRUE(in->literals.string_at(2) == L"xyz");
+        ASSERT_EQ(sqlparser::generate(ast), sql);
+    }
+    // 式や型の混在は従来どおり Expression のリストになる
+    const wchar_t* fallbacks[] = {
+        L"SELECT * FROM t WHERE (id IN (1, (2 + 3), x))",
+        L"SELECT * FROM t WHERE (id IN (1, 'a'))",
+        L"SELECT * FROM t WHERE (id IN (1, y))",
+    };
+    for (auto const* sql : fallbacks) {
+        sqlparser::ast::SelectStatement ast;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+        auto* in = boost::get<sqlparser::ast::In>(&(*ast.where));
+        ASSERT_TRUE(in != nullptr);
+        ASSERT_TRUE(in->literals.empty());
+        ASSERT_TRUE(!in->values.empty());
+        ASSERT_EQ(sqlparser::generate(ast), std::wstring(sql));
+    }
+    // 大きなリストのラウンドトリップ
+    std::wstring big = L"SELECT * FROM t WHERE (id IN (";
+    for (int i = 0; i < 50000; ++i) {
+        if (i > 0) big += L", ";
+        big += std::to_wstring(i * 7);
+    }
+    big += L"))";
+    sqlparser::ast::SelectStatement big_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(big, big_ast));
+    ASSERT_EQ(boost::get<sqlparser::ast::In>(*big_ast.where).literals.size(), 50000u);
+    ASSERT_TRUE(sqlparser::generate(big_ast) == big);
+    return true;
+}
+
+bool test_numeric_literal_text() {
+    // 数値リテラルは綴りのまま往復する (BIGINT / NUMERIC の桁落ちなし)
+    std::wstring sql = L"SELECT 9223372036854775807, 42, 123456789012345678901234567890, 1.0, 12345.678901234567890123, .5, 1.5e-3, 007 FROM t";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    ASSERT_EQ(sqlparser::generate(ast), sql);
+
+    auto const& big = boost::get<sqlparser::ast::IntLiteral>(ast.columns[0].expr);
+    ASSERT_EQ(big.value(), std::numeric_limits<int64_t>::max());
+    ASSERT_EQ(boost::get<sqlparser::ast::IntLiteral>(ast.columns[1].expr).value(), int64_t(42));
+    int64_t out = 0;
+    ASSERT_TRUE(!boost::get<sqlparser::ast::IntLiteral>(ast.columns[2].expr).to_int64(out));
+    ASSERT_TRUE(boost::get<sqlparser::ast::FloatLiteral>(ast.columns[3].expr).text == L"1.0");
+    ASSERT_TRUE(boost::get<sqlparser::ast::FloatLiteral>(ast.columns[5].expr).value() == 0.5);
+    ASSERT_TRUE(boost::get<sqlparser::ast::FloatLiteral>(ast.columns[6].expr).value() == 1.5e-3);
+    ASSERT_EQ(boost::get<sqlparser::ast::IntLiteral>(ast.columns[7].expr).value(), int64_t(7));
+
+    // 数値から構築したリテラル
+    ASSERT_TRUE(sqlparser::ast::IntLiteral(int64_t(-5000000000)).text == L"-5000000000");
+    ASSERT_TRUE(sqlparser::ast::FloatLiteral(0.6).text == L"0.6");
+
+    // IN リスト: int64_t の範囲の整数は INT、小数や範囲外の数値を含むと綴りのまま NUMERIC になる
+    std::wstring in_sql = L"SELECT * FROM t WHERE (id IN (-9223372036854775808, 5000000000))";
+    sqlparser::ast::SelectStatement in_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(in_sql, in_ast));
+    ASSERT_TRUE(boost::get<sqlparser::ast::In>(*in_ast.where).literals.kind == sqlparser::ast::LiteralList::Kind::INT);
+    ASSERT_EQ(boost::get<sqlparser::ast::In>(*in_ast.where).literals.size(), 2u);
+    ASSERT_EQ(sqlparser::generate(in_ast), in_sql);
+    std::wstring wide_sql = L"SELECT * FROM t WHERE (id IN (1, 99999999999999999999, 2.50, 007))";
+    sqlparser::ast::SelectStatement wide_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(wide_sql, wide_ast));
+    auto const& wide_in = boost::get<sqlparser::ast::In>(*wide_ast.where);
+    ASSERT_TRUE(wide_in.literals.kind == sqlparser::ast::LiteralList::Kind::NUMERIC);
+    ASSERT_EQ(wide_in.size(), 4u);
+    ASSERT_TRUE(boost::get<sqlparser::ast::IntLiteral>(wide_in.value_at(0)).text == L"1");
+    ASSERT_TRUE(boost::get<sqlparser::ast::FloatLiteral>(wide_in.value_at(2)).value() == 2.5);
+    ASSERT_EQ(sqlparser::generate(wide_ast), wide_sql);
+    return true;
+}
+
+bool test_string_literal_views() {
+    // '' エスケープの解除と再エスケープ
+    std::wstring sql = L"SELECT 'it''s', 'plain', '''' FROM t WHERE (name IN ('O''Brien', 'x'))";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    auto const& first = boost::get<sqlparser::ast::StringLiteral>(ast.columns[0].expr);
+    ASSERT_TRUE(!first.is_view());
+    ASSERT_TRUE(first.value == L"it's");
+    ASSERT_TRUE(boost::get<sqlparser::ast::StringLiteral>(ast.columns[2].expr).text() == L"'");
+    auto const& in = boost::get<sqlparser::ast::In>(*ast.where);
+    ASSERT_TRUE(boost::get<sqlparser::ast::StringLiteral>(in.value_at(0)).text() == L"O'Brien");
+    ASSERT_EQ(sqlparser::generate(ast), sql);
+
+    sqlparser::ast::StringLiteral built;
+    built.value = L"a'b";
+    sqlparser::ast::ResultColumn col;
+    col.expr = built;
+    sqlparser::ast::SelectStatement built_ast;
+    built_ast.columns.push_back(col);
+    ASSERT_EQ(sqlparser::generate(built_ast), std::wstring(L"SELECT 'a''b'"));
+
+    // ビューモード: サブクエリ・UNION の中も含めて入力バッファを参照する
+    std::wstring view_sql = L"SELECT 'it''s' FROM (SELECT 'in sub' AS v FROM s) x WHERE EXISTS (SELECT 1 FROM u WHERE (u.c = 'in exists')) UNION SELECT 'right' FROM r";
+    sqlparser::parser::ParseOptions options;
+    options.string_literal_views = true;
+    sqlparser::ast::SelectStatement view_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(view_sql, view_ast, options));
+    auto in_buffer = [&](const sqlparser::ast::StringLiteral& lit) {
+        return lit.is_view() && lit.value.empty()
+            && lit.source.data() >= view_sql.data() && lit.source.data() + lit.source.size() <= view_sql.data() + view_sql.size();
+    };
+    auto const& head = boost::get<sqlparser::ast::StringLiteral>(view_ast.columns[0].expr);
+    ASSERT_TRUE(in_buffer(head));
+    ASSERT_TRUE(head.source == L"it''s");
+    ASSERT_TRUE(head.text() == L"it's");
+    auto const& sub = boost::get<sqlparser::ast::Subquery>(view_ast.table).select.get();
+    ASSERT_TRUE(in_buffer(boost::get<sqlparser::ast::StringLiteral>(sub.columns[0].expr)));
+    auto const& exists = boost::get<sqlparser::ast::Exists>(*view_ast.where).subquery.get();
+    auto const& cond = boost::get<sqlparser::ast::BinaryOp>(*exists.where);
+    ASSERT_TRUE(in_buffer(boost::get<sqlparser::ast::StringLiteral>(cond.right)));
+    auto const& right = view_ast.unions[0].select.get();
+    ASSERT_TRUE(in_buffer(boost::get<sqlparser::ast::StringLiteral>(right.columns[0].expr)));
+    sqlparser::ast::SelectStatement owned_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(view_sql, owned_ast));
+    ASSERT_EQ(sqlparser::generate(view_ast), sqlparser::generate(owned_ast));
+    return true;
+}
+
+bool test_logical_op_flatten() {
+    // AND / OR の連鎖は深さ 1 の LogicalOp になる
+    std::wstring sql = L"SELECT * FROM t WHERE (a = 1) OR (a = 2) OR (a = 3) OR (a = 4) AND (b = 5) AND ((c = 6) AND (d = 7))";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    auto* or_op = boost::get<sqlparser::ast::LogicalOp>(&(*ast.where));
+    ASSERT_TRUE(or_op != nullptr);
+    ASSERT_TRUE(or_op->op == sqlparser::ast::OpType::OR);
+    ASSERT_EQ(or_op->operands.size(), 4u);
+    // 括弧内の AND も同じノードに展開される
+    auto* and_op = boost::get<sqlparser::ast::LogicalOp>(&or_op->operands[3]);
+    ASSERT_TRUE(and_op != nullptr);
+    ASSERT_TRUE(and_op->op == sqlparser::ast::OpType::AND);
+    ASSERT_EQ(and_op->operands.size(), 4u);
+    ASSERT_EQ(sqlparser::generate(ast),
+        std::wstring(L"SELECT * FROM t WHERE ((a = 1) OR (a = 2) OR (a = 3) OR ((a = 4) AND (b = 5) AND (c = 6) AND (d = 7)))"));
+
+    // 長い OR 連鎖でも再帰が深くならない
+    std::wstring long_sql = L"SELECT * FROM t WHERE (id = 0)";
+    for (int i = 1; i < 2000; ++i) long_sql += L" OR (id = " + std::to_wstring(i) + L")";
+    sqlparser::ast::SelectStatement long_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(long_sql, long_ast));
+    auto* long_or = boost::get<sqlparser::ast::LogicalOp>(&(*long_ast.where));
+    ASSERT_TRUE(long_or != nullptr);
+    ASSERT_EQ(long_or->operands.size(), 2000u);
+    sqlparser::ast::SelectStatement reparsed;
+    ASSERT_TRUE(sqlparser::parser::parse(sqlparser::generate(long_ast), reparsed));
+
+    // add_conjunct は既存の AND ノードに追加する
+    sqlparser::ast::SelectStatement filtered;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM t WHERE (a = 1) AND (b = 2)", filtered));
+    sqlparser::ast::add_conjunct(filtered.where, sqlparser::Identifier(L"c"));
+    sqlparser::ast::add_conjunct(filtered.where, sqlparser::Identifier(L"d"));
+    auto* conj = boost::get<sqlparser::ast::LogicalOp>(&(*filtered.where));
+    ASSERT_TRUE(conj != nullptr);
+    ASSERT_EQ(conj->operands.size(), 4u);
+    ASSERT_EQ(sqlparser::generate(filtered), std::wstring(L"SELECT * FROM t WHERE ((a = 1) AND (b = 2) AND c AND d)"));
+
+    // WHERE が無ければそのまま設定される
+    sqlparser::ast::SelectStatement empty;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM t", empty));
+    sqlparser::ast::add_conjunct(empty.where, sqlparser::Identifier(L"c"));
+    ASSERT_TRUE(boost::get<sqlparser::Identifier>(&(*empty.where)) != nullptr);
+    return true;
+}
+
+bool test_cast_type_catalog() {
+    using sqlparser::TypeId;
+    std::wstring sql = L"SELECT CAST(a AS varchar2(20)), b::VARCHAR(10), c::int4, d::interval day to second, "
+                       L"e::numeric(10, 2)[][], f::timestamp(3) with time zone, g::double precision AS g2, h::my_schema.my_type FROM t";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    auto cast_at = [&](size_t i) { return boost::get<sqlparser::ast::Cast>(ast.columns[i].expr); };
+
+    // VARCHAR2 は VARCHAR に食われず、カタログにない型として綴りごと保持される
+    ASSERT_TRUE(cast_at(0).type.id == TypeId::UNKNOWN);
+    ASSERT_TRUE(cast_at(0).type_name == L"varchar2(20)");
+    ASSERT_EQ(cast_at(0).type.precision, 20);
+
+    ASSERT_TRUE(cast_at(1).type.id == TypeId::CHARACTER_VARYING);
+    ASSERT_EQ(cast_at(1).type.precision, 10);
+    ASSERT_TRUE(cast_at(2).type.id == TypeId::INTEGER);
+    ASSERT_TRUE(cast_at(3).type.id == TypeId::INTERVAL);
+    ASSERT_TRUE(cast_at(3).type_name == L"interval day to second");
+
+    auto numeric = cast_at(4).type;
+    ASSERT_TRUE(numeric.id == TypeId::NUMERIC);
+    ASSERT_EQ(numeric.precision, 10);
+    ASSERT_EQ(numeric.scale, 2);
+    ASSERT_EQ(static_cast<int>(numeric.array_dims), 2);
+
+    auto timestamptz = cast_at(5).type;
+    ASSERT_TRUE(timestamptz.id == TypeId::TIMESTAMP_WITH_TIME_ZONE);
+    ASSERT_EQ(timestamptz.precision, 3);
+    ASSERT_TRUE(cast_at(6).type.id == TypeId::DOUBLE_PRECISION);
+    ASSERT_TRUE(ast.columns[6].alias && *ast.columns[6].alias == L"g2");
+    ASSERT_TRUE(cast_at(7).type.id == TypeId::UNKNOWN);
+    ASSERT_TRUE(cast_at(7).type_name == L"my_schema.my_type");
+
+    // エイリアスは同じ TypeId に解決される
+    ASSERT_TRUE(sqlparser::find_type(L"INT") == TypeId::INTEGER);
+    ASSERT_TRUE(sqlparser::find_type(L"timestamptz") == TypeId::TIMESTAMP_WITH_TIME_ZONE);
+    ASSERT_TRUE(sqlparser::find_type(L"time without time zone") == TypeId::TIME);
+    ASSERT_TRUE(sqlparser::find_type(L"varchar2") == TypeId::UNKNOWN);
+    ASSERT_TRUE(sqlparser::canonical_type_name(TypeId::BIGINT) == L"bigint");
+
+    // 型名は入力の綴りのまま出力される
+    ASSERT_EQ(sqlparser::generate(ast),
+        std::wstring(L"SELECT CAST(a AS varchar2(20)), CAST(b AS VARCHAR(10)), CAST(c AS int4), CAST(d AS interval day to second), "
+                     L"CAST(e AS numeric(10, 2)[][]), CAST(f AS timestamp(3) with time zone), CAST(g AS double precision) AS g2, CAST(h AS my_schema.my_type) FROM t"));
+    return true;
+}
+
+bool test_structural_compare() {
+    auto parse = [](const std::wstring& sql) {
+        sqlparser::ast::SelectStatement ast;
+        sqlparser::parser::parse(sql, ast);
+        return ast;
+    };
+    auto a = parse(L"SELECT id, CASE WHEN (x > 1) THEN 'a''b' ELSE 'c' END AS k FROM t u WHERE (id IN (1, 2, 3)) AND (c::int4 = 1) ORDER BY id");
+    auto b = parse(L"SELECT id, CASE WHEN (x > 1) THEN 'a''b' ELSE 'c' END AS k FROM t u WHERE (id IN (1, 2, 3)) AND (c::integer = 1) ORDER BY id");
+    auto c = parse(L"SELECT id, CASE WHEN (x > 2) THEN 'z' ELSE 'c' END AS k FROM t u WHERE (id IN (7, 8, 9)) AND (c::int4 = 5) ORDER BY id");
+    auto d = parse(L"SELECT id, CASE WHEN (x > 1) THEN 'a''b' ELSE 'c' END AS k FROM t u WHERE (id IN (1, 2, 3)) AND (c::int4 = 1) ORDER BY id DESC");
+    ASSERT_TRUE(sqlparser::structural_equal(a, b));
+    ASSERT_EQ(sqlparser::structural_hash(a), sqlparser::structural_hash(b));
+    ASSERT_TRUE(!sqlparser::structural_equal(a, c));
+    ASSERT_TRUE(!sqlparser::structural_equal(a, d));
+
+    // リテラルを無視すると値だけが異なるクエリは等しい
+    sqlparser::CompareOptions ignore;
+    ignore.ignore_literals = true;
+    ASSERT_TRUE(sqlparser::structural_equal(a, c, ignore));
+    ASSERT_EQ(sqlparser::structural_hash(a, ignore), sqlparser::structural_hash(c, ignore));
+    ASSERT_TRUE(!sqlparser::structural_equal(a, d, ignore));
+
+    // IN リストの格納形式とビューモードの違いは無視される
+    sqlparser::ast::In built;
+    built.expr = sqlparser::Identifier(L"id");
+    built.not_in = false;
+    built.values = { sqlparser::ast::IntLiteral(1), sqlparser::ast::IntLiteral(2), sqlparser::ast::IntLiteral(3) };
+    auto const& parsed_in = boost::get<sqlparser::ast::LogicalOp>(*a.where).operands[0];
+    ASSERT_TRUE(sqlparser::structural_equal(parsed_in, sqlparser::ast::Expression(built)));
+    ASSERT_EQ(sqlparser::structural_hash(parsed_in), sqlparser::structural_hash(sqlparser::ast::Expression(built)));
+
+    std::wstring sql = L"SELECT 'it''s' FROM t WHERE (name IN ('O''Brien', 'x'))";
+    sqlparser::parser::ParseOptions options;
+    options.string_literal_views = true;
+    sqlparser::ast::SelectStatement view_ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, view_ast, options));
+    auto owned_ast = parse(sql);
+    ASSERT_TRUE(sqlparser::structural_equal(view_ast, owned_ast));
+    ASSERT_EQ(sqlparser::structural_hash(view_ast), sqlparser::structural_hash(owned_ast));
+    sqlparser::ast::StringLiteral other;
+    other.value = L"its";
+    ASSERT_TRUE(!sqlparser::structural_equal(view_ast.columns[0].expr, sqlparser::ast::Expression(other)));
+
+    // AST をキーにした重複排除
+    std::unordered_map<sqlparser::ast::SelectStatement, int, sqlparser::StructuralHasher, sqlparser::StructuralEqualTo> seen;
+    for (auto const* s : { &a, &b, &c, &d }) ++seen[*s];
+    ASSERT_EQ(seen.size(), 3u);
+    return true;
+}
+
+bool test_shared_subexpressions() {
+    std::wstring bucket = L"CASE WHEN (amount > 1000) THEN 'large' WHEN (amount > 100) THEN 'medium' ELSE 'small' END";
+    std::wstring sql = L"SELECT " + bucket + L" AS bucket, SUM(amount) FROM orders GROUP BY " + bucket +
+                       L" UNION ALL SELECT " + bucket + L", SUM(amount) FROM archived GROUP BY " + bucket;
+    sqlparser::parser::ParseOptions options;
+    options.share_subexpressions = true;
+    sqlparser::ast::SelectStatement shared;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, shared, options));
+    sqlparser::ast::SelectStatement plain;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, plain));
+    ASSERT_EQ(sqlparser::generate(shared), sqlparser::generate(plain));
+
+    // 同じ綴りの CASE 式は 1 つのノードを共有する (UNION の右側も含む)
+    const sqlparser::ast::SelectStatement& cs = shared;
+    const sqlparser::ast::SelectStatement& right = cs.unions[0].select.get();
+    auto const* first = boost::get<sqlparser::ast::Case>(&cs.columns[0].expr);
+    ASSERT_TRUE(first != nullptr);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&cs.groupBy[0]) == first);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&right.columns[0].expr) == first);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&right.groupBy[0]) == first);
+    const sqlparser::ast::SelectStatement& cp = plain;
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&cp.groupBy[0]) != boost::get<sqlparser::ast::Case>(&cp.columns[0].expr));
+
+    // 項目の一部・WHERE の中の部分木も構造が等しければ共有する
+    sqlparser::ast::SelectStatement partial;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT (a + b) AS s, (a + b) * 2 AS t FROM x WHERE a + b > 1", partial, options));
+    ASSERT_EQ(sqlparser::generate(partial), std::wstring(L"SELECT (a + b) AS s, ((a + b) * 2) AS t FROM x WHERE ((a + b) > 1)"));
+    const sqlparser::ast::SelectStatement& cpartial = partial;
+    auto const* sum = boost::get<sqlparser::ast::BinaryOp>(&cpartial.columns[0].expr);
+    ASSERT_TRUE(sum != nullptr);
+    ASSERT_TRUE(boost::get<sqlparser::ast::BinaryOp>(&boost::get<sqlparser::ast::BinaryOp>(cpartial.columns[1].expr).left) == sum);
+    ASSERT_TRUE(boost::get<sqlparser::ast::BinaryOp>(&boost::get<sqlparser::ast::BinaryOp>(*cpartial.where).left) == sum);
+
+    // 空白・キーワードの大文字小文字・括弧だけが異なる項目も共有する
+    sqlparser::ast::SelectStatement spelled;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT CASE WHEN a > 1 THEN 'x' END AS p, case  when (a>1) then 'x' end AS q FROM t", spelled, options));
+    const sqlparser::ast::SelectStatement& cspelled = spelled;
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&cspelled.columns[0].expr) == boost::get<sqlparser::ast::Case>(&cspelled.columns[1].expr));
+
+    // 共有されたノードを変更しても他の出現箇所には影響しない (書き込み時に複製される)
+    boost::get<sqlparser::ast::Case>(shared.groupBy[0]).else_result = sqlparser::ast::Expression(sqlparser::Identifier(L"other"));
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&cs.groupBy[0]) != first);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&cs.columns[0].expr) == first);
+    std::wstring expected = sqlparser::generate(plain);
+    std::wstring changed = sqlparser::generate(shared);
+    ASSERT_TRUE(changed != expected);
+    ASSERT_EQ(std::count(changed.begin(), changed.end(), L'\''), std::count(expected.begin(), expected.end(), L'\'') - 2);
+
+    // CAST の型名の綴りが異なる式はまとめない (同じ型に解決されても綴りどおりに出力する)
+    sqlparser::ast::SelectStatement casts;
+    const std::wstring cast_sql = L"SELECT CAST(x AS int4) AS a, CAST(x AS integer) AS b, CAST(x AS int4) AS c FROM t";
+    ASSERT_TRUE(sqlparser::parser::parse(cast_sql, casts, options));
+    ASSERT_EQ(sqlparser::generate(casts), std::wstring(cast_sql));
+    const sqlparser::ast::SelectStatement& ccasts = casts;
+    ASSERT_TRUE(boost::get<sqlparser::ast::Cast>(&ccasts.columns[0].expr) != boost::get<sqlparser::ast::Cast>(&ccasts.columns[1].expr));
+    ASSERT_TRUE(boost::get<sqlparser::ast::Cast>(&ccasts.columns[0].expr) == boost::get<sqlparser::ast::Cast>(&ccasts.columns[2].expr));
+
+    // 通常の AST のコピーは深いコピー。共有表のノード (凍結されたノード) のコピーはノードを共有し、変更した側だけが複製される
+    sqlparser::ast::Expression deep = plain.columns[0].expr;
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(deep))
+                != boost::get<sqlparser::ast::Case>(&cp.columns[0].expr));
+    sqlparser::ast::Expression a = shared.columns[0].expr;
+    sqlparser::ast::Expression b = a;
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(a))
+                == boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(b)));
+    boost::get<sqlparser::ast::Case>(b).when_clauses.pop_back();
+    ASSERT_EQ(boost::get<sqlparser::ast::Case>(a).when_clauses.size(), 2u);
+    ASSERT_EQ(boost::get<sqlparser::ast::Case>(b).when_clauses.size(), 1u);
+
+    // 非 const の参照を取り出した後に持ち主をコピーしても、その参照を通した変更はコピーに見えない
+    for (const sqlparser::ast::Expression& source : { plain.columns[0].expr, shared.columns[0].expr }) {
+        sqlparser::ast::Expression owner = source;
+        sqlparser::ast::Case& held = boost::get<sqlparser::ast::Case>(owner);
+        sqlparser::ast::Expression later_copy = owner;
+        held.when_clauses.pop_back();
+        ASSERT_EQ(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(later_copy))->when_clauses.size(), 2u);
+        ASSERT_EQ(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(owner))->when_clauses.size(), 1u);
+    }
+    ASSERT_EQ(boost::get<sqlparser::ast::Case>(&cs.columns[0].expr)->when_clauses.size(), 2u);
+
+    // ムーブ元はノードを共有しない
+    sqlparser::ast::Expression moved_from = shared.columns[0].expr;
+    sqlparser::ast::Expression moved_to = std::move(moved_from);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(moved_to)) == first);
+    ASSERT_TRUE(boost::get<sqlparser::ast::Case>(&static_cast<const sqlparser::ast::Expression&>(moved_from)) != first);
+    return true;
+}
+
+bool test_persistent_select() {
+    sqlparser::ast::SelectStatement parsed;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT s.id, s.name FROM shapes_a s WHERE (s.area > 50) AND (s.kind = 1) "
+                                         L"UNION SELECT t.id, t.name FROM shapes_b t WHERE t.area > 50", parsed));
+    const sqlparser::ast::PersistentSelect base(std::move(parsed));
+    const std::wstring original = sqlparser::generate(*base);
+
+    auto add_filter = [](sqlparser::ast::SelectStatement& stmt, long id) {
+        const sqlparser::ast::SelectStatement& read = stmt;
+        sqlparser::ast::BinaryOp eq;
+        eq.op = sqlparser::ast::OpType::EQ;
+        eq.left = read.columns[0].expr;
+        eq.right = sqlparser::ast::IntLiteral(static_cast<int>(id));
+        sqlparser::ast::add_conjunct(stmt.where, std::move(eq));
+    };
+    auto left_only = base.update([&](sqlparser::ast::SelectStatement& stmt) { add_filter(stmt, 7); });
+    auto both = base.update([&](sqlparser::ast::SelectStatement& stmt) {
+        add_filter(stmt, 8);
+        add_filter(stmt.unions[0].select.get(), 8);
+    });
+
+    ASSERT_EQ(original, sqlparser::generate(*base));
+    ASSERT_EQ(std::wstring(L"SELECT s.id, s.name FROM shapes_a s WHERE ((s.area > 50) AND (s.kind = 1) AND (s.id = 7)) "
+                           L"UNION SELECT t.id, t.name FROM shapes_b t WHERE (t.area > 50)"), sqlparser::generate(*left_only));
+    ASSERT_EQ(std::wstring(L"SELECT s.id, s.name FROM shapes_a s WHERE ((s.area > 50) AND (s.kind = 1) AND (s.id = 8)) "
+                           L"UNION SELECT t.id, t.name FROM shapes_b t WHERE ((t.area > 50) AND (t.id = 8))"), sqlparser::generate(*both));
+
+    // 変更の経路 (根・WHERE の論理演算・編集した UNION の右側) 以外は元の版と共有する
+    ASSERT_TRUE(!left_only.same_root(base));
+    sqlparser::ast::PersistentSelect copy = left_only;
+    ASSERT_TRUE(copy.same_root(left_only));
+    ASSERT_TRUE(&left_only->unions[0].select.get() == &base->unions[0].select.get());
+    ASSERT_TRUE(&both->unions[0].select.get() != &base->unions[0].select.get());
+    auto const* base_where = boost::get<sqlparser::ast::LogicalOp>(&*base->where);
+    auto const* variant_where = boost::get<sqlparser::ast::LogicalOp>(&*left_only->where);
+    ASSERT_TRUE(base_where != nullptr && variant_where != nullptr && base_where != variant_where);
+    ASSERT_EQ(base_where->operands.size(), 2u);
+    ASSERT_TRUE(boost::get<sqlparser::ast::BinaryOp>(&base_where->operands[0]) == boost::get<sqlparser::ast::BinaryOp>(&variant_where->operands[0]));
+    ASSERT_TRUE(boost::get<sqlparser::ast::BinaryOp>(&base_where->operands[1]) == boost::get<sqlparser::ast::BinaryOp>(&variant_where->operands[1]));
+
+    // ヒープに置かれた長い文字列もコピーではバッファを共有する
+    sqlparser::SmallString long_name(L"a_very_long_identifier_that_needs_the_heap");
+    sqlparser::SmallString shared = long_name;
+    ASSERT_TRUE(shared.shares_buffer(long_name));
+    ASSERT_TRUE(shared.data() == long_name.data());
+    return true;
+}
+
+bool test_ast_walk() {
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT a, COUNT(*) FROM t JOIN (SELECT c FROM u) s ON t.id = s.c "
+                                         L"WHERE b > 1 AND NOT EXISTS (SELECT * FROM v WHERE v.a = t.a) "
+                                         L"GROUP BY a UNION SELECT d, 1 FROM w", ast));
+
+    // const の走査: 全ての識別子を行きがけ順に数える
+    struct IdentifierCounter {
+        std::vector<std::wstring> names;
+        void enter(const sqlparser::Identifier& id) { names.emplace_back(std::wstring_view(id)); }
+    } counter;
+    const sqlparser::ast::SelectStatement& cast = ast;
+    ASSERT_TRUE(sqlparser::ast::walk(cast, counter));
+    std::vector<std::wstring> expected = { L"a", L"*", L"c", L"t.id", L"s.c", L"b", L"*", L"v.a", L"t.a", L"a", L"d" };
+    ASSERT_TRUE(counter.names == expected);
+
+    // Skip: サブクエリ (最上位以外の SELECT 文) に入らない
+    struct TopLevelOnly {
+        int depth = 0;
+        int identifiers = 0;
+        sqlparser::ast::Visit enter(const sqlparser::ast::SelectStatement&) {
+            return depth++ == 0 ? sqlparser::ast::Visit::Continue : sqlparser::ast::Visit::Skip;
+        }
+        void enter(const sqlparser::Identifier&) { ++identifiers; }
+    } top;
+    sqlparser::ast::walk(cast, top);
+    ASSERT_EQ(top.identifiers, 6);
+
+    // Stop: 最初の関数呼び出しで打ち切る
+    struct FindFunction {
+        const sqlparser::ast::FunctionCall* found = nullptr;
+        sqlparser::ast::Visit enter(const sqlparser::ast::FunctionCall& f) {
+            found = &f;
+            return sqlparser::ast::Visit::Stop;
+        }
+    } finder;
+    ASSERT_TRUE(!sqlparser::ast::walk(cast, finder));
+    ASSERT_TRUE(finder.found != nullptr && finder.found->name == L"COUNT");
+
+    // 非 const の走査: 帰りがけ順で x + 0 を x に、識別子 a を alias_a にその場で置き換える
+    sqlparser::ast::SelectStatement rewrite;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT (a + 0) + 0, b FROM t WHERE a + 0 > 1 ORDER BY a", rewrite));
+    struct Simplify {
+        void leave_expression(sqlparser::ast::Expression& e) {
+            auto* op = boost::get<sqlparser::ast::BinaryOp>(&e);
+            if (!op || op->op != sqlparser::ast::OpType::ADD) return;
+            auto* zero = boost::get<sqlparser::ast::IntLiteral>(&op->right);
+            if (zero && zero->text == L"0") {
+                sqlparser::ast::Expression left = std::move(op->left);
+                e = std::move(left);
+            }
+        }
+        void enter(sqlparser::Identifier& id) {
+            if (id == L"a") id = sqlparser::Identifier(L"alias_a");
+        }
+        void enter(sqlparser::ast::OrderByElement& o) {
+            if (o.column == L"a") o.column = sqlparser::Identifier(L"alias_a");
+        }
+    };
+    ASSERT_TRUE(sqlparser::ast::walk(rewrite, Simplify{}));
+    ASSERT_EQ(std::wstring(L"SELECT alias_a, b FROM t WHERE (alias_a > 1) ORDER BY alias_a"), sqlparser::generate(rewrite));
+
+    // enter_expression で置き換えた式は置き換え後の内容を走査する
+    sqlparser::ast::Expression expr = sqlparser::Identifier(L"x");
+    struct Expand {
+        int literals = 0;
+        void enter_expression(sqlparser::ast::Expression& e) {
+            if (boost::get<sqlparser::Identifier>(&e)) {
+                sqlparser::ast::BinaryOp op{ sqlparser::ast::OpType::ADD, sqlparser::ast::IntLiteral(1), sqlparser::ast::IntLiteral(2) };
+                e = std::move(op);
+            }
+        }
+        void enter(sqlparser::ast::IntLiteral&) { ++literals; }
+    } expand;
+    sqlparser::ast::walk(expr, expand);
+    ASSERT_EQ(expand.literals, 2);
+    auto const* plus = boost::get<sqlparser::ast::BinaryOp>(&expr);
+    ASSERT_TRUE(plus != nullptr && plus->op == sqlparser::ast::OpType::ADD);
+    return true;
+}
+
+bool test_predicate_injection() {
+    using namespace sqlparser::ast;
+    using sqlparser::Identifier;
+
+    // 既存の WHERE はムーブされ、ノードは複製されない
+    SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT id FROM t WHERE a = 1 OR b = 2", ast));
+    const SelectStatement& view = ast;
+    auto const* original = boost::get<LogicalOp>(&*view.where);
+    ASSERT_TRUE(original != nullptr);
+    and_where(ast, BinaryOp{ OpType::GT, Identifier(L"c"), IntLiteral(3) });
+    auto const* conj = boost::get<LogicalOp>(&*view.where);
+    ASSERT_TRUE(conj != nullptr && conj->op == OpType::AND && conj->operands.size() == 2);
+    ASSERT_TRUE(boost::get<LogicalOp>(&conj->operands[0]) == original);
+    and_where(ast, BinaryOp{ OpType::LT, Identifier(L"d"), IntLiteral(4) });
+    ASSERT_TRUE(boost::get<LogicalOp>(&*view.where) == conj);
+    ASSERT_EQ(conj->operands.size(), 3u);
+    ASSERT_EQ(std::wstring(L"SELECT id FROM t WHERE (((a = 1) OR (b = 2)) AND (c > 3) AND (d < 4))"), sqlparser::generate(ast));
+
+    // UNION の全ブランチと HAVING
+    SelectStatement u;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT k, COUNT(*) FROM a GROUP BY k UNION ALL SELECT k, COUNT(*) FROM b WHERE x = 1 GROUP BY k", u));
+    and_where(u, BinaryOp{ OpType::EQ, Identifier(L"tenant"), IntLiteral(7) }, UnionScope::All);
+    and_having(u, BinaryOp{ OpType::GT, FunctionCall{ Identifier(L"COUNT"), { Identifier(L"*") } }, IntLiteral(1) });
+    ASSERT_EQ(std::wstring(L"SELECT k, COUNT(*) FROM a WHERE (tenant = 7) GROUP BY k HAVING (COUNT(*) > 1) "
+                           L"UNION ALL SELECT k, COUNT(*) FROM b WHERE ((x = 1) AND (tenant = 7)) GROUP BY k"), sqlparser::generate(u));
+
+    // JOIN の ON
+    SelectStatement j;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM a JOIN b ON a.id = b.id CROSS JOIN c LEFT JOIN d USING (id), e", j));
+    ASSERT_TRUE(and_join_on(j, 0, BinaryOp{ OpType::EQ, Identifier(L"b.tenant"), IntLiteral(1) }));
+    ASSERT_TRUE(and_join_on(j, 1, BinaryOp{ OpType::EQ, Identifier(L"c.tenant"), IntLiteral(1) }));
+    ASSERT_TRUE(!and_join_on(j, 2, BinaryOp{ OpType::EQ, Identifier(L"d.tenant"), IntLiteral(1) }));
+    ASSERT_TRUE(!and_join_on(j, 3, BinaryOp{ OpType::EQ, Identifier(L"e.tenant"), IntLiteral(1) }));
+    ASSERT_TRUE(!and_join_on(j, 4, BinaryOp{ OpType::EQ, Identifier(L"f.tenant"), IntLiteral(1) }));
+    ASSERT_EQ(std::wstring(L"SELECT * FROM a INNER JOIN b ON ((a.id = b.id) AND (b.tenant = 1)) INNER JOIN c ON (c.tenant = 1) "
+                           L"LEFT JOIN d USING (id), e"), sqlparser::generate(j));
+
+    // 先頭カラムの条件: 使えないブランチがあれば何も変更しない
+    SelectStatement f;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT s.id AS sid, name FROM s UNION SELECT COUNT(*), 'x' FROM t", f));
+    std::wstring before = sqlparser::generate(f);
+    ASSERT_TRUE(first_column_expression(f) != nullptr);
+    ASSERT_TRUE(!and_where_first_column(f, OpType::EQ, IntLiteral(5)));
+    ASSERT_EQ(before, sqlparser::generate(f));
+    ASSERT_TRUE(and_where_first_column(f, OpType::EQ, IntLiteral(5), UnionScope::First));
+    ASSERT_EQ(std::wstring(L"SELECT s.id AS sid, name FROM s WHERE (s.id = 5) UNION SELECT COUNT(*), 'x' FROM t"), sqlparser::generate(f));
+
+    SelectStatement star;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM t", star));
+    ASSERT_TRUE(first_column_expression(star) == nullptr);
+    ASSERT_TRUE(!and_where_first_column(star, OpType::EQ, IntLiteral(5)));
+
+    // 集約関数・ウィンドウ関数は式の中にあっても WHERE に使えない
+    for (const wchar_t* sql : { L"SELECT SUM(x) + 1 AS s FROM t", L"SELECT COALESCE(MAX(x), 0) FROM t",
+                                L"SELECT ROW_NUMBER() OVER (ORDER BY id) + 1 FROM t", L"SELECT 1 - RANK() OVER (PARTITION BY g) FROM t" }) {
+        SelectStatement s;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, s));
+        ASSERT_TRUE(first_column_expression(s) == nullptr);
+        ASSERT_TRUE(!and_where_first_column(s, OpType::EQ, IntLiteral(5)));
+    }
+    SelectStatement nested;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT UPPER(code) FROM t", nested));
+    ASSERT_TRUE(first_column_expression(nested) != nullptr);
+    return true;
+}
+
+bool test_row_security_policy() {
+    sqlparser::RowSecurityPolicy policy;
+    ASSERT_TRUE(policy.add(L"orders", L"tenant_id = 42"));
+    ASSERT_TRUE(policy.add(L"sales.customers", L"tenant_id = 42 AND deleted = FALSE"));
+    ASSERT_TRUE(!policy.add(L"broken", L"tenant_id = "));
+    ASSERT_EQ(policy.size(), 2u);
+
+    // FROM・INNER JOIN は WHERE、LEFT JOIN の結合先は ON、派生テーブル・EXISTS・UNION の各ブランチも対象
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(
+        L"SELECT o.id FROM orders o JOIN SALES.CUSTOMERS c ON o.cid = c.id LEFT JOIN orders o2 ON o2.parent = o.id "
+        L"WHERE EXISTS (SELECT 1 FROM orders WHERE orders.cid = c.id) "
+        L"UNION SELECT x.id FROM (SELECT id FROM orders) x", ast));
+    ASSERT_EQ(policy.apply(ast), 5u);
+    ASSERT_EQ(std::wstring(L"SELECT o.id FROM orders o INNER JOIN SALES.CUSTOMERS c ON (o.cid = c.id) "
+                           L"LEFT JOIN orders o2 ON ((o2.parent = o.id) AND (o2.tenant_id = 42)) "
+                           L"WHERE (EXISTS (SELECT 1 FROM orders WHERE ((orders.cid = c.id) AND (orders.tenant_id = 42))) "
+                           L"AND (o.tenant_id = 42) AND ((c.tenant_id = 42) AND (c.deleted = FALSE))) "
+                           L"UNION SELECT x.id FROM (SELECT id FROM orders WHERE (orders.tenant_id = 42)) x"),
+              sqlparser::generate(ast));
+
+    // RIGHT / FULL JOIN で NULL で補われる側は派生テーブルに置き換える
+    sqlparser::ast::SelectStatement outer;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM orders a RIGHT JOIN orders b ON a.id = b.id FULL JOIN sales.customers ON b.cid = customers.id", outer));
+    ASSERT_EQ(policy.apply(outer), 3u);
+    ASSERT_EQ(std::wstring(L"SELECT * FROM (SELECT * FROM orders a WHERE (a.tenant_id = 42)) a "
+                           L"RIGHT JOIN (SELECT * FROM orders b WHERE (b.tenant_id = 42)) b ON (a.id = b.id) "
+                           L"FULL JOIN (SELECT * FROM sales.customers WHERE ((sales.customers.tenant_id = 42) AND (sales.customers.deleted = FALSE))) customers "
+                           L"ON (b.cid = customers.id)"),
+              sqlparser::generate(outer));
+
+    // 登録されていないテーブルだけなら何も変更しない
+    sqlparser::ast::SelectStatement other;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT * FROM products", other));
+    ASSERT_EQ(policy.apply(other), 0u);
+    ASSERT_EQ(std::wstring(L"SELECT * FROM products"), sqlparser::generate(other));
+    return true;
+}
+
+bool test_sql_template() {
+    const std::wstring sql = L"SELECT s.id AS shape_id, name FROM shapes_a s WHERE area > 50 UNION SELECT shape_id, name FROM shapes_b";
+    sqlparser::SqlTemplate tmpl;
+    ASSERT_TRUE(sqlparser::compile_id_filter(sql, tmpl));
+    ASSERT_EQ(tmpl.parameter_count(), 1u);
+
+    // 毎回パースして書き換えた結果と同じ SQL になる
+    for (int64_t id : { int64_t(0), int64_t(7), int64_t(-12), int64_t(9007199254740993) }) {
+        sqlparser::ast::SelectStatement ast;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+        ASSERT_TRUE(sqlparser::ast::and_where_first_column(ast, sqlparser::ast::OpType::EQ, sqlparser::ast::IntLiteral(id)));
+        ASSERT_EQ(sqlparser::generate(ast), tmpl.render(id));
+    }
+
+    // 出力先のバッファは再利用できる
+    std::wstring out;
+    ASSERT_TRUE(tmpl.render({ 42 }, out));
+    ASSERT_EQ(std::wstring(L"SELECT s.id AS shape_id, name FROM shapes_a s WHERE ((area > 50) AND (s.id = 42)) "
+                           L"UNION SELECT shape_id, name FROM shapes_b WHERE (shape_id = 42)"), out);
+    ASSERT_TRUE(!tmpl.render(nullptr, 0, out));
+
+    // 複数のパラメータ
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(L"SELECT id FROM t", ast));
+    sqlparser::ast::and_where(ast, sqlparser::ast::Between{ sqlparser::Identifier(L"id"), sqlparser::placeholder(0), sqlparser::placeholder(1), false });
+    ast.limit = sqlparser::ast::Expression(sqlparser::placeholder(1));
+    ASSERT_TRUE(tmpl.compile(ast));
+    ASSERT_EQ(tmpl.parameter_count(), 2u);
+    ASSERT_TRUE(tmpl.render({ 10, 20 }, out));
+    ASSERT_EQ(std::wstring(L"SELECT id FROM t WHERE (id BETWEEN 10 AND 20) LIMIT 20"), out);
+
+    // 先頭カラムが使えない場合はテンプレートを作らない
+    ASSERT_TRUE(!sqlparser::compile_id_filter(L"SELECT * FROM t", tmpl));
+    return true;
+}
+
+bool test_rewrite_rules() {
+    namespace rw = sqlparser::rewrite;
+    using sqlparser::ast::OpType;
+    rw::RuleSet rules;
+    // 非推奨の関数の置き換え (引数が 2 つの場合のみ)
+    rules.add(rw::function(L"NVL", { rw::any(), rw::any() }), rw::rename_function(L"COALESCE"));
+    // NOT NOT x → x
+    rules.add(rw::unary(OpType::NOT, rw::unary(OpType::NOT, rw::any().as(0))), rw::replace_with(0));
+    // UPPER(UPPER(x)) → UPPER(x)
+    rules.add(rw::function(L"UPPER", { rw::function(L"UPPER", { rw::any() }).as(0) }), rw::replace_with(0));
+    // CAST の型名を正規名にする
+    rules.add(rw::cast(sqlparser::TypeId::INTEGER), [](sqlparser::ast::Expression& node, const rw::Match&) {
+        auto& c = boost::get<sqlparser::ast::Cast>(node);
+        if (c.type_name.view() == sqlparser::canonical_type_name(c.type.id)) return false;
+        c.type_name = sqlparser::canonical_type_name(c.type.id);
+        return true;
+    });
+    // 無関係な規則を大量に登録しても結果は変わらない
+    for (int i = 0; i < 200; ++i) {
+        rules.add(rw::function(L"LEGACY_FN" + std::to_wstring(i)), rw::rename_function(L"FN" + std::to_wstring(i)));
+    }
+
+    auto rewrite = [&](const std::wstring& sql, size_t& count) {
+        sqlparser::ast::SelectStatement ast;
+        if (!sqlparser::parser::parse(sql, ast)) return std::wstring(L"<parse error>");
+        count = rules.apply(ast);
+        return sqlparser::generate(ast);
+    };
+
+    size_t count = 0;
+    // 入れ子は子から書き換わる
+    ASSERT_EQ(std::wstring(L"SELECT COALESCE(COALESCE(a, b), c) FROM t"), rewrite(L"SELECT NVL(NVL(a, b), c) FROM t", count));
+    ASSERT_EQ(count, 2u);
+    // 引数の数が合わなければ書き換えない
+    ASSERT_EQ(std::wstring(L"SELECT NVL(a) FROM t"), rewrite(L"SELECT NVL(a) FROM t", count));
+    ASSERT_EQ(count, 0u);
+    // 同じノードで不動点まで適用する
+    ASSERT_EQ(std::wstring(L"SELECT UPPER(name) FROM t"), rewrite(L"SELECT UPPER(UPPER(UPPER(name))) FROM t", count));
+    ASSERT_EQ(count, 2u);
+    // 置き換えで現れたノードにも規則を適用する (NOT NOT の中の NVL、EXISTS の中も対象)
+    ASSERT_EQ(std::wstring(L"SELECT id FROM t WHERE EXISTS (SELECT 1 FROM u WHERE (COALESCE(u.x, 0) = CAST(t.y AS integer)))"),
+              rewrite(L"SELECT id FROM t WHERE EXISTS (SELECT 1 FROM u WHERE NVL(u.x, 0) = CAST(t.y AS int4))", count));
+    ASSERT_EQ(count, 2u);
+    ASSERT_EQ(std::wstring(L"SELECT legacy(a), FN7(b) FROM t WHERE (COALESCE(a, b) IS NULL)"),
+              rewrite(L"SELECT legacy(a), legacy_fn7(b) FROM t WHERE NOT NOT NVL(a, b) IS NULL", count));
+    // 規則が作ったノードには適用し、そこへ移した処理済みの子には適用し直さない
+    // (IFNULL0(x) → NVL(x, 0) の NVL は書き換わり、x の中の UPPER(UPPER(...)) は 1 回だけ数える)
+    rules.add(rw::function(L"IFNULL0", { rw::any().as(0) }), [](sqlparser::ast::Expression& node, const rw::Match& m) {
+        sqlparser::ast::FunctionCall call;
+        call.name = sqlparser::Identifier(L"NVL");
+        call.args.push_back(std::move(const_cast<sqlparser::ast::Expression&>(m[0])));
+        call.args.push_back(sqlparser::ast::IntLiteral{ L"0" });
+        node = std::move(call);
+        return true;
+    });
+    ASSERT_EQ(std::wstring(L"SELECT COALESCE(UPPER(name), 0) FROM t"), rewrite(L"SELECT IFNULL0(UPPER(UPPER(name))) FROM t", count));
+    ASSERT_EQ(count, 3u);
+    // 2 回目の apply は前回の印に影響されず、全てのノードを試す
+    {
+        sqlparser::ast::SelectStatement ast;
+        ASSERT_TRUE(sqlparser::parser::parse(L"SELECT NVL(NVL(a, b), c) FROM t", ast));
+        ASSERT_EQ(rules.apply(ast), 2u);
+        auto& call = boost::get<sqlparser::ast::FunctionCall>(ast.columns[0].expr);
+        call.name = sqlparser::Identifier(L"NVL");
+        boost::get<sqlparser::ast::FunctionCall>(call.args[0]).name = sqlparser::Identifier(L"NVL");
+        ASSERT_EQ(rules.apply(ast), 2u);
+        ASSERT_EQ(std::wstring(L"SELECT COALESCE(COALESCE(a, b), c) FROM t"), sqlparser::generate(ast));
+    }
+
+    // 式単体にも適用できる
+    sqlparser::ast::Expression expr;
+    ASSERT_TRUE(sqlparser::parser::parse_expression(L"NOT NOT NOT NOT x", expr));
+    ASSERT_EQ(rules.apply(expr), 2u);
+    ASSERT_TRUE(boost::get<sqlparser::Identifier>(&expr) != nullptr);
+
+    // 互いに打ち消し合う規則でも停止する
+    rw::RuleSet cycle;
+    cycle.add(rw::function(L"F"), rw::rename_function(L"G"));
+    cycle.add(rw::function(L"G"), rw::rename_function(L"F"));
+    ASSERT_TRUE(sqlparser::parser::parse_expression(L"F(1)", expr));
+    ASSERT_EQ(cycle.apply(expr), rw::RuleSet::max_rounds);
+    return true;
+}
+
+bool test_simplify() {
+    auto simplified = [](const std::wstring& sql, size_t& count) {
+        sqlparser::ast::SelectStatement ast;
+        if (!sqlparser::parser::parse(sql, ast)) return std::wstring(L"<parse error>");
+        count = sqlparser::ast::simplify(ast);
+        return sqlparser::generate(ast);
+    };
+    size_t count = 0;
+    // 恒真の条件は WHERE ごと消える
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t"), simplified(L"SELECT a FROM t WHERE 1 = 1 AND TRUE", count));
+    ASSERT_EQ(count, 3u);
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE (x > 5)"), simplified(L"SELECT a FROM t WHERE 1 = 1 AND x > 2 + 3", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE FALSE"), simplified(L"SELECT a FROM t WHERE x = 1 AND 2 < 1.5", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE ((x = 1) OR (y = 2) OR (z = 3))"),
+              simplified(L"SELECT a FROM t WHERE x = 1 OR (y = 2 OR FALSE OR z = 3)", count));
+    // NOT の吸収
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE (b AND (c <> 1) AND (d IS NOT NULL) AND (e NOT BETWEEN 1 AND 2))"),
+              simplified(L"SELECT a FROM t WHERE NOT NOT b AND NOT (c = 1) AND NOT (d IS NULL) AND NOT (e BETWEEN 1 AND 2)", count));
+    // 退化した IN / BETWEEN
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE ((x = 3) AND (y <> 'v') AND (z = k))"),
+              simplified(L"SELECT a FROM t WHERE x IN (3) AND y NOT IN ('v') AND z BETWEEN k AND k", count));
+    // 整数の演算 (オーバーフローと除算、^ は畳み込まない)、単項マイナス
+    ASSERT_EQ(std::wstring(L"SELECT 7, -5, (7 / 2), (9223372036854775807 + 1), 1, (2 ^ 3), 3 FROM t"),
+              simplified(L"SELECT 1 + 2 * 3, -5, 7 / 2, 9223372036854775807 + 1, 7 % 3, 2 ^ 3, 1 | 2 FROM t", count));
+    // CASE と IS NULL、サブクエリ内、INNER JOIN ... ON TRUE
+    ASSERT_EQ(std::wstring(L"SELECT 'yes' FROM t CROSS JOIN u WHERE EXISTS (SELECT 1 FROM v WHERE (v.id = t.id))"),
+              simplified(L"SELECT CASE WHEN 1 > 2 THEN 'no' WHEN NULL IS NULL THEN 'yes' ELSE 'else' END FROM t JOIN u ON 1 = 1 "
+                         L"WHERE EXISTS (SELECT 1 FROM v WHERE v.id = t.id AND 'x' IS NOT NULL)", count));
+    // LEFT JOIN の ON TRUE はそのまま (結合の種類を変えられない)
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t LEFT JOIN u ON TRUE"), simplified(L"SELECT a FROM t LEFT JOIN u ON 1 = 1", count));
+    // 数値の比較は綴りの 10 進のまま行う (double に丸めると等しくなる値も区別する)
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE FALSE"), simplified(L"SELECT a FROM t WHERE 0.30000000000000001 = 0.3", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE x"), simplified(L"SELECT a FROM t WHERE 1.00000000000000001 <> 1 AND x", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE x"),
+              simplified(L"SELECT a FROM t WHERE 9007199254740993.0 > 9007199254740992 AND x", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t"),
+              simplified(L"SELECT a FROM t WHERE 1.50 = 1.5 AND 0.0 = -0 AND 100 = 1.0e2 AND -2.5 < -2 AND 1.2e0 > 1.19", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t WHERE FALSE"),
+              simplified(L"SELECT a FROM t WHERE 99999999999999999999 < 99999999999999999998", count));
+    // GROUP BY も集約もない HAVING は全体を 1 グループにするため、HAVING TRUE でも残す
+    ASSERT_EQ(std::wstring(L"SELECT 1 FROM t HAVING TRUE"), simplified(L"SELECT 1 FROM t HAVING 1 = 1", count));
+    ASSERT_EQ(std::wstring(L"SELECT COUNT(*) FROM t"), simplified(L"SELECT COUNT(*) FROM t HAVING 1 = 1", count));
+    ASSERT_EQ(std::wstring(L"SELECT a FROM t GROUP BY a"), simplified(L"SELECT a FROM t GROUP BY a HAVING TRUE", count));
+
+    // 書き換えのない木は変えない
+    const std::wstring plain = L"SELECT a, COUNT(*) FROM t WHERE ((x = 1) AND (y LIKE 'a%')) GROUP BY a HAVING (COUNT(*) > 1)";
+    ASSERT_EQ(plain, simplified(plain, count));
+    ASSERT_EQ(count, 0u);
+
+    // 式単体
+    sqlparser::ast::Expression expr;
+    ASSERT_TRUE(sqlparser::parser::parse_expression(L"x AND (NOT NOT TRUE)", expr));
+    ASSERT_EQ(sqlparser::ast::simplify(expr), 3u);
+    ASSERT_TRUE(boost::get<sqlparser::Identifier>(&expr) && boost::get<sqlparser::Identifier>(expr) == L"x");
+    return true;
+}
+
+bool test_canonicalize() {
+    auto canonical = [](const std::wstring& sql) {
+        sqlparser::ast::SelectStatement ast;
+        if (!sqlparser::parser::parse(sql, ast)) return std::wstring(L"<parse error>");
+        sqlparser::ast::canonicalize(ast);
+        return sqlparser::generate(ast);
+    };
+    auto same_hash = [](const std::wstring& a, const std::wstring& b) {
+        sqlparser::ast::SelectStatement x, y;
+        if (!sqlparser::parser::parse(a, x) || !sqlparser::parser::parse(b, y)) return false;
+        return sqlparser::ast::canonical_hash(x) == sqlparser::ast::canonical_hash(y);
+    };
+
+    // 書き方だけが異なるクエリは同じ正規形になる
+    const std::vector<std::pair<std::wstring, std::wstring>> equivalent = {
+        { L"SELECT id FROM t WHERE a = 1 AND b = 2", L"SELECT id FROM t WHERE b = 2 AND a = 1" },
+        { L"SELECT id FROM t WHERE a = 1 AND (b = 2 AND c = 3)", L"SELECT id FROM t WHERE (c = 3 AND a = 1) AND b = 2" },
+        { L"SELECT id FROM t WHERE x > 5 OR 1 = y", L"SELECT id FROM t WHERE y = 1 OR 5 < x" },
+        { L"SELECT a + (b + c) * 2 + d FROM t", L"SELECT (d + 2 * (c + b)) + a FROM t" },
+        { L"SELECT a * b * c FROM t", L"SELECT c * (b * a) FROM t" },
+        { L"SELECT ID, Upper(Name) FROM Users U WHERE U.Age >= 20 ORDER BY ID DESC", L"SELECT id, UPPER(name) FROM users u WHERE 20 <= u.age ORDER BY id DESC" },
+        { L"SELECT id FROM t WHERE x IN (3, 1, 2) AND y IN (b, a)", L"SELECT id FROM t WHERE y IN (a, b) AND x IN (1, 2, 3)" },
+        { L"SELECT id FROM t WHERE s IN ('c', 'a', 'b')", L"SELECT id FROM t WHERE s IN ('b', 'c', 'a')" },
+        { L"SELECT id FROM t WHERE n IN (2.5, 1.5, 99999999999999999999)", L"SELECT id FROM t WHERE n IN (99999999999999999999, 2.5, 1.5)" },
+        { L"SELECT CAST(a AS int4) FROM t WHERE a = a AND a = a", L"SELECT CAST(a AS integer) FROM t WHERE a = a" },
+        { L"SELECT a || (b || c) FROM t", L"SELECT (a || b) || c FROM t" },
+        { L"SELECT id FROM t WHERE EXISTS (SELECT 1 FROM U WHERE U.ID = T.ID AND U.X = 1)",
+          L"SELECT id FROM t WHERE EXISTS (SELECT 1 FROM u WHERE u.x = 1 AND t.id = u.id)" },
+    };
+    for (auto const& [a, b] : equivalent) {
+        ASSERT_EQ(canonical(a), canonical(b));
+        ASSERT_TRUE(same_hash(a, b));
+    }
+
+    // 意味が異なるものは区別する (順序に意味のある演算子、文字列リテラルの大文字小文字)
+    ASSERT_TRUE(!same_hash(L"SELECT a - b FROM t", L"SELECT b - a FROM t"));
+    ASSERT_TRUE(!same_hash(L"SELECT a || b FROM t", L"SELECT b || a FROM t"));
+    ASSERT_TRUE(!same_hash(L"SELECT a FROM t WHERE a < b", L"SELECT a FROM t WHERE b < a"));
+    ASSERT_TRUE(!same_hash(L"SELECT a FROM t WHERE s = 'X'", L"SELECT a FROM t WHERE s = 'x'"));
+    ASSERT_TRUE(!same_hash(L"SELECT a ^ b FROM t", L"SELECT b ^ a FROM t"));
+
+    // IN のリストはリテラルの詰めた表現でも values でも同じ順に並ぶ
+    for (const wchar_t* sql : { L"SELECT id FROM t WHERE x IN (3, 1, 2)", L"SELECT id FROM t WHERE s IN ('c', 'a', 'b')",
+                                L"SELECT id FROM t WHERE n IN (2.5, 1.5, 99999999999999999999)" }) {
+        sqlparser::ast::SelectStatement packed, expanded;
+        ASSERT_TRUE(sqlparser::parser::parse(sql, packed));
+        ASSERT_TRUE(sqlparser::parser::parse(sql, expanded));
+        auto& in = boost::get<sqlparser::ast::In>(*expanded.where);
+        ASSERT_TRUE(in.values.empty());
+        std::vector<sqlparser::ast::Expression> values;
+        for (size_t i = 0; i < in.size(); ++i) values.push_back(in.value_at(i));
+        in.values = std::move(values);
+        in.literals = {};
+        sqlparser::ast::canonicalize(packed);
+        sqlparser::ast::canonicalize(expanded);
+        ASSERT_EQ(sqlparser::generate(packed), sqlparser::generate(expanded));
+        ASSERT_TRUE(sqlparser::structural_equal(packed, expanded));
+    }
+
+    // 正規化は冪等
+    std::wstring once = canonical(L"SELECT Z + Y + X, b = a FROM T WHERE (q OR p) AND (n AND m)");
+    ASSERT_EQ(once, canonical(once));
+    ASSERT_EQ(std::wstring(L"SELECT id FROM t WHERE (a < 5)"), canonical(L"SELECT ID FROM T WHERE 5 > A"));
+    return true;
+}
+
+bool test_predicate_pushdown() {
+    auto pushed = [](const std::wstring& sql, size_t& count) {
+        sqlparser::ast::SelectStatement ast;
+        if (!sqlparser::parser::parse(sql, ast)) return std::wstring(L"<parse error>");
+        count = sqlparser::ast::push_down_predicates(ast);
+        return sqlparser::generate(ast);
+    };
+    size_t count = 0;
+    // 派生テーブルだけを参照する項は派生テーブルへ、結合先だけを参照する項は ON へ
+    ASSERT_EQ(std::wstring(L"SELECT s.id, t.y FROM (SELECT id, x FROM a WHERE (x = 5)) s INNER JOIN t ON ((t.id = s.id) AND (t.y > 3))"),
+              pushed(L"SELECT s.id, t.y FROM (SELECT id, x FROM a) s JOIN t ON t.id = s.id WHERE s.x = 5 AND t.y > 3", count));
+    ASSERT_EQ(count, 2u);
+    // 出力カラムのエイリアスは式に置き換える。集約する派生テーブルは HAVING へ
+    ASSERT_EQ(std::wstring(L"SELECT s.n FROM (SELECT a.id AS ident, UPPER(name) AS n FROM a WHERE (UPPER(name) = 'X')) s"),
+              pushed(L"SELECT s.n FROM (SELECT a.id AS ident, UPPER(name) AS n FROM a) s WHERE s.n = 'X'", count));
+    ASSERT_EQ(std::wstring(L"SELECT s.a FROM (SELECT a, COUNT(*) AS c FROM t GROUP BY a HAVING ((COUNT(*) > 1) AND (a = 2))) s"),
+              pushed(L"SELECT s.a FROM (SELECT a, COUNT(*) AS c FROM t GROUP BY a) s WHERE s.c > 1 AND s.a = 2", count));
+    // LEFT JOIN: 右側を参照する WHERE の項は残し、ON の右側だけの項は右側の派生テーブルへ
+    ASSERT_EQ(std::wstring(L"SELECT s.id FROM (SELECT id, x FROM a WHERE (x = 1)) s LEFT JOIN (SELECT id, k, v FROM b WHERE (k = 1)) r "
+                           L"ON (r.id = s.id) WHERE (r.v IS NULL)"),
+              pushed(L"SELECT s.id FROM (SELECT id, x FROM a) s LEFT JOIN (SELECT id, k, v FROM b) r ON r.id = s.id AND r.k = 1 "
+                     L"WHERE r.v IS NULL AND s.x = 1", count));
+    ASSERT_EQ(count, 2u);
+    // ON が空になった LEFT JOIN は ON TRUE
+    ASSERT_EQ(std::wstring(L"SELECT s.id FROM s LEFT JOIN (SELECT id FROM b WHERE (id = 1)) r ON TRUE"),
+              pushed(L"SELECT s.id FROM s LEFT JOIN (SELECT id FROM b) r ON r.id = 1", count));
+    // RIGHT / FULL JOIN で NULL に補われる側は移さない
+    const std::wstring right = L"SELECT s.id FROM (SELECT id, x FROM a) s RIGHT JOIN t ON (t.id = s.id) WHERE (s.x = 1)";
+    ASSERT_EQ(right, pushed(right, count));
+    ASSERT_EQ(count, 0u);
+    const std::wstring full = L"SELECT s.id FROM (SELECT id, x FROM a) s FULL JOIN t ON (t.id = s.id) WHERE ((s.x = 1) AND (t.y = 2))";
+    ASSERT_EQ(full, pushed(full, count));
+    ASSERT_EQ(count, 0u);
+    // 複数のテーブル参照にまたがる項は INNER / CROSS JOIN の ON へ (カンマ区切りの結合は ON を持てない)
+    ASSERT_EQ(std::wstring(L"SELECT a.id FROM a INNER JOIN b ON (a.id = b.id)"), pushed(L"SELECT a.id FROM a CROSS JOIN b WHERE a.id = b.id", count));
+    const std::wstring implicit = L"SELECT a.id FROM a, b WHERE (a.id = b.id)";
+    ASSERT_EQ(implicit, pushed(implicit, count));
+    // 移せない派生テーブル・項
+    for (const std::wstring sql : {
+             L"SELECT s.id FROM (SELECT id, x FROM a LIMIT 10) s WHERE (s.x = 1)",
+             L"SELECT s.id FROM (SELECT id, ROW_NUMBER() OVER (ORDER BY id) AS rn FROM a) s WHERE (s.rn = 1)",
+             L"SELECT s.r FROM (SELECT RANDOM() AS r FROM t) s WHERE (s.r > 0.5)",
+             L"SELECT s.id FROM (SELECT id FROM a UNION SELECT id FROM b) s WHERE (s.id = 1)",
+             L"SELECT s.id FROM (SELECT id FROM a) s WHERE (s.missing = 1)",
+             L"SELECT s.id FROM (SELECT id FROM a) s WHERE EXISTS (SELECT 1 FROM b WHERE (b.id = s.id))",
+             L"SELECT s.id FROM (SELECT id FROM a) s INNER JOIN t ON (s.id = t.id) WHERE (id = 1)",
+         }) {
+        ASSERT_EQ(sql, pushed(sql, count));
+        ASSERT_EQ(count, 0u);
+    }
+    // 内側の派生テーブルまで押し下げる (SELECT * は FROM のカラム)
+    ASSERT_EQ(std::wstring(L"SELECT s.x FROM (SELECT * FROM (SELECT id, x FROM t WHERE (x = 1)) i) s"),
+              pushed(L"SELECT s.x FROM (SELECT * FROM (SELECT id, x FROM t) i) s WHERE s.x = 1", count));
+    ASSERT_EQ(count, 2u);
+    return true;
+}
+
+bool test_decorrelate() {
+    auto rewritten = [](const std::wstring& sql, size_t& count, sqlparser::ast::DecorrelateOptions options = {}) {
+        sqlparser::ast::SelectStatement ast;
+        if (!sqlparser::parser::parse(sql, ast)) return std::wstring(L"<parse error>");
+        count = sqlparser::ast::decorrelate(ast, options);
+        return sqlparser::generate(ast);
+    };
+    size_t count = 0;
+    // EXISTS は重複を除いた派生テーブルとの INNER JOIN (準結合)
+    ASSERT_EQ(std::wstring(L"SELECT c.id FROM customers c INNER JOIN (SELECT DISTINCT o.cid AS __k1 FROM orders o WHERE (o.total > 100)) __exists1 "
+                           L"ON (__exists1.__k1 = c.id) WHERE (c.active = 1)"),
+              rewritten(L"SELECT c.id FROM customers c WHERE c.active = 1 AND EXISTS (SELECT 1 FROM orders o WHERE o.cid = c.id AND o.total > 100)", count));
+    ASSERT_EQ(count, 1u);
+    ASSERT_EQ(std::wstring(L"SELECT c.id FROM customers c INNER JOIN (SELECT DISTINCT o.cid AS __k1, o.region AS __k2 FROM orders o) __exists1 "
+                           L"ON ((__exists1.__k1 = c.id) AND (__exists1.__k2 = c.region))"),
+              rewritten(L"SELECT c.id FROM customers c WHERE EXISTS (SELECT * FROM orders o WHERE o.cid = c.id AND c.region = o.region)", count));
+    // NOT EXISTS は反結合。派生テーブルも展開されて LEFT JOIN ... IS NULL になる
+    ASSERT_EQ(std::wstring(L"SELECT c.id FROM customers c LEFT JOIN orders __exists1 ON ((__exists1.cid = c.id) AND (__exists1.status = 'open')) "
+                           L"WHERE (__exists1.cid IS NULL)"),
+              rewritten(L"SELECT c.id FROM customers c WHERE NOT EXISTS (SELECT 1 FROM orders o WHERE o.cid = c.id AND o.status = 'open')", count));
+    ASSERT_EQ(count, 2u);
+    // 外側に修飾子のないカラムがあると、展開した orders のカラムと曖昧になるため派生テーブルのまま残す
+    ASSERT_EQ(std::wstring(L"SELECT id FROM orders o LEFT JOIN (SELECT r.order_id AS __k1 FROM refunds r) __exists1 ON (__exists1.__k1 = o.id) "
+                           L"WHERE (__exists1.__k1 IS NULL)"),
+              rewritten(L"SELECT id FROM orders o WHERE NOT EXISTS (SELECT 1 FROM refunds r WHERE r.order_id = o.id)", count));
+    ASSERT_EQ(count, 1u);
+    // 対象の DB ごとに選ぶ
+    sqlparser::ast::DecorrelateOptions keep_exists;
+    keep_exists.exists_to_join = false;
+    keep_exists.not_exists_to_join = false;
+    const std::wstring correlated = L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o WHERE (o.cid = c.id))";
+    ASSERT_EQ(correlated, rewritten(correlated, count, keep_exists));
+    ASSERT_EQ(count, 0u);
+    // 結合にできない EXISTS
+    for (const std::wstring sql : {
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o WHERE ((o.cid = c.id) OR (o.x = 1)))",
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT COUNT(*) FROM orders o WHERE (o.cid = c.id))",
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o WHERE (o.total > c.credit))",
+             L"SELECT c.id FROM customers c WHERE ((c.a = 1) OR EXISTS (SELECT 1 FROM orders o WHERE (o.cid = c.id)))",
+             L"SELECT c.id FROM customers c, x WHERE EXISTS (SELECT 1 FROM orders o WHERE (o.cid = c.id))",
+             // 修飾子のないカラムは外側 (c.region / c.id) を指しているかもしれない
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o WHERE ((o.cust_id = c.id) AND (o.region = region)))",
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o WHERE (cust_id = c.id))",
+             L"SELECT c.id FROM customers c WHERE EXISTS (SELECT 1 FROM orders o INNER JOIN items i ON (i.oid = id) WHERE (o.cid = c.id))",
+         }) {
+        ASSERT_EQ(sql, rewritten(sql, count));
+        ASSERT_EQ(count, 0u);
+    }
+    // 派生テーブルの展開: 出力カラムの式を外側に置き換え、WHERE は外側の WHERE / 結合先の ON へ
+    ASSERT_EQ(std::wstring(L"SELECT s.id, UPPER(s.name) AS n FROM users s WHERE ((UPPER(s.name) = 'X') AND (s.active = 1))"),
+              rewritten(L"SELECT s.id, s.n FROM (SELECT id, UPPER(name) AS n FROM users u WHERE u.active = 1) s WHERE s.n = 'X'", count));
+    ASSERT_EQ(count, 1u);
+    ASSERT_EQ(std::wstring(L"SELECT t.id FROM t LEFT JOIN b r ON ((r.id = t.id) AND (r.k = 1))"),
+              rewritten(L"SELECT t.id FROM t LEFT JOIN (SELECT id, v FROM b WHERE k = 1) r ON r.id = t.id", count));
+    ASSERT_EQ(std::wstring(L"SELECT s.id FROM t s WHERE ((s.id < 5) AND (s.x > 1))"),
+              rewritten(L"SELECT s.id FROM (SELECT id FROM (SELECT id, x FROM t WHERE x > 1) i WHERE id < 5) s", count));
+    ASSERT_EQ(count, 2u);
+    // 修飾子のない参照でも、名前の変わらない出力カラムなら展開する
+    ASSERT_EQ(std::wstring(L"SELECT id FROM users s WHERE (s.active = 1)"),
+              rewritten(L"SELECT id FROM (SELECT id FROM users WHERE active = 1) s", count));
+    ASSERT_EQ(count, 1u);
+    // 展開できない派生テーブル
+    for (const std::wstring sql : {
+             L"SELECT * FROM (SELECT id FROM users) s",
+             L"SELECT name FROM u INNER JOIN (SELECT id FROM t) s ON (s.id = u.id)",
+             L"SELECT u.id FROM u WHERE ((u.a = 1) OR EXISTS (SELECT 1 FROM (SELECT id FROM t) s WHERE (s.id = code)))",
+             L"SELECT n FROM (SELECT UPPER(name) AS n FROM users) s",
+             L"SELECT s.n FROM (SELECT UPPER(name) AS n FROM users) s ORDER BY s.n",
+             L"SELECT s.id FROM (SELECT DISTINCT id FROM users) s",
+             L"SELECT t.id FROM t LEFT JOIN (SELECT id, COALESCE(v, 0) AS v0 FROM b) r ON (r.id = t.id)",
+             L"SELECT s.id FROM (SELECT id FROM users) s WHERE EXISTS (SELECT 1 FROM users s WHERE (s.id = 1))",
+         }) {
+        ASSERT_EQ(sql, rewritten(sql, count));
+        ASSERT_EQ(count, 0u);
+    }
+    return true;
+}
+
+// --- Symbol Interning Tests ---
+
+bool test_symbol_interning() {
+    sqlparser::Symbol a(L"users");
+    sqlparser::Symbol b(std::wstring(L"users"));
+    sqlparser::Symbol c(L"orders");
+    ASSERT_TRUE(a == b);
+    ASSERT_TRUE(a.id() == b.id());
+    ASSERT_TRUE(a != c);
+    ASSERT_TRUE(std::hash<sqlparser::Symbol>()(a) == std::hash<sqlparser::Symbol>()(b));
+    ASSERT_EQ(std::wstring(L"users"), a.str());
+    ASSERT_TRUE(sqlparser::Symbol().empty());
+    return true;
+}
+
+bool test_identifier_roundtrip() {
+    // 識別子の型 (String / Symbol) に関わらず元の綴りで再生成される
+    std::wstring sql = L"SELECT u.Name AS n, COUNT(*) FROM Users u ORDER BY n DESC";
+    sqlparser::ast::SelectStatement ast;
+    ASSERT_TRUE(sqlparser::parser::parse(sql, ast));
+    auto* t = boost::get<sqlparser::ast::Table>(&ast.table);
+    ASSERT_TRUE(t != nullptr);
+    ASSERT_TRUE(t->name == L"Users");
+    ASSERT_TRUE(*t->alias == L"u");
+    ASSERT_EQ(sql, sqlparser::generate(ast));
+    return true;
+}
+
+// --- SmallString Tests ---
+
+bool test_small_string() {
+    sqlparser::SmallString short_name(L"user_id");
+    sqlparser::SmallString long_name(L"a_very_long_identifier_that_needs_the_heap");
+    ASSERT_TRUE(short_name.is_inline());
+    // 22 文字程度の識別子もインラインに収まる
+    ASSERT_TRUE(sqlparser::SmallString(L"total_amount_with_taxes").is_inline());
+    ASSERT_TRUE(!long_name.is_inline());
+    // inline_capacity 文字ちょうどでも終端の L'\0' を持つ
+    std::wstring full(sqlparser::SmallString::inline_capacity, L'x');
+    sqlparser::SmallString full_name(full);
+    ASSERT_TRUE(full_name.is_inline());
+    ASSERT_TRUE(full_name.size() == full.size());
+    ASSERT_TRUE(full_name.c_str()[full.size()] == L'\0');
+    ASSERT_TRUE(!sqlparser::SmallString(full + L"x").is_inline());
+    ASSERT_TRUE(sqlparser::SmallString().empty());
+    ASSERT_TRUE(short_name == L"user_id");
+    ASSERT_EQ(std::wstring(L"a_very_long_identifier_that_needs_the_heap"), long_name.str());
+
+    sqlparser::SmallString copy = long_name;
+    sqlparser::SmallString moved = std::move(copy);
+    ASSERT_TRUE(moved == long_name);
+    ASSERT_TRUE(copy.empty());
+
+    moved.swap(short_name);
+    ASSERT_TRUE(moved == L"user_id");
+    ASSERT_TRUE(short_name == long_name);
+    ASSERT_TRUE(std::hash<sqlparser::SmallString>()(short_name) == std::hash<sqlparser::SmallString>()(long_name));
+    return true;
+}
+
 int main() {
     run_test("Basic Select", test_basic_select);
     run_test("Select Columns", test_select_columns);
@@ -385,6 +1633,36 @@ int main() {
     run_test("EXISTS With Subquery Condition", test_exists_with_subquery_condition);
     run_test("NOT EXISTS With AND", test_not_exists_with_and);
     run_test("NOT EXISTS Original SQL", test_not_exists_original_sql);
+    run_test("Lazy FROM Only", test_lazy_from_only);
+    run_test("Lazy Materialize", test_lazy_materialize);
+    run_test("Extract Tables Joins", test_extract_tables_joins);
+    run_test("Extract Tables Subqueries", test_extract_tables_subqueries);
+    run_test("Collect Columns Aliases", test_collect_columns_aliases);
+    run_test("Collect Columns Subquery Scopes", test_collect_columns_subquery_scopes);
+    run_test("Join Chain", test_join_chain);
+    run_test("Join Cross Natural Using", test_join_cross_natural_using);
+    run_test("Implicit Join", test_implicit_join);
+    run_test("Comments", test_comments);
+    run_test("In Literal List", test_in_literal_list);
+    run_test("Numeric Literal Text", test_numeric_literal_text);
+    run_test("String Literal Views", test_string_literal_views);
+    run_test("Logical Op Flatten", test_logical_op_flatten);
+    run_test("Cast Type Catalog", test_cast_type_catalog);
+    run_test("Structural Compare", test_structural_compare);
+    run_test("Shared Subexpressions", test_shared_subexpressions);
+    run_test("Persistent Select", test_persistent_select);
+    run_test("AST Walk", test_ast_walk);
+    run_test("Predicate Injection", test_predicate_injection);
+    run_test("Row Security Policy", test_row_security_policy);
+    run_test("SQL Template", test_sql_template);
+    run_test("Rewrite Rules", test_rewrite_rules);
+    run_test("Simplify", test_simplify);
+    run_test("Canonicalize", test_canonicalize);
+    run_test("Predicate Pushdown", test_predicate_pushdown);
+    run_test("Decorrelate", test_decorrelate);
+    run_test("Symbol Interning", test_symbol_interning);
+    run_test("Identifier Roundtrip", test_identifier_roundtrip);
+    run_test("Small String", test_small_string);
 
     std::cout << "\nSummary: " << g_tests_passed << " passed, " << g_tests_failed << " failed." << std::endl;
     return g_tests_failed == 0 ? 0 : 1;